@@ -0,0 +1,82 @@
+#ifndef BBR_CONTROLLER_H
+#define BBR_CONTROLLER_H
+
+#include "CongestionController.h"
+#include <deque>
+#include <utility>
+
+// BBR v1：不以丢包为拥塞信号，而是估计瓶颈带宽（最近10轮投递速率的最大值）
+// 和最小 RTT，按二者之积（BDP）设定窗口，并按带宽乘增益给出发送速率
+class BbrController : public CongestionController {
+public:
+    enum class Mode {
+        STARTUP,     // 带宽指数探测
+        DRAIN,       // 排空启动阶段堆积的队列
+        PROBE_BW,    // 按增益周期轮流探测与让出带宽
+        PROBE_RTT    // 定期收缩窗口以重新测量最小 RTT
+    };
+
+    explicit BbrController(uint32_t mss = DEFAULT_MSS);
+
+    void onAck(const AckEvent& event) override;
+    void onLoss(const LossEvent& event) override;
+    uint64_t getCongestionWindow() const override;
+    uint64_t getPacingRate() const override;
+    void reset() override;
+    const char* name() const override { return "bbr"; }
+
+    Mode getMode() const { return mode; }
+    uint64_t getBottleneckBandwidth() const { return static_cast<uint64_t>(btlBw); }
+    uint32_t getMinRtt() const { return minRttMicros; }
+
+private:
+    static constexpr double HIGH_GAIN = 2.885;       // 2/ln2
+    static constexpr uint64_t BW_WINDOW_ROUNDS = 10;
+    static constexpr int64_t MIN_RTT_WINDOW_MICROS = 10 * 1000 * 1000;
+    static constexpr int64_t PROBE_RTT_MICROS = 200 * 1000;
+    static constexpr uint64_t INITIAL_WINDOW = 10;
+    static constexpr uint64_t MIN_WINDOW = 4;
+
+    uint32_t mss;
+    Mode mode;
+
+    // 瓶颈带宽的窗口最大值滤波：(轮次, 字节/秒) 的单调递减队列
+    std::deque<std::pair<uint64_t, double>> bwSamples;
+    double btlBw;
+    uint32_t minRttMicros;
+    int64_t minRttStamp;
+
+    // 轮次：发出时已投递的数据全部被确认即为一轮
+    uint64_t delivered;
+    uint64_t roundCount;
+    uint64_t nextRoundDelivered;
+    uint64_t roundStartDelivered;
+    int64_t roundStartTime;
+    bool roundStart;
+
+    // 启动阶段是否已填满管道：带宽连续3轮增长不足25%
+    double fullBw;
+    int fullBwCount;
+    bool filledPipe;
+
+    double pacingGain;
+    double cwndGain;
+    size_t cycleIndex;
+    int64_t cycleStamp;
+
+    int64_t probeRttDoneStamp;
+    bool probeRttRoundDone;
+
+    uint64_t cwnd;
+    uint64_t priorCwnd;
+
+    void updateRound(const AckEvent& event);
+    void updateBandwidth(double sample);
+    void checkFullPipe();
+    void updateMode(const AckEvent& event, bool minRttExpired);
+    void updateCongestionWindow(const AckEvent& event);
+    void enterProbeBw(int64_t now);
+    double bdp() const;
+};
+
+#endif // BBR_CONTROLLER_H
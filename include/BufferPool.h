@@ -0,0 +1,98 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class BufferPool;
+
+// 池化缓冲区的句柄：拷贝只增加引用计数，最后一个句柄释放时缓冲区回到所属的池
+// 多个句柄共享同一块内容，修改前应确认 unique()
+class Buffer {
+public:
+    Buffer() = default;
+    Buffer(const Buffer& other);
+    Buffer(Buffer&& other) noexcept;
+    Buffer& operator=(const Buffer& other);
+    Buffer& operator=(Buffer&& other) noexcept;
+    ~Buffer();
+
+    uint8_t* data();
+    const uint8_t* data() const;
+    size_t size() const;
+    size_t capacity() const;
+    bool empty() const;
+    bool unique() const;
+
+    // 是否持有缓冲区（空消息也持有一块容量不为 0 的缓冲区）
+    explicit operator bool() const;
+
+    // 调整有效长度，不能超过容量
+    void resize(size_t size);
+
+    // 拷贝出内容（会分配内存）
+    std::string toString() const;
+
+    // 释放句柄
+    void reset();
+
+private:
+    friend class BufferPool;
+    struct Block;
+
+    explicit Buffer(Block* block);
+
+    Block* block_ = nullptr;
+};
+
+// 按 2 的幂分级的缓冲区池
+// 释放的缓冲区挂回对应级别的空闲表，下次申请同级别时直接复用，稳定状态下不再向系统申请内存；
+// 超过最大级别的缓冲区用完即释放，池中缓存的总字节数也有上限。
+// 线程安全，缓冲区可以在任意线程释放；池本身在最后一个缓冲区释放后才销毁
+class BufferPool : public std::enable_shared_from_this<BufferPool> {
+public:
+    static constexpr size_t MIN_BLOCK_SIZE = 256;
+    static constexpr size_t MAX_BLOCK_SIZE = 16 * 1024 * 1024;
+    static constexpr size_t DEFAULT_MAX_CACHED_BYTES = 64 * 1024 * 1024;
+
+    static std::shared_ptr<BufferPool> create(size_t maxCachedBytes = DEFAULT_MAX_CACHED_BYTES);
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // 申请容量至少为 capacity 的缓冲区，有效长度为 0
+    Buffer acquire(size_t capacity);
+
+    // 申请缓冲区并拷入 length 字节
+    Buffer copyOf(const void* data, size_t length);
+
+    // 空闲表中缓存的字节数
+    size_t cachedBytes() const;
+
+private:
+    friend class Buffer;
+
+    // MIN_BLOCK_SIZE << i, i = 0 .. CLASS_COUNT - 1
+    static constexpr size_t CLASS_COUNT = 17;
+    static constexpr uint32_t UNPOOLED = UINT32_MAX;
+
+    explicit BufferPool(size_t maxCachedBytes);
+
+    static uint32_t sizeClassFor(size_t capacity);
+    static void destroy(Buffer::Block* block);
+
+    void recycle(Buffer::Block* block);
+
+    size_t maxCachedBytes;
+    mutable std::mutex mutex;
+    std::array<std::vector<Buffer::Block*>, CLASS_COUNT> freeLists;
+    size_t cached;
+};
+
+#endif // BUFFER_POOL_H
@@ -0,0 +1,66 @@
+#ifndef CHUNK_SIZE_TUNER_H
+#define CHUNK_SIZE_TUNER_H
+
+#include "TcpChunkOptimization.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// 根据实际发送情况在线估计网络质量，驱动 TcpChunkOptimization::adjustChunkSize
+// 每个采样周期统计写出的字节数、阻塞在发送缓冲区上的时间和 RTT：
+// 带宽时延积（近期最大发送速率 × 最小 RTT）越大，质量越高；RTT 相对最小值的膨胀说明瓶颈处在排队，
+// 按比例压低质量。发送阻塞过的周期才作为路径容量的样本，应用发得少的周期不会拉低带宽估计。
+// 估计值经过指数平滑，且只有变化超过滞回阈值时才调整分块大小，分块大小不会在两个值之间来回抖动
+class ChunkSizeTuner {
+public:
+    static constexpr int64_t DEFAULT_INTERVAL_MICROS = 100000;
+
+    explicit ChunkSizeTuner(int64_t intervalMicros = DEFAULT_INTERVAL_MICROS);
+
+    // 一次写出成功，bytes 为写入内核的字节数；之前若处于阻塞状态，阻塞到此结束
+    void onSent(size_t bytes, int64_t nowMicros);
+
+    // 写出遇到发送缓冲区已满，到下一次成功写出之间计为阻塞
+    void onBlocked(int64_t nowMicros);
+
+    // 内核给出的平滑 RTT；后端不提供时只能按发送阻塞的时间占比估计
+    void onRtt(uint32_t rttMicros);
+
+    // 采样周期结束时更新估计，质量变化超过滞回阈值时调整 chunker 的分块大小并返回 true
+    bool update(TcpChunkOptimization& chunker, int64_t nowMicros);
+
+    // 平滑后的网络质量（0-1），尚无估计时返回 -1
+    double getQuality() const;
+
+    void reset();
+
+private:
+    // 带宽时延积达到该值时视为质量满分
+    static constexpr double FULL_QUALITY_BDP = 256 * 1024;
+    // 同机房或本机的 RTT 极小，带宽时延积反映不出分块的开销，至少按该时长的数据量计算；
+    // 低于该值的 RTT 膨胀也不视为排队
+    static constexpr uint32_t MIN_RTT_FLOOR_MICROS = 1000;
+    // 指数平滑的增益
+    static constexpr double SMOOTHING = 0.25;
+    // 已生效的质量与当前估计相差超过该值才调整分块大小
+    static constexpr double HYSTERESIS = 0.1;
+    // 最大发送速率取最近若干个容量样本
+    static constexpr size_t RATE_WINDOW = 10;
+
+    int64_t interval;
+    int64_t intervalStart;
+    uint64_t intervalBytes;
+    int64_t blockedMicros;
+    int64_t blockedSince;   // < 0 表示当前没有阻塞
+
+    std::array<double, RATE_WINDOW> rates;   // 各周期的发送速率（字节/秒）
+    size_t rateIndex;
+
+    uint32_t latestRtt;
+    uint32_t minRtt;
+
+    double quality;
+    double appliedQuality;
+};
+
+#endif // CHUNK_SIZE_TUNER_H
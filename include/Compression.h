@@ -0,0 +1,79 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+
+// LZ4 块格式的压缩与解压
+// 构建时找到 liblz4（定义了 HAVE_LZ4）就使用它，否则使用内置的实现；两者产生同一种格式，可以互相解压，
+// 两端是否链接 liblz4 不影响互通，库本身不依赖任何压缩库
+class Lz4Codec {
+public:
+    // 最坏情况（完全不可压缩）下的输出长度
+    static size_t compressBound(size_t length);
+
+    // 压缩到 out，输出超过 capacity 时放弃并返回 0；调用方可以用较小的 capacity 要求最低压缩率
+    static size_t compress(const uint8_t* in, size_t length, uint8_t* out, size_t capacity);
+
+    // 解压出恰好 rawLength 字节，数据损坏或长度不符时返回 false
+    static bool decompress(const uint8_t* in, size_t length, uint8_t* out, size_t rawLength);
+
+    // 是否使用 liblz4
+    static bool isLibraryAvailable();
+};
+
+// 按分块压缩的发送方决策，以及压缩分块的负载格式：
+// | codec(1) | rawLength(4，网络字节序) | 压缩数据 |
+// 压缩后节省不到 minSavings 的分块原样发送；连续遇到不可压缩的分块时进入旁路，旁路期间只抽样压缩
+// 少量分块（间隔按 1、2、4… 倍增长到 maxBypass），抽样变得可压缩时立即恢复。
+// 已经压缩过的数据（图片、压缩包、加密数据）因此几乎不消耗 CPU，而 JSON、日志这类负载总是压缩发送。
+// 非线程安全，由所属连接在持锁时调用
+class ChunkCompressor {
+public:
+    static constexpr size_t PREFIX_SIZE = 5;
+    static constexpr uint8_t CODEC_LZ4 = 1;
+
+    struct Config {
+        size_t minChunkSize = 512;      // 更小的分块压缩收益有限，直接发送
+        double minSavings = 0.125;      // 至少节省该比例（含前缀）才按压缩发送
+        uint32_t maxBypass = 64;        // 旁路期间抽样间隔的上限（分块数）
+    };
+
+    struct Stats {
+        uint64_t attempts = 0;          // 尝试压缩的分块数
+        uint64_t compressed = 0;        // 按压缩发送的分块数
+        uint64_t bypassed = 0;          // 因旁路跳过的分块数
+        uint64_t rawBytes = 0;          // 按压缩发送的分块压缩前后的总字节数
+        uint64_t compressedBytes = 0;
+    };
+
+    ChunkCompressor();
+    explicit ChunkCompressor(const Config& config);
+
+    void setConfig(const Config& config);
+    const Config& getConfig() const;
+
+    // 需要为一个 length 字节的分块准备的输出空间
+    static size_t outputCapacity(size_t length);
+
+    // 压缩一个分块，输出（含前缀）写入 out，返回负载长度；不值得压缩时返回 0，调用方应原样发送该分块
+    size_t compress(const uint8_t* chunk, size_t length, uint8_t* out, size_t capacity);
+
+    // 解析压缩负载的前缀，得到解压后的长度；前缀无效或编码不支持时返回 false
+    static bool rawLength(const uint8_t* payload, size_t length, size_t& rawLength);
+
+    // 把压缩负载解压到 out（恰好 rawLength 字节，由 rawLength() 得到）
+    static bool decompress(const uint8_t* payload, size_t length, uint8_t* out, size_t rawLength);
+
+    const Stats& getStats() const;
+
+    void reset();
+
+private:
+    Config config;
+    Stats stats;
+    uint32_t bypassSpan;        // 当前的抽样间隔，0 表示不在旁路中
+    uint32_t bypassRemaining;   // 旁路中还要跳过的分块数
+};
+
+#endif // COMPRESSION_H
@@ -0,0 +1,56 @@
+#ifndef CONGESTION_CONTROLLER_H
+#define CONGESTION_CONTROLLER_H
+
+#include <cstdint>
+#include <memory>
+
+// 可插拔的拥塞控制器接口
+// 控制器按确认/丢包事件更新状态，窗口以字节计；每个连接持有独立的实例
+class CongestionController {
+public:
+    enum class Type {
+        RENO,
+        CUBIC,
+        BBR
+    };
+
+    static constexpr uint32_t DEFAULT_MSS = 1460;
+
+    // 一次确认：新确认的字节数及可选的 RTT/投递速率采样
+    struct AckEvent {
+        uint64_t bytesAcked;
+        uint64_t bytesInFlight;
+        uint32_t rttMicros;       // 本次 RTT 采样，0 表示没有采样
+        uint64_t deliveryRate;    // 传输层测得的投递速率（字节/秒），0 表示由控制器自行估计
+        int64_t timestampMicros;  // 单调时钟
+    };
+
+    // 一次拥塞事件（快速重传或超时）
+    struct LossEvent {
+        uint64_t bytesLost;
+        uint64_t bytesInFlight;
+        bool timeout;
+        int64_t timestampMicros;
+    };
+
+    virtual ~CongestionController() = default;
+
+    virtual void onAck(const AckEvent& event) = 0;
+    virtual void onLoss(const LossEvent& event) = 0;
+
+    // 拥塞窗口（字节）
+    virtual uint64_t getCongestionWindow() const = 0;
+
+    // 建议的发送速率（字节/秒），0 表示不限速、只受窗口约束
+    virtual uint64_t getPacingRate() const { return 0; }
+
+    // 慢启动阈值（字节），0 表示控制器没有这一概念（如 BBR）或尚未发生拥塞事件
+    virtual uint64_t getSlowStartThreshold() const { return 0; }
+
+    virtual void reset() = 0;
+    virtual const char* name() const = 0;
+
+    static std::unique_ptr<CongestionController> create(Type type, uint32_t mss = DEFAULT_MSS);
+};
+
+#endif // CONGESTION_CONTROLLER_H
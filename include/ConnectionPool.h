@@ -0,0 +1,100 @@
+#ifndef CONNECTION_POOL_H
+#define CONNECTION_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include "LoadBalancer.h"
+#include "Protocol.h"
+#include "SocketBackend.h"
+
+// 按负载均衡节点划分的长连接池
+// 借用时先由 LoadBalancer 的策略选出节点并持有租约，再取该节点上已建立的空闲连接，省去每次请求的握手；
+// 后台维护线程把每个活跃节点预热到 minIdle，回收空闲过久的连接，并剔除对端已关闭的连接
+class ConnectionPool {
+public:
+    struct Config {
+        size_t minIdle = 1;                   // 每个活跃节点保持的空闲连接数，addNode 后立即预热
+        size_t maxIdle = 8;                   // 归还时该节点的空闲连接已达上限则直接关闭
+        int64_t idleTimeoutMs = 60000;        // 空闲超过该时长的连接被回收（保留 minIdle 个）
+        int connectTimeoutMs = 3000;
+        int64_t maintenanceIntervalMs = 1000;
+    };
+
+private:
+    struct State;
+
+public:
+    // 借出的连接：析构或 release() 时归还到池中，连接已失效或调用过 invalidate() 则直接关闭
+    // 借用期间持有节点租约，LEAST_CONNECTIONS/POWER_OF_TWO_CHOICES/PEAK_EWMA 据此统计在途请求
+    class Connection {
+    public:
+        Connection() = default;
+        ~Connection();
+
+        Connection(Connection&& other) noexcept = default;
+        Connection& operator=(Connection&& other) noexcept;
+        Connection(const Connection&) = delete;
+        Connection& operator=(const Connection&) = delete;
+
+        Protocol* operator->() const { return protocol_.get(); }
+        Protocol& operator*() const { return *protocol_; }
+        explicit operator bool() const { return protocol_ != nullptr; }
+
+        const std::string& address() const { return lease_.address(); }
+        uint16_t port() const { return lease_.port(); }
+
+        // 请求中途出错、连接上的数据流状态不确定时调用，归还时关闭而不放回池中
+        void invalidate();
+
+        // 反馈请求耗时，见 LoadBalancer::Lease::reportLatency
+        void reportLatency(uint64_t latencyMicros) { lease_.reportLatency(latencyMicros); }
+
+        void release();
+
+    private:
+        friend class ConnectionPool;
+        Connection(std::weak_ptr<State> state, LoadBalancer::Lease lease, std::unique_ptr<Protocol> protocol);
+
+        std::weak_ptr<State> state_;
+        LoadBalancer::Lease lease_;
+        std::unique_ptr<Protocol> protocol_;
+        bool reusable_ = true;
+    };
+
+    // balancer 的生命周期必须长于连接池
+    explicit ConnectionPool(LoadBalancer& balancer);
+    ConnectionPool(LoadBalancer& balancer, const Config& config, std::shared_ptr<SocketBackend> backend = nullptr);
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // 按负载均衡策略借一条连接，所选节点没有可用的空闲连接时当场建立；
+    // 连续几次都连接失败时抛出 std::runtime_error
+    Connection acquire();
+    Connection acquire(const std::string& key);
+
+    // 空闲连接数（全部节点 / 指定节点）
+    size_t idleCount() const;
+    size_t idleCount(const std::string& address, uint16_t port) const;
+
+private:
+    // 一次 acquire 最多尝试的节点数
+    static constexpr int MAX_ACQUIRE_ATTEMPTS = 3;
+    // 维护线程一轮预热时并行建立连接的线程数
+    static constexpr size_t MAX_WARMUP_THREADS = 8;
+
+    LoadBalancer& balancer;
+    std::shared_ptr<State> state;
+    size_t listenerId;
+    std::thread maintenanceThread;
+
+    Connection acquireFrom(LoadBalancer::Lease lease);
+    void maintenanceLoop();
+    void maintain();
+};
+
+#endif // CONNECTION_POOL_H
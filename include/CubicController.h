@@ -0,0 +1,38 @@
+#ifndef CUBIC_CONTROLLER_H
+#define CUBIC_CONTROLLER_H
+
+#include "CongestionController.h"
+
+// CUBIC（RFC 9438）：拥塞避免阶段的窗口是距上次拥塞事件时间的三次函数，
+// 增长与 RTT 无关，在高带宽时延积链路上比 Reno 更快地回到并越过 W_max
+class CubicController : public CongestionController {
+public:
+    explicit CubicController(uint32_t mss = DEFAULT_MSS);
+
+    void onAck(const AckEvent& event) override;
+    void onLoss(const LossEvent& event) override;
+    uint64_t getCongestionWindow() const override;
+    uint64_t getSlowStartThreshold() const override;
+    void reset() override;
+    const char* name() const override { return "cubic"; }
+
+private:
+    static constexpr double C = 0.4;
+    static constexpr double BETA = 0.7;
+    static constexpr double INITIAL_WINDOW = 10;
+    static constexpr double MIN_WINDOW = 2;
+
+    uint32_t mss;
+    double cwnd;              // 以 MSS 计，允许小数以便逐个 ACK 增长
+    double ssthresh;
+    double wMax;              // 上次拥塞事件前的窗口
+    double k;                 // 三次函数回到 W_max 所需的时间（秒）
+    double originPoint;
+    double wEst;              // 按 Reno 速率增长的估计窗口，保证不比 Reno 慢
+    int64_t epochStart;       // 本轮拥塞避免开始时刻，-1 表示尚未开始
+    uint32_t minRttMicros;
+    uint32_t lastRttMicros;
+    int64_t recoveryUntil;    // 此前发生的丢包属于同一个拥塞事件
+};
+
+#endif // CUBIC_CONTROLLER_H
@@ -0,0 +1,25 @@
+#ifndef EPOLL_BACKEND_H
+#define EPOLL_BACKEND_H
+
+#include "SocketBackend.h"
+#include "EventLoop.h"
+#include <memory>
+
+// Linux 后端：非阻塞套接字 + 边缘触发 epoll
+// 同一个 EventLoop 线程为所有连接分发就绪事件，调用线程只在条件变量上等待
+class EpollBackend : public SocketBackend {
+public:
+    // loop 为空时使用 EventLoop::getShared()
+    explicit EpollBackend(std::shared_ptr<EventLoop> loop = nullptr);
+
+    std::unique_ptr<TransportSocket> createSocket() override;
+    const char* name() const override;
+    bool runAfter(int64_t delayMicros, std::function<void()> task) override;
+
+    std::shared_ptr<EventLoop> getLoop() const;
+
+private:
+    std::shared_ptr<EventLoop> loop;
+};
+
+#endif // EPOLL_BACKEND_H
@@ -0,0 +1,82 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include "TimerWheel.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// 基于 epoll 的反应器（仅 Linux）
+// 一个线程驱动任意多个文件描述符，回调总是在循环线程中执行
+// 定时器由一个 timerfd 驱动的时间轮管理，所有连接共享
+class EventLoop {
+public:
+    using EventCallback = std::function<void(uint32_t events)>;
+    using Task = std::function<void()>;
+    using TimerId = TimerWheel::TimerId;
+
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // 在后台线程中运行事件循环
+    void start();
+
+    // 在当前线程中运行事件循环，直到 stop() 被调用
+    void run();
+
+    void stop();
+
+    // 注册/修改/注销文件描述符，events 为 EPOLLIN、EPOLLOUT、EPOLLET 等的组合
+    bool addFd(int fd, uint32_t events, EventCallback callback);
+    bool modifyFd(int fd, uint32_t events);
+    void removeFd(int fd);
+
+    // 将任务投递到循环线程执行
+    void queueInLoop(Task task);
+
+    // 在 delayMicros 微秒后于循环线程中执行任务，可从任意线程调用，精度为时间轮的一个刻度
+    TimerId runAfter(int64_t delayMicros, Task task);
+
+    // 取消定时器；已经到期的任务可能仍会执行
+    void cancelTimer(TimerId id);
+
+    bool isInLoopThread() const;
+
+    // 进程内共享的默认反应器，首次调用时启动
+    static std::shared_ptr<EventLoop> getShared();
+
+private:
+    int epollFd;
+    int wakeupFd;
+    int timerFd;
+    std::atomic<bool> running;
+    std::thread loopThread;
+    std::atomic<std::thread::id> loopThreadId;
+
+    std::mutex mutex;
+    std::unordered_map<int, std::shared_ptr<EventCallback>> handlers;
+    std::vector<Task> pendingTasks;
+
+    // 只在循环线程中访问
+    std::vector<Task> runningTasks;
+    TimerWheel timers;
+    int64_t timerDeadline;   // timerfd 当前设置的到期时刻（微秒），0 表示未设置
+    std::atomic<uint64_t> nextTimerId;
+
+    void runLoop();
+    void wakeup();
+    void runPendingTasks();
+    void addTimer(TimerId id, int64_t submittedMicros, int64_t delayMicros, Task task);
+    void handleTimer();
+    void armTimer(int64_t deadlineMicros);
+};
+
+#endif // EVENT_LOOP_H
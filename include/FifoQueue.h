@@ -0,0 +1,65 @@
+#ifndef FIFO_QUEUE_H
+#define FIFO_QUEUE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// 先进先出队列，元素存放在连续的环形存储中（容量为2的幂）
+// 出队不释放存储，容量只在放不下时翻倍，稳定状态下入队出队都不分配内存；
+// std::deque 每跨过一个存储块就要分配/释放一次。出队的元素被替换为默认值，持有的资源随即释放。
+// 入队可能使已有元素的引用失效
+template <typename T>
+class FifoQueue {
+public:
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+    T& front() { return slots[head]; }
+    const T& front() const { return slots[head]; }
+    T& back() { return (*this)[count - 1]; }
+
+    T& operator[](size_t index) { return slots[(head + index) & (slots.size() - 1)]; }
+    const T& operator[](size_t index) const { return slots[(head + index) & (slots.size() - 1)]; }
+
+    void push_back(T value) {
+        if (count == slots.size()) {
+            grow();
+        }
+        slots[(head + count) & (slots.size() - 1)] = std::move(value);
+        count++;
+    }
+
+    void pop_front() {
+        slots[head] = T();
+        head = (head + 1) & (slots.size() - 1);
+        count--;
+    }
+
+    // 清空但保留存储
+    void clear() {
+        while (count > 0) {
+            pop_front();
+        }
+        head = 0;
+    }
+
+private:
+    static constexpr size_t MIN_CAPACITY = 8;
+
+    std::vector<T> slots;
+    size_t head = 0;
+    size_t count = 0;
+
+    void grow() {
+        std::vector<T> larger(std::max(slots.size() * 2, MIN_CAPACITY));
+        for (size_t i = 0; i < count; i++) {
+            larger[i] = std::move((*this)[i]);
+        }
+        slots.swap(larger);
+        head = 0;
+    }
+};
+
+#endif // FIFO_QUEUE_H
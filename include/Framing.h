@@ -0,0 +1,96 @@
+#ifndef FRAMING_H
+#define FRAMING_H
+
+#include "BufferPool.h"
+#include "FifoQueue.h"
+#include "RingBuffer.h"
+#include "SocketBackend.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+// 帧头（12字节，网络字节序）
+// | length(4) | flags(2) | streamId(2) | checksum(4) |
+// checksum 为负载的 CRC32C
+// 每个数据块是一帧，消息的最后一帧带 FLAG_END_OF_MESSAGE；
+// 带 FLAG_COMPRESSED 的帧负载是压缩后的分块（格式见 ChunkCompressor），length 与 checksum 都按压缩后的负载计算
+// 一个连接上可以有多个逻辑流，不同流的帧可以交错，同一流的帧按顺序到达；不使用多路复用时流编号为 0
+struct FrameHeader {
+    static constexpr size_t SIZE = 12;
+    static constexpr uint32_t MAX_PAYLOAD = 16 * 1024 * 1024;
+
+    static constexpr uint16_t FLAG_END_OF_MESSAGE = 0x0001;
+    static constexpr uint16_t FLAG_COMPRESSED = 0x0002;
+
+    uint32_t length;
+    uint16_t flags;
+    uint16_t streamId;
+    uint32_t checksum;
+
+    void encode(uint8_t* out) const;
+    static FrameHeader decode(const uint8_t* in);
+
+    // 为一块负载生成帧头（计算校验和）
+    static FrameHeader forPayload(const uint8_t* payload, size_t length, uint16_t flags, uint16_t streamId = 0);
+};
+
+// 按连接维护的帧解析器
+// 接收的数据先进入环形缓冲区，一次 recv 可以解析出多条完整消息；
+// 大帧的剩余负载直接读入消息缓冲区，不经过环形缓冲区
+// 每个流各自重组消息，完成的消息按流排队；消息缓冲区取自缓冲区池，交给上层时不再拷贝。
+// 压缩帧的负载先收进一块复用的池化缓冲区，校验通过后直接解压到消息缓冲区中
+class FrameDecoder {
+public:
+    // 剩余负载不小于该值时直接读入消息缓冲区
+    static constexpr size_t DIRECT_READ_THRESHOLD = 16 * 1024;
+    // 单条消息（重组后、解压后）的默认上限；MAX_PAYLOAD 只限制单帧，不带结束标志的帧可以无限续接
+    static constexpr size_t DEFAULT_MAX_MESSAGE_SIZE = 256 * 1024 * 1024;
+    // 同时处于重组中（已收到帧但未收到结束帧）的流数默认上限
+    static constexpr size_t DEFAULT_MAX_PARTIAL_STREAMS = 1024;
+
+    // pool 为空时使用解析器自己的缓冲区池
+    explicit FrameDecoder(size_t ringCapacity = 64 * 1024, std::shared_ptr<BufferPool> pool = nullptr);
+
+    // 设置重组上限，超出时 commitRead 返回 false，防止对端用不结束的消息耗尽内存
+    void setLimits(size_t maxMessageSize, size_t maxPartialStreams);
+
+    // 准备下一次读取的缓冲区段，返回段数（最多3段）
+    size_t prepareRead(TransportSocket::IoVec* vecs, size_t maxVecs);
+
+    // 提交实际读到的字节数并解析，数据损坏时返回 false
+    bool commitRead(size_t bytes);
+
+    bool hasMessage(uint16_t streamId) const;
+    // 取出该流上最早完成的消息，没有时返回空句柄
+    Buffer popMessage(uint16_t streamId);
+
+    void reset();
+
+private:
+    RingBuffer ring;
+    FrameHeader current;
+    bool headerParsed;
+    size_t frameStart;        // 当前帧负载在所属流的消息缓冲区中的起始位置
+    size_t payloadReceived;
+    uint32_t payloadCrc;      // 已收到负载的增量 CRC32C
+    size_t directReadLength;  // 上一次 prepareRead 交出的直接读取区域
+    std::shared_ptr<BufferPool> pool;
+    Buffer* assembling;       // 当前帧所属流的消息缓冲区，指向 partial 中的元素
+    // 流的表项在连接存续期间保留，稳定状态下收发消息不再插入新的表项
+    std::unordered_map<uint16_t, Buffer> partial;
+    std::unordered_map<uint16_t, FifoQueue<Buffer>> ready;
+    Buffer compressedPayload; // 当前压缩帧的负载
+    size_t maxMessageSize;
+    size_t maxPartialStreams;
+    size_t partialStreams;    // partial 中非空（正在重组）的流数
+
+    bool parse();
+    // 当前帧负载的接收位置：普通帧直接收进消息缓冲区，压缩帧收进 compressedPayload
+    uint8_t* framePayload();
+    bool reserveFrame(size_t length);
+    void updatePayloadCrc(size_t offset, size_t length);
+    bool finishFrame();
+};
+
+#endif // FRAMING_H
@@ -0,0 +1,71 @@
+#ifndef HEALTH_CHECKER_H
+#define HEALTH_CHECKER_H
+
+#include "EventLoop.h"
+#include "LoadBalancer.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 节点健康检查（仅 Linux）：在一个事件循环上并发地对所有节点做非阻塞 TCP 连接探测，
+// 以连接建立的耗时作为 RTT，每个节点保留最近的探测结果（滑动窗口）。
+// 连续失败 fallThreshold 次的节点通过 LoadBalancer::updateNodeStatus 下线，下线后连续成功 riseThreshold 次才重新上线，
+// 偶发的超时不会让节点来回抖动。默认配置下，对端拒绝连接或完全无响应的节点都在一秒内离开轮转。
+// 检查器订阅负载均衡器的节点变化：构造时已有的活跃节点以及之后加入的节点自动开始探测，移除的节点停止探测
+class HealthChecker {
+public:
+    struct Config {
+        int64_t intervalMicros = 250000;    // 同一节点两次探测开始之间的平均间隔
+        double jitter = 0.2;                // 间隔在 ±jitter 比例内随机抖动，避免所有节点同时被探测
+        int64_t timeoutMicros = 250000;     // 连接在该时间内没有建立即视为失败
+        uint32_t fallThreshold = 2;         // 健康节点连续失败次数达到后下线
+        uint32_t riseThreshold = 3;         // 下线节点连续成功次数达到后上线
+        size_t windowSize = 64;             // 每个节点保留的最近探测结果个数
+        size_t maxInFlight = 4096;          // 同时进行的探测上限，超出的排队，避免耗尽文件描述符
+    };
+
+    // 单个节点的健康状态与窗口统计
+    struct NodeHealth {
+        std::string address;
+        uint16_t port = 0;
+        bool healthy = true;                // 检查器的判定，与负载均衡器中的状态一致
+        uint32_t consecutiveFailures = 0;
+        uint32_t consecutiveSuccesses = 0;
+        uint64_t probes = 0;                // 累计探测次数
+        uint64_t failures = 0;              // 累计失败次数
+        size_t windowSamples = 0;           // 窗口中的结果个数
+        size_t windowFailures = 0;          // 窗口中失败的个数
+        uint32_t lastRttMicros = 0;         // 最近一次成功探测的 RTT
+        uint32_t rttP50Micros = 0;          // 窗口中成功探测的 RTT 百分位，没有成功的探测时为 0
+        uint32_t rttP99Micros = 0;
+    };
+
+    // loop 为空时使用 EventLoop::getShared()；传入的循环必须在检查器析构之后才能停止
+    explicit HealthChecker(LoadBalancer& balancer, std::shared_ptr<EventLoop> loop = nullptr);
+    HealthChecker(LoadBalancer& balancer, const Config& config, std::shared_ptr<EventLoop> loop = nullptr);
+    ~HealthChecker();
+
+    HealthChecker(const HealthChecker&) = delete;
+    HealthChecker& operator=(const HealthChecker&) = delete;
+
+    // 探测负载均衡器中当前不活跃、因而没有自动加入的节点；节点初始视为健康。地址不是 IPv4 时返回 false
+    bool addNode(const std::string& address, uint16_t port);
+    void removeNode(const std::string& address, uint16_t port);
+
+    // 停止所有探测并等待进行中的探测关闭，之后不再修改负载均衡器；析构时自动调用
+    void stop();
+
+    std::vector<NodeHealth> getNodeHealth() const;
+
+private:
+    struct Target;
+    struct State;
+
+    LoadBalancer& balancer;
+    std::shared_ptr<State> state;
+    size_t listenerId;
+};
+
+#endif // HEALTH_CHECKER_H
@@ -0,0 +1,107 @@
+#ifndef IO_URING_H
+#define IO_URING_H
+
+#include <linux/io_uring.h>
+#include <cstddef>
+#include <cstdint>
+
+// io_uring 的最小封装（仅 Linux），直接使用系统调用，不依赖 liburing
+// 提交队列和完成队列都只能各由一个线程访问，调用方自行保证
+class IoUring {
+public:
+    IoUring();
+    ~IoUring();
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // 创建并映射环，cqEntries 为 0 时使用内核默认的完成队列长度（提交队列的两倍）；
+    // sqPoll 时由内核线程轮询提交队列，空闲 sqThreadIdleMs 毫秒后休眠。失败时返回 false，errno 保留
+    bool init(unsigned entries, unsigned cqEntries = 0, bool sqPoll = false, unsigned sqThreadIdleMs = 0);
+    void close();
+
+    bool isOpen() const { return ringFd >= 0; }
+    bool isSqPoll() const { return sqPoll; }
+    uint32_t features() const { return featureFlags; }
+
+    // 取一个清零的提交项，提交队列已满时返回 nullptr
+    io_uring_sqe* getSqe();
+
+    // 尚未交给内核的提交项个数
+    unsigned pending() const { return sqeTail - submitted; }
+
+    // 把填好的提交项交给内核，返回交出的个数（SQPOLL 模式下为 0）或 -errno。
+    // SQPOLL 模式下只发布队尾，内核线程休眠时才进入内核唤醒它
+    int submit();
+
+    // 提交并等待至少 waitNr 个完成项
+    int submitAndWait(unsigned waitNr);
+
+    // 完成队列溢出时内核暂存了完成项，需要进入一次内核才能搬进完成队列
+    bool hasOverflow() const;
+    int flushOverflow();
+
+    // 依次处理已到达的完成项，全部处理完后一次推进完成队列的头，返回处理的个数
+    template <typename Handler>
+    unsigned drainCompletions(Handler&& handler) {
+        unsigned head = *cqHead;
+        unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        unsigned count = tail - head;
+        for (; head != tail; head++) {
+            handler(cqes[head & cqMask]);
+        }
+        if (count > 0) {
+            __atomic_store_n(cqHead, tail, __ATOMIC_RELEASE);
+        }
+        return count;
+    }
+
+    // 内核是否支持某个操作（IORING_REGISTER_PROBE）
+    bool supportsOp(uint8_t opcode) const;
+
+    // 以下注册操作成功返回 0，失败返回 -errno
+    // 每个完成项到达时向 eventfd 写入，使环能接入 epoll 反应器
+    int registerEventFd(int eventFd);
+
+    // 预留 count 个固定文件 / 固定缓冲区槽位，之后逐个填入
+    int registerSparseFiles(unsigned count);
+    int updateFile(unsigned slot, int fd);
+    int registerSparseBuffers(unsigned count);
+    int updateBuffer(unsigned slot, void* base, size_t length);
+
+    // 注册提供缓冲区环（provided buffer ring），entries 必须是 2 的幂
+    int registerBufferRing(io_uring_buf_ring* ring, unsigned entries, uint16_t groupId);
+
+    // 内核是否支持 io_uring（能创建环）
+    static bool isAvailable();
+
+private:
+    int ringFd;
+    bool sqPoll;
+    uint32_t featureFlags;
+
+    void* sqRing;
+    size_t sqRingSize;
+    void* cqRing;
+    size_t cqRingSize;
+    io_uring_sqe* sqes;
+    size_t sqesSize;
+
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned* sqFlags;
+    unsigned sqMask;
+    unsigned sqEntries;
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned cqMask;
+    io_uring_cqe* cqes;
+
+    unsigned sqeTail;    // 已取出的提交项
+    unsigned submitted;  // 已发布给内核的提交项
+
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags);
+    int registerOp(unsigned opcode, const void* arg, unsigned count) const;
+};
+
+#endif // IO_URING_H
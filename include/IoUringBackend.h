@@ -0,0 +1,52 @@
+#ifndef IO_URING_BACKEND_H
+#define IO_URING_BACKEND_H
+
+#include "SocketBackend.h"
+#include "EventLoop.h"
+#include <cstddef>
+#include <memory>
+
+// Linux 后端：io_uring（需要 6.0 及以上的内核）
+// 每个连接只在建立时提交一次多次接收（multishot recv），之后到达的数据由内核直接填入共享的提供缓冲区环，
+// 不再每次读取都进入内核；发送的数据拷入该连接的固定缓冲区（registered buffer），套接字也注册为固定文件。
+// 所有提交都在 EventLoop 线程中进行，完成通知经 eventfd 接入同一个 epoll 反应器：
+// 一轮处理中各连接产生的发送和重新挂起的接收合并为一次 io_uring_enter，开启 SQPOLL 后连这一次也省掉。
+// 定时器沿用 EventLoop 的时间轮
+class IoUringBackend : public SocketBackend {
+public:
+    struct Config {
+        unsigned ringEntries = 1024;            // 提交队列长度，完成队列为其 4 倍
+        unsigned maxConnections = 1024;         // 固定文件与固定缓冲区的槽位数，即同时存在的连接数上限
+        size_t sendBufferSize = 256 * 1024;     // 每个连接的发送缓冲区，写满时 send 返回 WOULD_BLOCK
+        unsigned receiveBufferCount = 512;      // 提供缓冲区环中的缓冲区个数（2 的幂），所有连接共享
+        size_t receiveBufferSize = 16 * 1024;
+        bool sqPoll = false;                    // 由内核线程轮询提交队列，提交不再需要系统调用，但多占一个 CPU
+        unsigned sqThreadIdleMs = 1000;         // 内核轮询线程空闲多久后休眠
+    };
+
+    // 内核不支持（版本过旧、被 seccomp 或 io_uring_disabled 禁用）时返回空指针，调用方应退回 EpollBackend
+    // loop 为空时使用 EventLoop::getShared()
+    static std::shared_ptr<IoUringBackend> create(std::shared_ptr<EventLoop> loop = nullptr);
+    static std::shared_ptr<IoUringBackend> create(const Config& config, std::shared_ptr<EventLoop> loop = nullptr);
+
+    // 当前内核能否使用本后端（结果在进程内缓存）
+    static bool isSupported();
+
+    ~IoUringBackend() override;
+
+    std::unique_ptr<TransportSocket> createSocket() override;
+    const char* name() const override;
+    bool runAfter(int64_t delayMicros, std::function<void()> task) override;
+
+    std::shared_ptr<EventLoop> getLoop() const;
+
+private:
+    struct State;
+    class Socket;
+
+    explicit IoUringBackend(std::shared_ptr<State> state);
+
+    std::shared_ptr<State> state;
+};
+
+#endif // IO_URING_BACKEND_H
@@ -1,43 +1,202 @@
 #ifndef LOAD_BALANCER_H
 #define LOAD_BALANCER_H
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
 
+// 线程安全的负载均衡器
+// 节点集合的修改（addNode/removeNode/updateNodeStatus）在互斥锁内生成新的只读快照并整体发布（RCU），
+// 选择节点只读取当前快照，全程不加锁
 class LoadBalancer {
 public:
     enum class Strategy {
         ROUND_ROBIN,
-        WEIGHTED_ROUND_ROBIN,
+        WEIGHTED_ROUND_ROBIN,   // 平滑加权轮询（nginx 算法），确定性且均匀交错
         LEAST_CONNECTIONS,
-        RANDOM
+        RANDOM,
+        WEIGHTED_RANDOM,        // 按权重随机，Walker 别名表 O(1) 选择
+        CONSISTENT_HASH,        // 虚拟节点哈希环，按 key 选择，O(log n)
+        MAGLEV,                 // Maglev 查找表，按 key 选择，O(1)
+        POWER_OF_TWO_CHOICES,   // 随机取两个活跃节点，选在途连接较少的一个，O(1)
+        PEAK_EWMA               // 随机取两个活跃节点，选 峰值EWMA延迟×(在途连接数+1) 较小的一个，O(1)；
+                                // 延迟由 Lease::reportLatency 反馈
+    };
+
+    // 节点集合的变化，供连接池预热、清理连接等使用
+    enum class NodeEvent {
+        ADDED,
+        REMOVED,
+        ACTIVATED,
+        DEACTIVATED
+    };
+    using NodeListener = std::function<void(NodeEvent event, const std::string& address, uint16_t port)>;
+
+private:
+    struct NodeStats;
+
+public:
+    // 节点租约：创建时节点的在途连接数加一，析构或 release() 时减一
+    // 计数跟随节点本身而不是快照，节点被移除后租约仍可安全释放
+    class Lease {
+    public:
+        Lease() = default;
+        ~Lease();
+
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        const std::string& address() const { return address_; }
+        uint16_t port() const { return port_; }
+        explicit operator bool() const { return stats_ != nullptr; }
+
+        // 反馈本次请求的完成耗时，供 PEAK_EWMA 使用；无锁，可在任意线程调用，租约释放后调用无效
+        void reportLatency(uint64_t latencyMicros);
+
+        // 提前归还租约
+        void release();
+
+    private:
+        friend class LoadBalancer;
+        Lease(const std::string& address, uint16_t port, std::shared_ptr<NodeStats> stats);
+
+        std::string address_;
+        uint16_t port_ = 0;
+        std::shared_ptr<NodeStats> stats_;
     };
 
     LoadBalancer();
-    
+    ~LoadBalancer();
+
+    LoadBalancer(const LoadBalancer&) = delete;
+    LoadBalancer& operator=(const LoadBalancer&) = delete;
+
+    struct NodeSpec {
+        std::string address;
+        uint16_t port;
+        uint32_t weight = 1;
+    };
+
     void addNode(const std::string& address, uint16_t port, uint32_t weight = 1);
+    // 批量添加：语义与逐个 addNode 相同，但只发布一次快照，适合一次注册成千上万个节点
+    void addNodes(const std::vector<NodeSpec>& specs);
     void removeNode(const std::string& address, uint16_t port);
     std::pair<std::string, uint16_t> getNextNode();
+    // 按 key（会话ID、缓存键等）选择节点：CONSISTENT_HASH/MAGLEV 下同一 key 总是落到同一节点，
+    // 节点上下线时只有约 1/N 的 key 会迁移；其他策略忽略 key
+    std::pair<std::string, uint16_t> getNextNode(const std::string& key);
+    // 选择节点并持有租约，LEAST_CONNECTIONS/POWER_OF_TWO_CHOICES/PEAK_EWMA 依据租约统计在途连接数
+    // （getNextNode 只选择不计数）
+    Lease acquireNode();
+    Lease acquireNode(const std::string& key);
     void setStrategy(Strategy strategy);
     void updateNodeStatus(const std::string& address, uint16_t port, bool isActive);
 
+    // 当前活跃的节点
+    std::vector<std::pair<std::string, uint16_t>> getActiveNodes();
+
+    // 订阅节点变化，回调在修改节点的线程中、写锁释放之后执行；返回的编号用于取消订阅
+    size_t addNodeListener(NodeListener listener);
+    void removeNodeListener(size_t id);
+
 private:
+    // 节点的运行时统计，由主副本和各个快照共享
+    struct NodeStats {
+        std::atomic<uint32_t> activeConnections{0};
+        // 峰值 EWMA 延迟：高32位为 float 微秒，低32位为更新时刻（毫秒，按32位回绕），一次 CAS 同时更新两者
+        std::atomic<uint64_t> latency{0};
+    };
+
+    // 峰值 EWMA 的衰减时间常数：没有新样本时延迟估计按 exp(-t/τ) 衰减，慢节点过一段时间会重新得到流量
+    static const uint32_t LATENCY_DECAY_MILLIS = 10000;
+
     struct Node {
         std::string address;
         uint16_t port;
         uint32_t weight;
-        uint32_t currentConnections;
+        std::shared_ptr<NodeStats> stats;
         bool isActive;
     };
 
-    std::vector<Node> nodes;
-    Strategy currentStrategy;
-    size_t currentIndex;
+    // 别名表的一列：随机数低32位小于 threshold 时选本列节点，否则选 alias
+    struct AliasEntry {
+        uint32_t threshold;
+        uint32_t alias;
+    };
+
+    // 哈希环上的一个虚拟节点
+    struct RingPoint {
+        uint64_t hash;
+        uint32_t node;
+    };
+
+    // 只读快照，发布后不再修改
+    // 加权结构在发布时（持有 writeMutex）按当前策略构建，选择节点时只读；其他策略的结构留空，
+    // 切换策略时先发布带有新策略结构的快照
+    struct Snapshot {
+        std::vector<Node> nodes;
+        std::vector<size_t> activeNodes;       // 活跃节点在 nodes 中的下标
+        uint64_t totalActiveWeight = 0;
+        std::vector<uint32_t> weightedNodes;   // 权重大于0的活跃节点下标
+
+        std::vector<uint32_t> smoothSchedule;          // 平滑加权轮询一个完整周期的选择序列
+        std::vector<AliasEntry> aliasTable;            // 与 weightedNodes 一一对应
+        std::vector<RingPoint> hashRing;               // 按哈希值排序的虚拟节点
+        std::vector<uint32_t> maglevTable;             // 槽位 -> nodes 下标
+    };
+
+    // 读者计数按线程分散到多个缓存行，避免所有线程争用同一个计数器
+    static const size_t READER_STRIPES = 64;
+    struct alignas(64) ReaderStripe {
+        std::atomic<int64_t> count[2];
+    };
+    class ReadGuard;
+
+    std::mutex writeMutex;
+    std::vector<Node> nodes;              // 写入方维护的主副本，受 writeMutex 保护
+    std::atomic<const Snapshot*> snapshot;
+    std::atomic<uint64_t> epoch;
+    ReaderStripe readers[READER_STRIPES];
+
+    std::atomic<Strategy> currentStrategy;
+    std::atomic<size_t> currentIndex;
+
+    std::mutex listenerMutex;
+    std::vector<std::pair<size_t, NodeListener>> listeners;
+    size_t nextListenerId;
+
+    void notifyNodeListeners(NodeEvent event, const std::string& address, uint16_t port);
+
+    // 根据主副本生成新快照并等待旧快照的读者退出后回收（需持有 writeMutex）；
+    // 快照带有当前策略和 next 所需的加权结构
+    void publishSnapshot();
+    void publishSnapshot(Strategy next);
+    void waitForReaders();
+    static void buildStructures(Snapshot& snap, Strategy strategy);
+    static void buildSmoothSchedule(Snapshot& snap);
+    static void buildAliasTable(Snapshot& snap);
+    static void buildHashRing(Snapshot& snap);
+    static void buildMaglevTable(Snapshot& snap);
+
+    const Node& selectNode(const Snapshot& snap);
+    const Node& selectNode(const Snapshot& snap, const std::string& key);
+
     // 添加私有辅助方法的声明
-    std::pair<std::string, uint16_t> getRoundRobinNode();
-    std::pair<std::string, uint16_t> getWeightedRoundRobinNode();
-    std::pair<std::string, uint16_t> getLeastConnectionsNode();
-    std::pair<std::string, uint16_t> getRandomNode();
+    const Node& getRoundRobinNode(const Snapshot& snap);
+    const Node& getWeightedRoundRobinNode(const Snapshot& snap);
+    const Node& getLeastConnectionsNode(const Snapshot& snap);
+    const Node& getRandomNode(const Snapshot& snap);
+    const Node& getWeightedRandomNode(const Snapshot& snap);
+    const Node& getHashRingNode(const Snapshot& snap, uint64_t keyHash);
+    const Node& getMaglevNode(const Snapshot& snap, uint64_t keyHash);
+    const Node& getPowerOfTwoChoicesNode(const Snapshot& snap);
+    const Node& getPeakEwmaNode(const Snapshot& snap);
 };
 
-#endif // LOAD_BALANCER_H
\ No newline at end of file
+#endif // LOAD_BALANCER_H
@@ -0,0 +1,135 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 对数线性分桶的延迟直方图（HDR 风格）：小于 16 的值各占一个桶，之后每个 2 的幂区间等分为 16 个桶，
+// 相对误差不超过 1/16；超过 2^40 的值计入最后一个桶。单位由调用方决定，本项目中为微秒
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 4;
+    static constexpr unsigned SUB_BUCKET_COUNT = 1u << SUB_BUCKET_BITS;
+    static constexpr unsigned MAX_EXPONENT = 40;
+    static constexpr size_t BUCKET_COUNT = SUB_BUCKET_COUNT + (MAX_EXPONENT - SUB_BUCKET_BITS) * SUB_BUCKET_COUNT;
+
+    using Buckets = std::array<uint64_t, BUCKET_COUNT>;
+
+    LatencyHistogram();
+    // 由分桶计数构造（合并各线程的分片时使用）
+    LatencyHistogram(const Buckets& counts, uint64_t sum, uint64_t min, uint64_t max);
+
+    // 值所在的桶，以及桶中最大的值
+    static size_t bucketIndex(uint64_t value);
+    static uint64_t bucketUpperBound(size_t index);
+
+    void record(uint64_t value);
+    void merge(const LatencyHistogram& other);
+    void reset();
+
+    uint64_t count() const;
+    uint64_t sum() const;
+    uint64_t min() const;   // 没有样本时为 0
+    uint64_t max() const;
+    double mean() const;
+
+    // 百分位数（0-100），返回所在桶的上界且不超过最大值；没有样本时为 0
+    uint64_t percentile(double p) const;
+    // 不超过 value 的样本数，value 为某个桶的上界时是精确的
+    uint64_t countAtOrBelow(uint64_t value) const;
+
+    const Buckets& buckets() const;
+
+private:
+    Buckets counts;
+    uint64_t total;
+    uint64_t sumValue;
+    uint64_t minValue;
+    uint64_t maxValue;
+};
+
+// 进程内的指标：每个线程写自己的分片（不加锁、没有原子读改写，记录一次只要几纳秒），
+// 取快照时才加锁汇总所有分片；线程退出时分片并入累计值，计数器不会回退。
+// 每个连接另有一份同样的计数器，随 Protocol::metrics() 取得；延迟直方图每个约 4.7KB，只按线程汇总
+class Metrics {
+public:
+    enum class Counter {
+        CONNECTIONS_OPENED,
+        CONNECTIONS_CLOSED,
+        BYTES_SENT,
+        BYTES_RECEIVED,
+        MESSAGES_SENT,
+        MESSAGES_RECEIVED,
+        FRAMES_SENT,        // 写完的分块（帧）数
+        SEND_CALLS,         // 发送调用（系统调用或 io_uring 提交）次数
+        RECEIVE_CALLS,
+        SEND_BLOCKED,       // 发送缓冲区已满，等待可写
+        PACING_WAITS,       // 等待发送节拍或合并定时器
+        LOSS_EVENTS,        // 内核报告重传、通知拥塞控制器的次数
+        FRAMES_COMPRESSED,  // 负载按压缩发送的帧数
+        COMPRESSION_SAVED_BYTES,    // 压缩省下的负载字节数
+        COUNT
+    };
+    static constexpr size_t COUNTER_COUNT = static_cast<size_t>(Counter::COUNT);
+
+    enum class Latency {
+        SEND,               // 提交发送到全部写入内核
+        RECEIVE,            // 发起接收到消息交付
+        ROUND_TRIP,         // requestAsync：请求提交到响应交付
+        COUNT
+    };
+    static constexpr size_t LATENCY_COUNT = static_cast<size_t>(Latency::COUNT);
+
+    using Counters = std::array<uint64_t, COUNTER_COUNT>;
+
+    struct Snapshot {
+        Counters counters{};
+        std::array<LatencyHistogram, LATENCY_COUNT> latencies;
+
+        uint64_t operator[](Counter counter) const { return counters[static_cast<size_t>(counter)]; }
+        const LatencyHistogram& operator[](Latency latency) const { return latencies[static_cast<size_t>(latency)]; }
+    };
+
+    // 拥塞窗口轨迹上的一个点，窗口或阈值变化时记录
+    struct WindowSample {
+        int64_t timestampMicros;
+        uint64_t congestionWindow;
+        uint64_t slowStartThreshold;    // 0 表示控制器没有慢启动阈值
+    };
+
+    // 单个连接的计数器和当前状态
+    struct ConnectionSnapshot {
+        Counters counters{};
+        uint64_t congestionWindow = 0;
+        uint64_t slowStartThreshold = 0;
+        uint64_t pacingRate = 0;            // 字节/秒，0 表示不限速
+        uint32_t smoothedRttMicros = 0;
+        uint64_t queuedBytes = 0;           // 排队等待写出的字节数
+        size_t chunkSize = 0;
+        std::vector<WindowSample> windowHistory;    // 最近的拥塞窗口轨迹，从旧到新
+
+        uint64_t operator[](Counter counter) const { return counters[static_cast<size_t>(counter)]; }
+    };
+
+    // 计入当前线程的分片
+    static void add(Counter counter, uint64_t value = 1);
+    static void record(Latency latency, uint64_t micros);
+
+    // 汇总所有线程
+    static Snapshot snapshot();
+
+    static const char* name(Counter counter);
+    static const char* name(Latency latency);
+
+    // Prometheus 文本格式：计数器为 counter，延迟为以秒计的 histogram（边界取 2 的幂微秒）
+    static std::string toPrometheus(const Snapshot& snapshot, const std::string& prefix = "hpnp");
+    // 每个连接一组带 connection 标签的计数器和状态量
+    static std::string toPrometheus(const std::vector<std::pair<std::string, ConnectionSnapshot>>& connections,
+                                    const std::string& prefix = "hpnp");
+};
+
+#endif // METRICS_H
@@ -0,0 +1,92 @@
+#ifndef NETWORK_SIMULATOR_H
+#define NETWORK_SIMULATOR_H
+
+#include "CongestionController.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 确定性的离散事件网络仿真器，离线比较拥塞控制器与分块策略
+// 模型：所有流共享一条瓶颈链路（FIFO 尾部丢弃队列），数据包经排队、串行化、传播到达接收端，
+// 接收端逐包确认，确认沿无拥塞的反向路径返回。相同的配置与随机种子总是得到相同的结果
+class NetworkSimulator {
+public:
+    struct LinkConfig {
+        uint64_t bandwidth = 12500000;            // 瓶颈带宽（字节/秒）
+        int64_t propagationDelayMicros = 20000;   // 单向传播时延
+        uint64_t queueBytes = 0;                  // 瓶颈队列容量，0 表示一个带宽时延积
+        double randomLoss = 0;                    // 独立随机丢包率
+
+        // Gilbert-Elliott 突发丢包：每个包以 burstEnter 概率进入坏状态，以 burstExit 概率离开，
+        // 坏状态下的丢包率为 burstLoss
+        double burstEnter = 0;
+        double burstExit = 0.5;
+        double burstLoss = 1.0;
+    };
+
+    struct FlowConfig {
+        CongestionController::Type controller = CongestionController::Type::CUBIC;
+        // 自定义控制器，设置后忽略 controller
+        std::function<std::unique_ptr<CongestionController>()> factory;
+        uint32_t mss = CongestionController::DEFAULT_MSS;
+        int64_t startMicros = 0;
+        int64_t extraDelayMicros = 0;   // 该流额外的往返时延（模拟不同 RTT 的竞争流）
+        uint64_t bytes = 0;             // 需要传输的应用字节数，0 表示持续发送
+        // 大于0时应用数据按该大小的消息经 TcpChunkOptimization 分帧，
+        // 分块大小由 ChunkSizeTuner 根据仿真中的发送速率、窗口受限时间和 RTT 调整，与 Protocol 相同
+        uint32_t messageSize = 0;
+    };
+
+    struct FlowStats {
+        std::string controller;
+        uint64_t bytesDelivered;        // 应用字节（不含重传与帧头）
+        uint64_t packetsSent;
+        uint64_t packetsLost;
+        double throughput;              // 活跃期间的平均吞吐（字节/秒）
+        double lossRate;
+        double avgQueueDelayMicros;
+        double p99QueueDelayMicros;
+        int64_t completionMicros;       // 有限流的完成时间，未完成为 -1
+        uint32_t chunkSize;             // 结束时 adjustChunkSize 选出的分块大小，未分帧为0
+        double framingOverhead;         // 帧头占发送字节的比例
+    };
+
+    struct Sample {
+        int64_t timeMicros;
+        uint64_t queueBytes;
+        std::vector<uint64_t> congestionWindow;
+        std::vector<double> throughput;  // 本采样周期内的吞吐（字节/秒）
+    };
+
+    struct Report {
+        int64_t durationMicros;
+        double linkUtilization;
+        double fairnessIndex;           // Jain 公平性指数，1 表示完全公平
+        double avgQueueDelayMicros;
+        uint64_t queueDrops;
+        uint64_t randomDrops;
+        std::vector<FlowStats> flows;
+        std::vector<Sample> timeline;   // sampleIntervalMicros > 0 时记录
+    };
+
+    // 带宽为 0，或未指定队列容量而传播时延不为正时抛出 std::invalid_argument
+    explicit NetworkSimulator(const LinkConfig& link, uint64_t seed = 1);
+    ~NetworkSimulator();
+
+    NetworkSimulator(const NetworkSimulator&) = delete;
+    NetworkSimulator& operator=(const NetworkSimulator&) = delete;
+
+    // 添加一条流，返回流编号
+    size_t addFlow(const FlowConfig& flow);
+
+    // 仿真 durationMicros 的时间（所有有限流提前完成时提前结束）
+    Report run(int64_t durationMicros, int64_t sampleIntervalMicros = 0);
+
+private:
+    class SimulatorImpl;
+    std::unique_ptr<SimulatorImpl> impl;
+};
+
+#endif // NETWORK_SIMULATOR_H
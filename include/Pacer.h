@@ -0,0 +1,40 @@
+#ifndef PACER_H
+#define PACER_H
+
+#include <cstdint>
+
+// 令牌桶发送节拍器
+// 令牌按速率持续累积，上限为突发量；发送前取令牌，不足时等待，使数据在一个 RTT 内均匀发出
+class Pacer {
+public:
+    Pacer();
+
+    // 速率（字节/秒），0 表示不限速
+    void setRate(uint64_t bytesPerSecond);
+    uint64_t getRate() const;
+
+    // 令牌上限，即一次最多连续发送的字节数
+    void setBurst(uint64_t bytes);
+    uint64_t getBurst() const;
+
+    // 当前可发送的字节数，不限速时返回 UINT64_MAX
+    uint64_t available(int64_t nowMicros);
+
+    // 扣除已发送的字节，允许透支（之后的等待时间相应变长）
+    void consume(uint64_t bytes);
+
+    // 令牌攒够 bytes（不超过突发量）还需等待的微秒数
+    int64_t delayFor(uint64_t bytes, int64_t nowMicros);
+
+    void reset();
+
+private:
+    uint64_t rate;
+    uint64_t burst;
+    double tokens;
+    int64_t lastRefill;
+
+    void refill(int64_t nowMicros);
+};
+
+#endif // PACER_H
@@ -2,29 +2,111 @@
 #define PROTOCOL_H
 
 #include <string>
+#include <functional>
+#include <future>
 #include <memory>
+#include "BufferPool.h"
+#include "Compression.h"
 #include "CongestionControl.h"
+#include "CongestionController.h"
 #include "LoadBalancer.h"
+#include "Metrics.h"
 #include "TcpChunkOptimization.h"
+#include "SocketBackend.h"
+#include "StreamScheduler.h"
 
 class Protocol {
 public:
+    using SendCallback = std::function<void(bool ok)>;
+    using ReceiveCallback = std::function<void(bool ok, std::string message)>;
+    using BufferCallback = std::function<void(bool ok, Buffer message)>;
+
     Protocol();
+    // 使用指定的套接字后端（多个连接可共享同一个后端及其事件循环）
+    explicit Protocol(std::shared_ptr<SocketBackend> backend);
+    // 接管已经建立的连接（服务端接受的连接），socket 须由 backend 创建
+    Protocol(std::shared_ptr<SocketBackend> backend, std::unique_ptr<TransportSocket> socket);
     ~Protocol();
 
     // 初始化连接
     bool initializeConnection(const std::string& host, uint16_t port);
+    // 带连接超时（毫秒，< 0 表示不超时）
+    bool initializeConnection(const std::string& host, uint16_t port, int timeoutMs);
+
+    // 连接是否仍可使用：已建立且对端没有关闭或出错
+    bool isConnected() const;
     
-    // 设置拥塞控制算法
+    // 设置拥塞控制算法（仅对 Reno 控制器有效）
     void setCongestionControlAlgorithm(CongestionControl::Algorithm algo);
+
+    // 为本连接选择拥塞控制器，默认 Reno
+    void setCongestionController(CongestionController::Type type);
+    void setCongestionController(std::unique_ptr<CongestionController> controller);
     
-    // 发送数据
-    bool sendData(const std::string& data);
+    // 多路复用：每条消息属于一个流（0-65535，默认 0），各流的帧在同一连接上交错发送，
+    // 一个流上的大消息不会阻塞其他流；同一流内消息保持顺序，接收时按流分别交付
+    // 优先级数值越小越优先，同一优先级内按权重分配带宽；未设置的流使用默认优先级和权重
+    void setStreamPriority(uint16_t streamId, uint8_t priority,
+                           uint16_t weight = StreamScheduler::DEFAULT_WEIGHT);
+
+    // 发送数据，等到消息全部写入内核后返回
+    bool sendData(const std::string& data, uint16_t streamId = 0);
     
-    // 接收数据
-    std::string receiveData();
+    // 接收指定流上的下一条消息，连接关闭或出错时返回空串
+    std::string receiveData(uint16_t streamId = 0);
+
+    // 不分配内存的收发：稳定状态下每条消息都不向系统申请内存
+    // 接收的消息直接交出解析器重组时所用的池化缓冲区，句柄释放后缓冲区回到连接的缓冲区池
+    bool sendData(const uint8_t* data, size_t length, uint16_t streamId = 0);
+    bool receiveBuffer(Buffer& message, uint16_t streamId = 0);
+    // 把消息拷入调用方的缓冲区，length 为消息的完整长度；放不下时截断并返回 false，
+    // 连接关闭或出错时返回 false 且 length 为 0
+    bool receiveInto(uint8_t* buffer, size_t capacity, size_t& length, uint16_t streamId = 0);
     
-    // 关闭连接
+    // 异步接口：操作在事件循环中推进，一个线程可以让同一连接上同时有任意多个请求在途
+    // 回调在事件循环线程中执行（能立即完成时在调用线程中执行），不应在回调中阻塞，也不应调用同步接口；
+    // 同步与异步接口共用同一组按流调度的队列，可以混用。后端不支持就绪回调时退化为在调用线程中同步完成
+    // 消息全部写入内核后完成
+    std::future<bool> sendAsync(std::string data, uint16_t streamId = 0);
+    void sendAsync(std::string data, SendCallback callback, uint16_t streamId = 0);
+    // 发送池化缓冲区，队列持有一个引用直到写完，不拷贝数据
+    std::future<bool> sendAsync(Buffer data, uint16_t streamId = 0);
+    void sendAsync(Buffer data, SendCallback callback, uint16_t streamId = 0);
+
+    // 按到达顺序交付该流上的下一条消息；连接关闭或出错时 future 抛出 std::runtime_error，回调收到 ok=false
+    std::future<std::string> receiveAsync(uint16_t streamId = 0);
+    void receiveAsync(ReceiveCallback callback, uint16_t streamId = 0);
+    // 以池化缓冲区交付，不拷贝
+    void receiveBufferAsync(BufferCallback callback, uint16_t streamId = 0);
+
+    // 流水线请求：发送请求并等待该流上的下一条响应，同一流上响应按请求的提交顺序一一对应
+    std::future<std::string> requestAsync(std::string request, uint16_t streamId = 0);
+    void requestAsync(std::string request, ReceiveCallback callback, uint16_t streamId = 0);
+
+    // 小消息合并：待发送数据不足一个最优分块时最多等待 delayMicros 微秒，期间提交的消息拼进同一次写出，
+    // 减少系统调用和小包；0 表示不合并（默认）。同步的 sendData 总是立即写出
+    void setCoalescingDelay(uint32_t delayMicros);
+
+    // 立即写出所有正在等待合并的消息，不等待写完
+    void flush();
+
+    // 发送压缩：启用后每个分块在写出前用 LZ4 块格式压缩，压缩后没有明显变小的分块原样发送，
+    // 连续不可压缩时只抽样尝试（见 ChunkCompressor）；帧带 FLAG_COMPRESSED 标记，接收方总能解压，
+    // 两端不需要协商。适合 JSON、日志等可压缩、且链路带宽受限的负载，默认关闭
+    void setCompression(bool enabled);
+    void setCompression(bool enabled, const ChunkCompressor::Config& config);
+
+    // 连接的缓冲区池，接收的消息取自这里；发送方也可以从中申请缓冲区，用完即回到池中
+    std::shared_ptr<BufferPool> bufferPool() const;
+
+    // 本连接的计数器、拥塞控制状态和最近的拥塞窗口轨迹；进程级汇总及延迟直方图见 Metrics::snapshot()
+    Metrics::ConnectionSnapshot metrics() const;
+
+    // 连接变为不可用（出错、对端关闭或调用 closeConnection）时调用一次，在发现的线程中、解锁之后执行；
+    // 对端关闭只有在读写该连接时才会被发现，需要及时得知时应保持一个挂起的异步接收。销毁 Protocol 不会触发
+    void setCloseCallback(std::function<void()> callback);
+
+    // 关闭连接，尚未完成的异步操作以失败结束
     void closeConnection();
 
 private:
@@ -0,0 +1,68 @@
+#ifndef PROTOCOL_SERVER_H
+#define PROTOCOL_SERVER_H
+
+#include "EventLoop.h"
+#include "Protocol.h"
+#include "SocketBackend.h"
+#include "UdpBackend.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 服务端（仅 Linux）：每个核心一个事件循环线程，各自持有 SO_REUSEPORT 监听套接字、套接字后端和连接表，
+// 核心之间不共享任何可变状态。内核按四元组的哈希把新连接分给各个监听套接字，
+// 一个连接从接受到关闭都只在所属的循环线程中处理。接受的连接是普通的 Protocol，沿用分帧、分块和拥塞控制
+class ProtocolServer {
+public:
+    // 在连接所属的循环线程中调用，不应阻塞，应使用 Protocol 的异步接口；
+    // 服务端持有连接直到它变为不可用（见 Protocol::setCloseCallback），处理函数不必保存它
+    using ConnectionHandler = std::function<void(const std::shared_ptr<Protocol>& connection)>;
+    // 为每个循环创建套接字后端，返回空指针时使用 EpollBackend
+    using BackendFactory = std::function<std::shared_ptr<SocketBackend>(const std::shared_ptr<EventLoop>& loop)>;
+
+    struct Config {
+        unsigned threads = 0;           // 事件循环个数，0 表示进程可用的 CPU 数
+        bool pinThreads = true;         // 第 i 个循环绑定到进程可用的第 i 个 CPU
+        int backlog = 4096;
+        BackendFactory backendFactory;  // 为空时每个循环使用 EpollBackend
+        // 改用可靠 UDP 传输（见 UdpBackend）：每个循环一个 UdpBackend 监听同一个 UDP 端口，
+        // 此时忽略 backlog 和 backendFactory；客户端须使用 UdpBackend 连接
+        bool reliableUdp = false;
+        UdpBackend::Config udp;
+    };
+
+    explicit ProtocolServer(ConnectionHandler handler);
+    ProtocolServer(const Config& config, ConnectionHandler handler);
+    ~ProtocolServer();
+
+    ProtocolServer(const ProtocolServer&) = delete;
+    ProtocolServer& operator=(const ProtocolServer&) = delete;
+
+    // 在 host:port 上监听并启动所有循环；port 为 0 时由内核选择，所有循环共用同一个端口。
+    // 失败时（地址无效、端口被占用等）不留下任何线程并返回 false
+    bool start(const std::string& host, uint16_t port);
+
+    // 关闭监听套接字和所有连接，等待循环线程退出
+    void stop();
+
+    bool isRunning() const;
+    uint16_t port() const;
+    size_t threadCount() const;
+
+    // 当前持有的连接数（所有循环之和，以及单个循环）
+    size_t connectionCount() const;
+    size_t connectionCount(size_t thread) const;
+
+private:
+    struct Shard;
+
+    Config config;
+    ConnectionHandler handler;
+    std::vector<std::shared_ptr<Shard>> shards;
+    uint16_t boundPort;
+};
+
+#endif // PROTOCOL_SERVER_H
@@ -0,0 +1,29 @@
+#ifndef RENO_CONTROLLER_H
+#define RENO_CONTROLLER_H
+
+#include "CongestionController.h"
+#include "CongestionControl.h"
+
+// 经典 Reno：沿用 CongestionControl 的状态机（以 MSS 为单位），
+// 每确认一整个窗口的数据视为一个 RTT 调用一次 updateWindow
+class RenoController : public CongestionController {
+public:
+    explicit RenoController(uint32_t mss = DEFAULT_MSS);
+
+    void onAck(const AckEvent& event) override;
+    void onLoss(const LossEvent& event) override;
+    uint64_t getCongestionWindow() const override;
+    uint64_t getSlowStartThreshold() const override;
+    void reset() override;
+    const char* name() const override { return "reno"; }
+
+    void setAlgorithm(CongestionControl::Algorithm algo);
+    CongestionControl::StateInfo getStateInfo() const;
+
+private:
+    CongestionControl state;
+    uint32_t mss;
+    uint64_t ackedInRound;  // 当前窗口内已确认的字节数
+};
+
+#endif // RENO_CONTROLLER_H
@@ -0,0 +1,43 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 固定容量的字节环形缓冲区，容量向上取整为2的幂
+// 写入方通过 writableSpans 直接获得空闲区域（可交给 readv），避免额外拷贝
+class RingBuffer {
+public:
+    struct Span {
+        uint8_t* data;
+        size_t length;
+    };
+
+    explicit RingBuffer(size_t capacity = 64 * 1024);
+
+    size_t size() const;
+    size_t capacity() const;
+    size_t available() const;
+    bool empty() const;
+
+    // 获取最多两段空闲区域，返回段数
+    size_t writableSpans(Span spans[2]);
+    void commitWrite(size_t length);
+
+    // 拷贝出前 length 字节但不消费
+    bool peek(uint8_t* destination, size_t length) const;
+    // 拷贝出前 length 字节并消费
+    size_t read(uint8_t* destination, size_t length);
+    void consume(size_t length);
+
+    void clear();
+
+private:
+    std::vector<uint8_t> buffer;
+    size_t mask;
+    size_t readPos;   // 单调递增，取模后才是下标
+    size_t writePos;
+};
+
+#endif // RING_BUFFER_H
@@ -0,0 +1,109 @@
+#ifndef SOCKET_BACKEND_H
+#define SOCKET_BACKEND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+class EventLoop;
+
+// 单个连接的平台无关套接字接口
+// 所有 I/O 都是非阻塞的尝试，需要等待时调用 waitReadable/waitWritable
+class TransportSocket {
+public:
+    enum class IoStatus {
+        OK,
+        WOULD_BLOCK,
+        CLOSED,
+        FAILED
+    };
+
+    struct IoResult {
+        IoStatus status;
+        size_t bytes;
+    };
+
+    // 分散/聚集 I/O 的一段缓冲区
+    struct IoVec {
+        void* base;
+        size_t length;
+    };
+
+    // 内核观测到的传输路径统计，用于驱动拥塞控制器
+    struct PathInfo {
+        uint32_t rttMicros;         // 平滑 RTT，0 表示未知
+        uint32_t mss;
+        uint64_t bytesAcked;        // 累计被对端确认的字节数
+        uint64_t bytesInFlight;
+        uint64_t deliveryRate;      // 字节/秒，0 表示未知
+        uint32_t totalRetransmits;  // 累计重传的报文段数
+    };
+
+    // 单次分散/聚集调用最多使用的缓冲区段数
+    static constexpr size_t MAX_IOV = 64;
+
+    virtual ~TransportSocket() = default;
+
+    // 建立连接，timeoutMs < 0 表示不超时
+    virtual bool connect(const std::string& host, uint16_t port, int timeoutMs) = 0;
+
+    // 接管一个已经建立的连接（服务端 accept 得到的套接字句柄），成功后由本对象负责关闭；
+    // 默认实现返回 false，句柄仍归调用方
+    virtual bool adopt(intptr_t handle);
+
+    // 尽可能多地发送/接收，不会阻塞
+    virtual IoResult send(const void* data, size_t length) = 0;
+    virtual IoResult receive(void* buffer, size_t length) = 0;
+
+    // 一次系统调用发送/接收多段缓冲区（writev/sendmsg、readv/recvmsg）
+    // 默认实现逐段调用 send/receive，后端可覆盖为真正的分散/聚集调用
+    virtual IoResult sendv(const IoVec* vecs, size_t count);
+    virtual IoResult receivev(const IoVec* vecs, size_t count);
+
+    // 等待上一次 WOULD_BLOCK 之后的就绪通知，超时返回 false
+    virtual bool waitReadable(int timeoutMs) = 0;
+    virtual bool waitWritable(int timeoutMs) = 0;
+
+    // 读取路径统计（Linux 上来自 TCP_INFO），不支持时返回 false
+    virtual bool getPathInfo(PathInfo& info) const;
+
+    // 对端是否已关闭写方向（收到 FIN/RST），空闲连接复用前据此判断是否已失效
+    // 默认实现总是返回 false
+    virtual bool isPeerClosed() const;
+
+    // 注册就绪回调：套接字每次出现新的可读/可写边缘时在后端的事件线程中调用，传空函数取消；
+    // 异步接口依靠它在事件循环中推进，后端不支持时返回 false
+    virtual bool setReadyCallback(std::function<void()> callback);
+
+    // 传输层自己做拥塞控制与发送节拍（例如可靠 UDP），上层不应再叠加一层窗口；默认返回 false
+    virtual bool controlsCongestion() const;
+
+    virtual void close() = 0;
+    virtual bool isOpen() const = 0;
+};
+
+// 套接字后端：封装平台相关的套接字创建与事件驱动方式
+class SocketBackend {
+public:
+    virtual ~SocketBackend() = default;
+
+    virtual std::unique_ptr<TransportSocket> createSocket() = 0;
+
+    // 后端名称，便于日志与诊断
+    virtual const char* name() const = 0;
+
+    // 在 delayMicros 微秒后于后端的事件线程中执行任务（发送节拍等共享定时器），
+    // 后端没有定时器时返回 false，调用方自行等待
+    virtual bool runAfter(int64_t delayMicros, std::function<void()> task);
+
+    // 当前平台的默认后端（Linux 为 epoll，Windows 为 winsock），进程内共享
+    static std::shared_ptr<SocketBackend> getDefault();
+
+    // 新建一个后端：Linux 上优先使用 io_uring，内核不支持时退回 epoll；Windows 为 winsock，忽略 loop。
+    // loop 为空时后端使用自己的事件循环，可以直接作为 ProtocolServer::Config::backendFactory
+    static std::shared_ptr<SocketBackend> createPreferred(std::shared_ptr<EventLoop> loop = nullptr);
+};
+
+#endif // SOCKET_BACKEND_H
@@ -0,0 +1,62 @@
+#ifndef STREAM_SCHEDULER_H
+#define STREAM_SCHEDULER_H
+
+#include <cstdint>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+
+// 多路复用连接上的发送调度器：决定下一帧从哪个流发出
+// 优先级严格区分（数值越小越优先），同一优先级内按权重做步进调度（stride scheduling），
+// 各流分到的字节数与权重成正比；刚变为活跃的流从当前虚拟时间起步，不会因为空闲过而一次补发很多
+// 非线程安全，由连接的发送路径在锁内调用
+class StreamScheduler {
+public:
+    static constexpr uint8_t DEFAULT_PRIORITY = 3;
+    static constexpr uint16_t DEFAULT_WEIGHT = 16;
+
+    StreamScheduler();
+
+    // 设置流的优先级与权重（权重为 0 时按 1 处理），对已活跃的流立即生效
+    void setPriority(uint16_t streamId, uint8_t priority, uint16_t weight);
+
+    // 流有数据待发送 / 已经没有数据
+    void activate(uint16_t streamId);
+    void deactivate(uint16_t streamId);
+
+    // 下一个应当发送的流，没有活跃的流时返回 false
+    bool next(uint16_t& streamId) const;
+
+    // 记账：流实际发出了 bytes 字节；退还未发出的部分时调用 refund
+    void charge(uint16_t streamId, uint64_t bytes);
+    void refund(uint16_t streamId, uint64_t bytes);
+
+    bool empty() const;
+
+    // 清空所有活跃状态（优先级设置保留）
+    void reset();
+
+private:
+    // 每字节推进的虚拟时间为 STRIDE_SCALE / weight
+    static constexpr uint64_t STRIDE_SCALE = 1 << 16;
+
+    // (优先级, 虚拟时间, 流编号)，最小者先发送
+    using Key = std::tuple<uint8_t, uint64_t, uint16_t>;
+
+    struct Stream {
+        uint8_t priority = DEFAULT_PRIORITY;
+        uint16_t weight = DEFAULT_WEIGHT;
+        uint64_t pass = 0;
+        bool active = false;
+        // 不活跃时保存从 order 中摘下的节点，重新激活时复用，稳定状态下调度不分配内存
+        std::set<Key>::node_type node;
+    };
+
+    std::unordered_map<uint16_t, Stream> streams;
+    std::set<Key> order;
+    uint64_t virtualTime;
+
+    void update(uint16_t streamId, Stream& stream, uint8_t priority, uint64_t pass);
+};
+
+#endif // STREAM_SCHEDULER_H
@@ -1,6 +1,7 @@
 #ifndef TCP_CHUNK_OPTIMIZATION_H
 #define TCP_CHUNK_OPTIMIZATION_H
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
@@ -26,10 +27,19 @@ public:
     // 获取当前最优分块大小
     uint32_t getCurrentOptimalChunkSize() const;
 
+    // 小消息合并：待发送的数据不足一个最优分块时最多等待 delayMicros 微秒，
+    // 期间到达的消息拼进同一次写出；0 表示不合并（默认）
+    void setCoalescingDelay(uint32_t delayMicros);
+    uint32_t getCoalescingDelay() const;
+
+    // 合并中的数据是否应当立即写出：已凑够一个最优分块，或最早的数据已等待到期
+    bool shouldFlush(size_t pendingBytes, int64_t waitedMicros) const;
+
 private:
     uint32_t maxChunkSize;
     uint32_t minChunkSize;
     uint32_t currentChunkSize;
+    uint32_t coalescingDelay;
     
     // 计算最优分块大小
     uint32_t calculateOptimalChunkSize(double networkQuality);
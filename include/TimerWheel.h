@@ -0,0 +1,49 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// 哈希时间轮：定时器按到期刻度散列到固定数量的槽位，增加/取消/到期都是 O(1)
+// 大量连接的发送节拍共享一个时间轮，由一个按最早到期时刻设置的 timerfd 驱动；非线程安全，由所属的事件循环线程调用
+class TimerWheel {
+public:
+    using Task = std::function<void()>;
+    using TimerId = uint64_t;
+
+    explicit TimerWheel(int64_t tickMicros = 100, size_t slotCount = 1024);
+
+    // 在 nowMicros + delayMicros 之后执行 task（至少推迟到下一个刻度），返回实际的到期时刻（微秒）
+    int64_t add(TimerId id, int64_t nowMicros, int64_t delayMicros, Task task);
+
+    // 取消尚未执行的定时器，定时器不存在时返回 false
+    bool cancel(TimerId id);
+
+    // 推进到 nowMicros 并执行所有到期的任务，返回执行的数量
+    size_t advance(int64_t nowMicros);
+
+    // 最早到期的定时器的到期时刻（微秒），没有定时器时返回 -1
+    int64_t nextExpiry() const;
+
+    bool empty() const;
+    size_t size() const;
+    int64_t getTickMicros() const;
+
+private:
+    struct Timer {
+        uint64_t expireTick;
+        Task task;
+    };
+
+    int64_t tickMicros;
+    uint64_t currentTick;
+    bool started;
+    std::vector<std::vector<TimerId>> slots;
+    // 槽位只保存编号，取消时直接从这里删除，槽位中的失效编号在扫描时跳过
+    std::unordered_map<TimerId, Timer> timers;
+};
+
+#endif // TIMER_WHEEL_H
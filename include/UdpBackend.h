@@ -0,0 +1,71 @@
+#ifndef UDP_BACKEND_H
+#define UDP_BACKEND_H
+
+#include "SocketBackend.h"
+#include "EventLoop.h"
+#include "CongestionController.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+// Linux 后端：基于 UDP 的可靠传输，每个连接仍是有序的字节流，Protocol 的分帧与多路复用照常工作
+// 每个数据包带单调递增的包序号（重传使用新序号，RTT 采样没有歧义）和数据在流中的偏移，
+// 接收方用选择确认（SACK）的包序号区间回复，发送方按包序号阈值和时间阈值判定丢包并只重传丢失的部分，
+// 约一个 RTT 没有新确认时先发尾部探测，仍无进展才按 Jacobson/Karels 估计的 RTO 超时并指数退避。
+// 发送窗口与节拍由本连接自己的 CongestionController 决定，控制器看到的是真实的确认与丢包，而不是内核 TCP 的统计。
+// 数据包经 sendmmsg 批量发出，内核支持时同一批次中等长的包合并为一次 UDP GSO 发送；接收使用 recvmmsg，
+// 一批数据包处理完后每个连接只回复一个确认，服务端发往各个对端的确认也合并为一次 sendmmsg。
+// 所有收包与定时器都在 EventLoop 线程中处理
+class UdpBackend : public SocketBackend {
+public:
+    struct Config {
+        size_t maxDatagramSize = 1400;          // UDP 负载上限（含包头），路径 MTU 较小（隧道等）时调低
+        size_t sendBufferSize = 4 << 20;        // 每个连接的发送缓冲区（未确认的数据），写满时 send 返回 WOULD_BLOCK
+        size_t receiveBufferSize = 4 << 20;     // 每个连接的接收缓冲区，即通告给对端的流量控制窗口
+        size_t socketBufferSize = 4 << 20;      // 内核套接字缓冲区（SO_SNDBUF/SO_RCVBUF），受 wmem_max/rmem_max 限制
+        // 有丢包的长距离链路上 BBR 不把随机丢包当作拥塞信号，能保持较高的有效吞吐
+        CongestionController::Type congestionControl = CongestionController::Type::BBR;
+        bool gso = true;                        // 使用 UDP GSO（UDP_SEGMENT），内核或网卡不支持时自动退回逐包发送
+        uint32_t initialRtoMicros = 1000000;    // 还没有 RTT 样本时的重传超时，也用于握手
+        uint32_t minRtoMicros = 200000;
+        uint32_t maxRtoMicros = 60000000;
+        unsigned maxTimeouts = 8;               // 连续超时（期间没有任何新确认）的次数上限，超过后连接失败
+        // 这么长时间没有收到对端任何数据包时连接失败，0 表示不限；空闲的连接每三分之一个超时互发一次保活
+        uint32_t idleTimeoutMicros = 30000000;
+    };
+
+    // 服务端接受的连接，在 EventLoop 线程中调用；套接字可交给 Protocol(backend, std::move(socket))
+    using AcceptHandler = std::function<void(std::unique_ptr<TransportSocket> socket)>;
+
+    // loop 为空时使用 EventLoop::getShared()
+    explicit UdpBackend(std::shared_ptr<EventLoop> loop = nullptr);
+    UdpBackend(const Config& config, std::shared_ptr<EventLoop> loop = nullptr);
+    ~UdpBackend() override;
+
+    std::unique_ptr<TransportSocket> createSocket() override;
+    const char* name() const override;
+    bool runAfter(int64_t delayMicros, std::function<void()> task) override;
+
+    std::shared_ptr<EventLoop> getLoop() const;
+    const Config& getConfig() const;
+
+    // 在 host:port 上接受连接，返回实际绑定的端口（port 为 0 时由内核选择），失败时返回 0。
+    // 套接字设置了 SO_REUSEPORT，多个后端（例如每个核心一个）可以监听同一个端口，内核按四元组把对端分给它们
+    uint16_t listen(const std::string& host, uint16_t port, AcceptHandler handler);
+
+    // 停止接受新连接，已经接受的连接不受影响
+    void stopListening();
+
+    // 停止接受新连接，并立即结束所有已经接受的连接（通知对端，不再等待未确认的数据），
+    // 应用随后读写得到 FAILED；服务端停止时调用，连接的缓冲区随应用释放套接字而回收
+    void closeAccepted();
+
+private:
+    struct State;
+
+    std::shared_ptr<State> state;
+};
+
+#endif // UDP_BACKEND_H
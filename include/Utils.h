@@ -13,11 +13,18 @@ public:
     // 测量网络带宽
     static double measureBandwidth(const std::string& host, uint16_t port);
     
-    // 检查网络连接状态
+    // 检查网络连接状态（阻塞探测单个主机；大量节点的持续检查见 HealthChecker）
     static bool checkConnection(const std::string& host, uint16_t port);
     
-    // 计算校验和
+    // 计算校验和（CRC32C）
     static uint32_t calculateChecksum(const std::vector<uint8_t>& data);
+    static uint32_t calculateChecksum(const uint8_t* data, size_t length);
+    
+    // 增量计算 CRC32C：初始值为0，crc32cUpdate(crc32cUpdate(0, a), b) 等于 a+b 整体的校验和
+    static uint32_t crc32cUpdate(uint32_t crc, const uint8_t* data, size_t length);
+    
+    // 当前CPU是否支持硬件 CRC32C 指令
+    static bool isCrc32cHardwareAccelerated();
     
     // 转换地址格式
     static bool isValidIpAddress(const std::string& ipAddress);
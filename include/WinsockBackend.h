@@ -0,0 +1,16 @@
+#ifndef WINSOCK_BACKEND_H
+#define WINSOCK_BACKEND_H
+
+#include "SocketBackend.h"
+
+// Windows 后端：非阻塞 winsock 套接字，等待时使用 select
+class WinsockBackend : public SocketBackend {
+public:
+    WinsockBackend();
+    ~WinsockBackend() override;
+
+    std::unique_ptr<TransportSocket> createSocket() override;
+    const char* name() const override;
+};
+
+#endif // WINSOCK_BACKEND_H
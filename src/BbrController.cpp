@@ -0,0 +1,221 @@
+#include "BbrController.h"
+#include <algorithm>
+
+namespace {
+    // PROBE_BW 的增益周期：一个 RTT 探测更多带宽，一个 RTT 排空，其余匀速
+    const double PROBE_BW_GAINS[] = {1.25, 0.75, 1, 1, 1, 1, 1, 1};
+    const size_t PROBE_BW_CYCLE = sizeof(PROBE_BW_GAINS) / sizeof(PROBE_BW_GAINS[0]);
+}
+
+BbrController::BbrController(uint32_t mss)
+    : mss(mss)
+{
+    reset();
+}
+
+void BbrController::onAck(const AckEvent& event) {
+    int64_t now = event.timestampMicros;
+    delivered += event.bytesAcked;
+
+    updateRound(event);
+    checkFullPipe();
+
+    bool minRttExpired = minRttStamp >= 0 && now > minRttStamp + MIN_RTT_WINDOW_MICROS;
+    if (event.rttMicros > 0 && (minRttMicros == 0 || event.rttMicros <= minRttMicros || minRttExpired)) {
+        minRttMicros = event.rttMicros;
+        minRttStamp = now;
+    }
+
+    updateMode(event, minRttExpired);
+    updateCongestionWindow(event);
+}
+
+void BbrController::onLoss(const LossEvent& event) {
+    // BBR 不把普通丢包当作拥塞信号；超时说明路径状态未知，先收缩到最小窗口，
+    // 之后随确认逐步恢复到模型窗口
+    if (event.timeout) {
+        priorCwnd = std::max(priorCwnd, cwnd);
+        cwnd = MIN_WINDOW * mss;
+    }
+}
+
+uint64_t BbrController::getCongestionWindow() const {
+    return cwnd;
+}
+
+uint64_t BbrController::getPacingRate() const {
+    if (btlBw > 0) {
+        return static_cast<uint64_t>(pacingGain * btlBw);
+    }
+    if (minRttMicros > 0) {
+        // 还没有带宽样本时按初始窗口每个 RTT 发完估计
+        return static_cast<uint64_t>(pacingGain * INITIAL_WINDOW * mss * 1e6 / minRttMicros);
+    }
+    return 0;
+}
+
+void BbrController::reset() {
+    mode = Mode::STARTUP;
+    bwSamples.clear();
+    btlBw = 0;
+    minRttMicros = 0;
+    minRttStamp = -1;
+    delivered = 0;
+    roundCount = 0;
+    nextRoundDelivered = 0;
+    roundStartDelivered = 0;
+    roundStartTime = -1;
+    roundStart = false;
+    fullBw = 0;
+    fullBwCount = 0;
+    filledPipe = false;
+    pacingGain = HIGH_GAIN;
+    cwndGain = HIGH_GAIN;
+    cycleIndex = 0;
+    cycleStamp = 0;
+    probeRttDoneStamp = 0;
+    probeRttRoundDone = false;
+    cwnd = INITIAL_WINDOW * mss;
+    priorCwnd = 0;
+}
+
+void BbrController::updateRound(const AckEvent& event) {
+    roundStart = false;
+    if (delivered < nextRoundDelivered) {
+        if (event.deliveryRate > 0) {
+            updateBandwidth(static_cast<double>(event.deliveryRate));
+        }
+        return;
+    }
+
+    // 没有传输层速率采样时，用上一轮的投递量除以该轮时长估计投递速率
+    double sample = static_cast<double>(event.deliveryRate);
+    if (sample == 0 && roundStartTime >= 0 && event.timestampMicros > roundStartTime) {
+        sample = static_cast<double>(delivered - roundStartDelivered) * 1e6 /
+                 static_cast<double>(event.timestampMicros - roundStartTime);
+    }
+
+    roundCount++;
+    roundStart = true;
+    roundStartDelivered = delivered;
+    roundStartTime = event.timestampMicros;
+    nextRoundDelivered = delivered + std::max<uint64_t>(event.bytesInFlight, mss);
+
+    if (sample > 0) {
+        updateBandwidth(sample);
+    }
+}
+
+void BbrController::updateBandwidth(double sample) {
+    while (!bwSamples.empty() && bwSamples.back().second <= sample) {
+        bwSamples.pop_back();
+    }
+    bwSamples.emplace_back(roundCount, sample);
+    while (bwSamples.front().first + BW_WINDOW_ROUNDS < roundCount) {
+        bwSamples.pop_front();
+    }
+    btlBw = bwSamples.front().second;
+}
+
+void BbrController::checkFullPipe() {
+    if (filledPipe || !roundStart || btlBw == 0) {
+        return;
+    }
+    if (btlBw >= fullBw * 1.25) {
+        fullBw = btlBw;
+        fullBwCount = 0;
+        return;
+    }
+    if (++fullBwCount >= 3) {
+        filledPipe = true;
+    }
+}
+
+void BbrController::updateMode(const AckEvent& event, bool minRttExpired) {
+    int64_t now = event.timestampMicros;
+
+    if (mode == Mode::STARTUP && filledPipe) {
+        mode = Mode::DRAIN;
+        pacingGain = 1 / HIGH_GAIN;
+        cwndGain = HIGH_GAIN;
+    }
+    if (mode == Mode::DRAIN && event.bytesInFlight <= bdp()) {
+        enterProbeBw(now);
+    }
+
+    if (mode == Mode::PROBE_BW && minRttMicros > 0 && now - cycleStamp > minRttMicros) {
+        cycleIndex = (cycleIndex + 1) % PROBE_BW_CYCLE;
+        cycleStamp = now;
+        pacingGain = PROBE_BW_GAINS[cycleIndex];
+    }
+
+    if (minRttExpired && mode != Mode::PROBE_RTT) {
+        mode = Mode::PROBE_RTT;
+        pacingGain = 1;
+        cwndGain = 1;
+        priorCwnd = std::max(priorCwnd, cwnd);
+        probeRttDoneStamp = 0;
+    }
+
+    if (mode == Mode::PROBE_RTT) {
+        if (probeRttDoneStamp == 0 && event.bytesInFlight <= MIN_WINDOW * mss) {
+            // 在途数据降到最小窗口后再保持 200ms 且至少一轮
+            probeRttDoneStamp = now + PROBE_RTT_MICROS;
+            probeRttRoundDone = false;
+            nextRoundDelivered = delivered;
+        } else if (probeRttDoneStamp != 0) {
+            if (roundStart) {
+                probeRttRoundDone = true;
+            }
+            if (probeRttRoundDone && now > probeRttDoneStamp) {
+                minRttStamp = now;
+                cwnd = std::max(cwnd, priorCwnd);
+                priorCwnd = 0;
+                if (filledPipe) {
+                    enterProbeBw(now);
+                } else {
+                    mode = Mode::STARTUP;
+                    pacingGain = HIGH_GAIN;
+                    cwndGain = HIGH_GAIN;
+                }
+            }
+        }
+    }
+}
+
+void BbrController::updateCongestionWindow(const AckEvent& event) {
+    uint64_t minWindow = MIN_WINDOW * mss;
+    if (mode == Mode::PROBE_RTT) {
+        cwnd = minWindow;
+        return;
+    }
+
+    double estimate = bdp();
+    if (estimate == 0) {
+        // 还没有模型时按初始窗口
+        cwnd = std::max<uint64_t>(cwnd + (filledPipe ? 0 : event.bytesAcked), INITIAL_WINDOW * mss);
+        return;
+    }
+
+    // 额外留出3个 MSS 应对 ACK 聚合
+    uint64_t target = static_cast<uint64_t>(cwndGain * estimate) + 3 * mss;
+    if (filledPipe) {
+        cwnd = std::min(cwnd + event.bytesAcked, target);
+    } else if (cwnd < target || delivered < INITIAL_WINDOW * mss) {
+        cwnd += event.bytesAcked;
+    }
+    cwnd = std::max(cwnd, minWindow);
+}
+
+void BbrController::enterProbeBw(int64_t now) {
+    mode = Mode::PROBE_BW;
+    cwndGain = 2;
+    // 从排空阶段之外的随机相位开始，避免多条流同时探测
+    cycleIndex = (static_cast<size_t>(now) % (PROBE_BW_CYCLE - 1) + 2) % PROBE_BW_CYCLE;
+    cycleStamp = now;
+    pacingGain = PROBE_BW_GAINS[cycleIndex];
+}
+
+double BbrController::bdp() const {
+    return btlBw * minRttMicros / 1e6;
+}
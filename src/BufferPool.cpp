@@ -0,0 +1,201 @@
+#include "BufferPool.h"
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+struct Buffer::Block {
+    std::atomic<uint32_t> refs;
+    uint32_t sizeClass;
+    size_t capacity;
+    size_t size;
+    // 被借出期间持有所属的池；回到空闲表后置空，缓存的缓冲区不会让池无法销毁
+    std::shared_ptr<BufferPool> pool;
+
+    uint8_t* bytes() {
+        return reinterpret_cast<uint8_t*>(this + 1);
+    }
+};
+
+Buffer::Buffer(Block* block)
+    : block_(block)
+{
+}
+
+Buffer::Buffer(const Buffer& other)
+    : block_(other.block_)
+{
+    if (block_) {
+        block_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+Buffer::Buffer(Buffer&& other) noexcept
+    : block_(other.block_)
+{
+    other.block_ = nullptr;
+}
+
+Buffer& Buffer::operator=(const Buffer& other) {
+    if (this != &other) {
+        Buffer copy(other);
+        std::swap(block_, copy.block_);
+    }
+    return *this;
+}
+
+Buffer& Buffer::operator=(Buffer&& other) noexcept {
+    if (this != &other) {
+        reset();
+        block_ = other.block_;
+        other.block_ = nullptr;
+    }
+    return *this;
+}
+
+Buffer::~Buffer() {
+    reset();
+}
+
+uint8_t* Buffer::data() {
+    return block_ ? block_->bytes() : nullptr;
+}
+
+const uint8_t* Buffer::data() const {
+    return block_ ? block_->bytes() : nullptr;
+}
+
+size_t Buffer::size() const {
+    return block_ ? block_->size : 0;
+}
+
+size_t Buffer::capacity() const {
+    return block_ ? block_->capacity : 0;
+}
+
+bool Buffer::empty() const {
+    return size() == 0;
+}
+
+bool Buffer::unique() const {
+    return block_ && block_->refs.load(std::memory_order_acquire) == 1;
+}
+
+Buffer::operator bool() const {
+    return block_ != nullptr;
+}
+
+void Buffer::resize(size_t size) {
+    if (!block_ || size > block_->capacity) {
+        throw std::length_error("Buffer::resize exceeds capacity");
+    }
+    block_->size = size;
+}
+
+std::string Buffer::toString() const {
+    return std::string(reinterpret_cast<const char*>(data()), size());
+}
+
+void Buffer::reset() {
+    if (!block_) {
+        return;
+    }
+    Block* block = block_;
+    block_ = nullptr;
+    if (block->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    std::shared_ptr<BufferPool> pool = std::move(block->pool);
+    if (pool) {
+        pool->recycle(block);
+    } else {
+        BufferPool::destroy(block);
+    }
+}
+
+std::shared_ptr<BufferPool> BufferPool::create(size_t maxCachedBytes) {
+    return std::shared_ptr<BufferPool>(new BufferPool(maxCachedBytes));
+}
+
+BufferPool::BufferPool(size_t maxCachedBytes)
+    : maxCachedBytes(maxCachedBytes)
+    , cached(0)
+{
+}
+
+BufferPool::~BufferPool() {
+    for (auto& freeList : freeLists) {
+        for (Buffer::Block* block : freeList) {
+            destroy(block);
+        }
+    }
+}
+
+Buffer BufferPool::acquire(size_t capacity) {
+    uint32_t sizeClass = sizeClassFor(capacity);
+    Buffer::Block* block = nullptr;
+    if (sizeClass != UNPOOLED) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& freeList = freeLists[sizeClass];
+        if (!freeList.empty()) {
+            block = freeList.back();
+            freeList.pop_back();
+            cached -= block->capacity;
+        }
+    }
+
+    if (!block) {
+        size_t blockSize = (sizeClass != UNPOOLED) ? (MIN_BLOCK_SIZE << sizeClass) : capacity;
+        void* memory = ::operator new(sizeof(Buffer::Block) + blockSize);
+        block = new (memory) Buffer::Block();
+        block->sizeClass = sizeClass;
+        block->capacity = blockSize;
+    }
+
+    block->refs.store(1, std::memory_order_relaxed);
+    block->size = 0;
+    block->pool = shared_from_this();
+    return Buffer(block);
+}
+
+Buffer BufferPool::copyOf(const void* data, size_t length) {
+    Buffer buffer = acquire(length);
+    if (length > 0) {
+        std::memcpy(buffer.data(), data, length);
+    }
+    buffer.resize(length);
+    return buffer;
+}
+
+size_t BufferPool::cachedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return cached;
+}
+
+uint32_t BufferPool::sizeClassFor(size_t capacity) {
+    if (capacity > MAX_BLOCK_SIZE) {
+        return UNPOOLED;
+    }
+    uint32_t sizeClass = 0;
+    while ((MIN_BLOCK_SIZE << sizeClass) < capacity) {
+        sizeClass++;
+    }
+    return sizeClass;
+}
+
+void BufferPool::destroy(Buffer::Block* block) {
+    block->~Block();
+    ::operator delete(block);
+}
+
+void BufferPool::recycle(Buffer::Block* block) {
+    if (block->sizeClass != UNPOOLED) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (cached + block->capacity <= maxCachedBytes) {
+            freeLists[block->sizeClass].push_back(block);
+            cached += block->capacity;
+            return;
+        }
+    }
+    destroy(block);
+}
@@ -0,0 +1,105 @@
+#include "ChunkSizeTuner.h"
+#include <algorithm>
+#include <cmath>
+
+ChunkSizeTuner::ChunkSizeTuner(int64_t intervalMicros)
+    : interval(std::max<int64_t>(intervalMicros, 1))
+{
+    reset();
+}
+
+void ChunkSizeTuner::onSent(size_t bytes, int64_t nowMicros) {
+    if (intervalStart < 0) {
+        intervalStart = nowMicros;
+    }
+    if (blockedSince >= 0) {
+        blockedMicros += nowMicros - std::max(blockedSince, intervalStart);
+        blockedSince = -1;
+    }
+    intervalBytes += bytes;
+}
+
+void ChunkSizeTuner::onBlocked(int64_t nowMicros) {
+    if (intervalStart < 0) {
+        intervalStart = nowMicros;
+    }
+    if (blockedSince < 0) {
+        blockedSince = nowMicros;
+    }
+}
+
+void ChunkSizeTuner::onRtt(uint32_t rttMicros) {
+    if (rttMicros == 0) {
+        return;
+    }
+    latestRtt = rttMicros;
+    minRtt = (minRtt == 0) ? rttMicros : std::min(minRtt, rttMicros);
+}
+
+bool ChunkSizeTuner::update(TcpChunkOptimization& chunker, int64_t nowMicros) {
+    if (intervalStart < 0 || nowMicros - intervalStart < interval) {
+        return false;
+    }
+
+    int64_t elapsed = nowMicros - intervalStart;
+    int64_t blocked = blockedMicros;
+    if (blockedSince >= 0) {
+        // 周期结束时仍在阻塞，阻塞的部分计入本周期，剩下的留给下一周期
+        blocked += nowMicros - std::max(blockedSince, intervalStart);
+        blockedSince = nowMicros;
+    }
+    uint64_t bytes = intervalBytes;
+    intervalStart = nowMicros;
+    intervalBytes = 0;
+    blockedMicros = 0;
+
+    if (bytes == 0) {
+        // 整个周期都没有写出数据（空闲或一直阻塞），没有可用的样本
+        return false;
+    }
+
+    // 发送阻塞过的周期受限于网络，速率反映路径容量；从未阻塞的周期受限于应用自身的发送量，
+    // 只有高于现有估计时才采用，否则旧的容量样本会被空闲的周期挤出窗口
+    double rate = bytes * 1e6 / elapsed;
+    double maxRate = *std::max_element(rates.begin(), rates.end());
+    if (blocked > 0 || rate >= maxRate) {
+        rates[rateIndex] = rate;
+        rateIndex = (rateIndex + 1) % RATE_WINDOW;
+        maxRate = std::max(maxRate, rate);
+    }
+
+    double sample = 1.0;
+    if (minRtt > 0) {
+        double baseRtt = std::max(minRtt, MIN_RTT_FLOOR_MICROS);
+        double bdp = maxRate * baseRtt / 1e6;
+        sample = std::min(1.0, bdp / FULL_QUALITY_BDP) * baseRtt / std::max<double>(latestRtt, baseRtt);
+    } else if (blocked > 0) {
+        // 没有 RTT 时无法估计带宽时延积，退而按阻塞的时间占比估计
+        sample = 1.0 - std::min(1.0, static_cast<double>(blocked) / elapsed);
+    }
+
+    quality = (quality < 0) ? sample : quality + SMOOTHING * (sample - quality);
+    if (appliedQuality >= 0 && std::fabs(quality - appliedQuality) < HYSTERESIS) {
+        return false;
+    }
+    appliedQuality = quality;
+    chunker.adjustChunkSize(quality);
+    return true;
+}
+
+double ChunkSizeTuner::getQuality() const {
+    return quality;
+}
+
+void ChunkSizeTuner::reset() {
+    intervalStart = -1;
+    intervalBytes = 0;
+    blockedMicros = 0;
+    blockedSince = -1;
+    rates.fill(0);
+    rateIndex = 0;
+    latestRtt = 0;
+    minRtt = 0;
+    quality = -1;
+    appliedQuality = -1;
+}
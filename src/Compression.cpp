@@ -0,0 +1,331 @@
+#include "Compression.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#if defined(HAVE_LZ4)
+#include <lz4.h>
+#endif
+
+namespace {
+    // LZ4 块格式的约束：匹配至少 4 字节，最后 5 字节总是字面量，最后一个匹配至少在结尾前 12 字节开始
+    constexpr size_t MIN_MATCH = 4;
+    constexpr size_t LAST_LITERALS = 5;
+    constexpr size_t MATCH_FIND_LIMIT = 12;
+    constexpr size_t MAX_OFFSET = 65535;
+
+    // 4096 项的哈希表（16KB）放在栈上，压缩不需要分配内存，也不需要跨调用保存状态
+    constexpr unsigned HASH_BITS = 12;
+    // 连续未命中时逐渐加大步长，不可压缩的数据很快扫过
+    constexpr unsigned SKIP_TRIGGER = 6;
+
+    uint32_t read32(const uint8_t* p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    uint32_t hashSequence(uint32_t sequence) {
+        return (sequence * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    // 从 a、b 开始的相同字节数，最多比较到 limit（a 之后的字节数）
+    size_t commonLength(const uint8_t* a, const uint8_t* b, size_t limit) {
+        size_t length = 0;
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        while (length + 8 <= limit) {
+            uint64_t x, y;
+            std::memcpy(&x, a + length, sizeof(x));
+            std::memcpy(&y, b + length, sizeof(y));
+            if (x != y) {
+                return length + (__builtin_ctzll(x ^ y) >> 3);
+            }
+            length += 8;
+        }
+#endif
+        while (length < limit && a[length] == b[length]) {
+            length++;
+        }
+        return length;
+    }
+
+    // 长度字段超过 15 的部分按 255 一个字节追加
+    void writeLength(uint8_t*& op, size_t length) {
+        while (length >= 255) {
+            *op++ = 255;
+            length -= 255;
+        }
+        *op++ = static_cast<uint8_t>(length);
+    }
+
+    // 写出一个序列：字面量，以及（matchLength > 0 时）一个匹配；输出空间不够时返回 false
+    bool writeSequence(uint8_t*& op, const uint8_t* end, const uint8_t* literals, size_t literalLength,
+                       size_t offset, size_t matchLength) {
+        size_t needed = 1 + literalLength / 255 + 1 + literalLength + (matchLength > 0 ? 2 + matchLength / 255 + 1 : 0);
+        if (static_cast<size_t>(end - op) < needed) {
+            return false;
+        }
+
+        uint8_t* token = op++;
+        *token = static_cast<uint8_t>(std::min<size_t>(literalLength, 15) << 4);
+        if (literalLength >= 15) {
+            writeLength(op, literalLength - 15);
+        }
+        std::memcpy(op, literals, literalLength);
+        op += literalLength;
+
+        if (matchLength > 0) {
+            *op++ = static_cast<uint8_t>(offset);
+            *op++ = static_cast<uint8_t>(offset >> 8);
+            size_t code = matchLength - MIN_MATCH;
+            *token |= static_cast<uint8_t>(std::min<size_t>(code, 15));
+            if (code >= 15) {
+                writeLength(op, code - 15);
+            }
+        }
+        return true;
+    }
+
+    // 贪心匹配的 LZ4 块压缩
+    size_t compressBuiltin(const uint8_t* in, size_t length, uint8_t* out, size_t capacity) {
+        uint8_t* op = out;
+        const uint8_t* end = out + capacity;
+        size_t anchor = 0;
+
+        if (length > MATCH_FIND_LIMIT) {
+            uint32_t table[1u << HASH_BITS] = {};
+            const size_t matchStartLimit = length - MATCH_FIND_LIMIT;
+            const size_t matchEndLimit = length - LAST_LITERALS;
+            size_t ip = 0;
+            unsigned attempts = 1u << SKIP_TRIGGER;
+
+            while (ip < matchStartLimit) {
+                uint32_t sequence = read32(in + ip);
+                uint32_t& slot = table[hashSequence(sequence)];
+                size_t candidate = slot;
+                slot = static_cast<uint32_t>(ip);
+
+                if (candidate >= ip || ip - candidate > MAX_OFFSET || read32(in + candidate) != sequence) {
+                    ip += attempts++ >> SKIP_TRIGGER;
+                    continue;
+                }
+
+                // 向前扩展匹配，吃掉与匹配源相同的字面量
+                while (ip > anchor && candidate > 0 && in[ip - 1] == in[candidate - 1]) {
+                    ip--;
+                    candidate--;
+                }
+                size_t matchLength = MIN_MATCH +
+                    commonLength(in + ip + MIN_MATCH, in + candidate + MIN_MATCH, matchEndLimit - ip - MIN_MATCH);
+
+                if (!writeSequence(op, end, in + anchor, ip - anchor, ip - candidate, matchLength)) {
+                    return 0;
+                }
+                ip += matchLength;
+                anchor = ip;
+                attempts = 1u << SKIP_TRIGGER;
+                // 匹配末尾附近的位置也放进哈希表，紧接着的重复更容易被找到
+                if (ip < matchStartLimit) {
+                    table[hashSequence(read32(in + ip - 2))] = static_cast<uint32_t>(ip - 2);
+                }
+            }
+        }
+
+        if (!writeSequence(op, end, in + anchor, length - anchor, 0, 0)) {
+            return 0;
+        }
+        return static_cast<size_t>(op - out);
+    }
+
+    bool readLength(const uint8_t* in, size_t length, size_t& ip, size_t& value) {
+        uint8_t byte;
+        do {
+            if (ip >= length) {
+                return false;
+            }
+            byte = in[ip++];
+            value += byte;
+        } while (byte == 255);
+        return true;
+    }
+
+    bool decompressBuiltin(const uint8_t* in, size_t length, uint8_t* out, size_t rawLength) {
+        size_t ip = 0;
+        size_t op = 0;
+        while (ip < length) {
+            uint8_t token = in[ip++];
+
+            size_t literalLength = token >> 4;
+            if (literalLength == 15 && !readLength(in, length, ip, literalLength)) {
+                return false;
+            }
+            if (literalLength > length - ip || literalLength > rawLength - op) {
+                return false;
+            }
+            std::memcpy(out + op, in + ip, literalLength);
+            ip += literalLength;
+            op += literalLength;
+
+            // 最后一个序列只有字面量
+            if (ip == length) {
+                return op == rawLength;
+            }
+
+            if (length - ip < 2) {
+                return false;
+            }
+            size_t offset = in[ip] | (static_cast<size_t>(in[ip + 1]) << 8);
+            ip += 2;
+            if (offset == 0 || offset > op) {
+                return false;
+            }
+
+            size_t matchLength = token & 15;
+            if (matchLength == 15 && !readLength(in, length, ip, matchLength)) {
+                return false;
+            }
+            matchLength += MIN_MATCH;
+            if (matchLength > rawLength - op) {
+                return false;
+            }
+
+            // 源与目标重叠时（offset < matchLength）数据以 offset 为周期重复：每次按周期的整数倍往回取，
+            // 一次最多拷贝一个距离，源与目标不重叠；拷贝后周期性的部分加倍，距离也随之加倍
+            size_t distance = offset;
+            while (matchLength > 0) {
+                size_t n = std::min(matchLength, distance);
+                std::memcpy(out + op, out + op - distance, n);
+                op += n;
+                matchLength -= n;
+                distance *= 2;
+            }
+        }
+        return false;
+    }
+
+    void writeUint32(uint8_t* out, uint32_t value) {
+        out[0] = static_cast<uint8_t>(value >> 24);
+        out[1] = static_cast<uint8_t>(value >> 16);
+        out[2] = static_cast<uint8_t>(value >> 8);
+        out[3] = static_cast<uint8_t>(value);
+    }
+
+    uint32_t readUint32(const uint8_t* in) {
+        return (static_cast<uint32_t>(in[0]) << 24) | (static_cast<uint32_t>(in[1]) << 16) |
+               (static_cast<uint32_t>(in[2]) << 8) | static_cast<uint32_t>(in[3]);
+    }
+}
+
+size_t Lz4Codec::compressBound(size_t length) {
+    return length + length / 255 + 16;
+}
+
+size_t Lz4Codec::compress(const uint8_t* in, size_t length, uint8_t* out, size_t capacity) {
+#if defined(HAVE_LZ4)
+    if (length <= static_cast<size_t>(LZ4_MAX_INPUT_SIZE)) {
+        int written = LZ4_compress_default(reinterpret_cast<const char*>(in), reinterpret_cast<char*>(out),
+                                           static_cast<int>(length),
+                                           static_cast<int>(std::min<size_t>(capacity, INT_MAX)));
+        return written > 0 ? static_cast<size_t>(written) : 0;
+    }
+#endif
+    return compressBuiltin(in, length, out, capacity);
+}
+
+bool Lz4Codec::decompress(const uint8_t* in, size_t length, uint8_t* out, size_t rawLength) {
+#if defined(HAVE_LZ4)
+    if (length <= INT_MAX && rawLength <= INT_MAX) {
+        int decoded = LZ4_decompress_safe(reinterpret_cast<const char*>(in), reinterpret_cast<char*>(out),
+                                          static_cast<int>(length), static_cast<int>(rawLength));
+        return decoded >= 0 && static_cast<size_t>(decoded) == rawLength;
+    }
+#endif
+    return decompressBuiltin(in, length, out, rawLength);
+}
+
+bool Lz4Codec::isLibraryAvailable() {
+#if defined(HAVE_LZ4)
+    return true;
+#else
+    return false;
+#endif
+}
+
+ChunkCompressor::ChunkCompressor()
+    : ChunkCompressor(Config())
+{
+}
+
+ChunkCompressor::ChunkCompressor(const Config& config)
+    : config(config)
+{
+    reset();
+}
+
+void ChunkCompressor::setConfig(const Config& newConfig) {
+    config = newConfig;
+    config.minSavings = std::min(std::max(config.minSavings, 0.0), 0.9);
+    config.maxBypass = std::max<uint32_t>(config.maxBypass, 1);
+    bypassSpan = 0;
+    bypassRemaining = 0;
+}
+
+const ChunkCompressor::Config& ChunkCompressor::getConfig() const {
+    return config;
+}
+
+size_t ChunkCompressor::outputCapacity(size_t length) {
+    // 压缩后必须比原始分块小才会被采用
+    return length;
+}
+
+size_t ChunkCompressor::compress(const uint8_t* chunk, size_t length, uint8_t* out, size_t capacity) {
+    if (length < std::max(config.minChunkSize, PREFIX_SIZE + 1)) {
+        return 0;
+    }
+    if (bypassRemaining > 0) {
+        bypassRemaining--;
+        stats.bypassed++;
+        return 0;
+    }
+
+    stats.attempts++;
+    // 输出上限即要求的压缩率，达不到时压缩器中途放弃，不可压缩的分块不会被完整处理一遍
+    size_t limit = length - static_cast<size_t>(length * config.minSavings);
+    limit = std::min(std::min(limit, length - 1), capacity);
+    size_t written = limit > PREFIX_SIZE ? Lz4Codec::compress(chunk, length, out + PREFIX_SIZE, limit - PREFIX_SIZE) : 0;
+    if (written == 0) {
+        bypassSpan = bypassSpan == 0 ? 1 : std::min(bypassSpan * 2, config.maxBypass);
+        bypassRemaining = bypassSpan;
+        return 0;
+    }
+
+    bypassSpan = 0;
+    out[0] = CODEC_LZ4;
+    writeUint32(out + 1, static_cast<uint32_t>(length));
+    stats.compressed++;
+    stats.rawBytes += length;
+    stats.compressedBytes += PREFIX_SIZE + written;
+    return PREFIX_SIZE + written;
+}
+
+bool ChunkCompressor::rawLength(const uint8_t* payload, size_t length, size_t& rawLength) {
+    if (length < PREFIX_SIZE || payload[0] != CODEC_LZ4) {
+        return false;
+    }
+    rawLength = readUint32(payload + 1);
+    return true;
+}
+
+bool ChunkCompressor::decompress(const uint8_t* payload, size_t length, uint8_t* out, size_t rawLength) {
+    return Lz4Codec::decompress(payload + PREFIX_SIZE, length - PREFIX_SIZE, out, rawLength);
+}
+
+const ChunkCompressor::Stats& ChunkCompressor::getStats() const {
+    return stats;
+}
+
+void ChunkCompressor::reset() {
+    setConfig(config);
+    stats = Stats();
+}
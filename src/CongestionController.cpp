@@ -0,0 +1,17 @@
+#include "CongestionController.h"
+#include "RenoController.h"
+#include "CubicController.h"
+#include "BbrController.h"
+#include <stdexcept>
+
+std::unique_ptr<CongestionController> CongestionController::create(Type type, uint32_t mss) {
+    switch (type) {
+        case Type::RENO:
+            return std::unique_ptr<CongestionController>(new RenoController(mss));
+        case Type::CUBIC:
+            return std::unique_ptr<CongestionController>(new CubicController(mss));
+        case Type::BBR:
+            return std::unique_ptr<CongestionController>(new BbrController(mss));
+    }
+    throw std::invalid_argument("Unknown congestion controller type");
+}
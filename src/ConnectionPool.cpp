@@ -0,0 +1,341 @@
+#include "ConnectionPool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Endpoint = std::pair<std::string, uint16_t>;
+
+int64_t nowMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+} // namespace
+
+struct ConnectionPool::State {
+    struct IdleConnection {
+        std::unique_ptr<Protocol> protocol;
+        int64_t idleSinceMs;
+    };
+
+    Config config;
+    std::shared_ptr<SocketBackend> backend;
+
+    mutable std::mutex mutex;
+    std::condition_variable cond;
+    // 节点 -> 空闲连接；尾部是最近归还的，借用时优先取，头部的连接空闲最久，回收时先从头部开始
+    std::map<Endpoint, std::deque<IdleConnection>> idle;
+    std::atomic<bool> stopping{false};
+    // 节点集合有变化，维护线程应立即处理；初始为 true 以便立刻预热已有的节点
+    bool nodesChanged = true;
+    // 节点最近一次预热失败的时刻，只由维护线程访问；预热时按它排序，
+    // 从未失败的节点优先，不可达的节点轮流尝试，不会一直挡住其他节点
+    std::map<Endpoint, int64_t> warmFailedAt;
+
+    std::unique_ptr<Protocol> take(const Endpoint& endpoint);
+    void giveBack(const Endpoint& endpoint, std::unique_ptr<Protocol> protocol);
+};
+
+// 取出一条仍然可用的空闲连接，途中遇到对端已关闭的连接顺便丢弃
+std::unique_ptr<Protocol> ConnectionPool::State::take(const Endpoint& endpoint) {
+    // 先于锁声明，失效连接在解锁之后才关闭
+    std::vector<std::unique_ptr<Protocol>> stale;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = idle.find(endpoint);
+    if (it == idle.end()) {
+        return nullptr;
+    }
+    auto& queue = it->second;
+    while (!queue.empty()) {
+        std::unique_ptr<Protocol> protocol = std::move(queue.back().protocol);
+        queue.pop_back();
+        if (protocol->isConnected()) {
+            return protocol;
+        }
+        stale.push_back(std::move(protocol));
+    }
+    return nullptr;
+}
+
+// 归还连接，连接已失效、连接池正在关闭或该节点空闲连接已满时直接关闭
+void ConnectionPool::State::giveBack(const Endpoint& endpoint, std::unique_ptr<Protocol> protocol) {
+    if (!protocol->isConnected() || stopping) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    // 节点若已被移除，这里会重新建出一项，下一轮维护时清理
+    auto& queue = idle[endpoint];
+    if (queue.size() >= config.maxIdle) {
+        return;
+    }
+    queue.push_back({std::move(protocol), nowMillis()});
+}
+
+ConnectionPool::Connection::Connection(std::weak_ptr<State> state, LoadBalancer::Lease lease,
+                                       std::unique_ptr<Protocol> protocol)
+    : state_(std::move(state))
+    , lease_(std::move(lease))
+    , protocol_(std::move(protocol))
+{
+}
+
+ConnectionPool::Connection::~Connection() {
+    release();
+}
+
+ConnectionPool::Connection& ConnectionPool::Connection::operator=(Connection&& other) noexcept {
+    if (this != &other) {
+        release();
+        state_ = std::move(other.state_);
+        lease_ = std::move(other.lease_);
+        protocol_ = std::move(other.protocol_);
+        reusable_ = other.reusable_;
+    }
+    return *this;
+}
+
+void ConnectionPool::Connection::invalidate() {
+    reusable_ = false;
+}
+
+void ConnectionPool::Connection::release() {
+    if (protocol_) {
+        // 连接池已销毁时 lock 失败，连接随 protocol_ 一起关闭
+        auto state = state_.lock();
+        if (state && reusable_) {
+            state->giveBack({lease_.address(), lease_.port()}, std::move(protocol_));
+        }
+        protocol_.reset();
+    }
+    lease_.release();
+    state_.reset();
+}
+
+ConnectionPool::ConnectionPool(LoadBalancer& balancer)
+    : ConnectionPool(balancer, Config())
+{
+}
+
+ConnectionPool::ConnectionPool(LoadBalancer& balancer, const Config& config, std::shared_ptr<SocketBackend> backend)
+    : balancer(balancer)
+    , state(std::make_shared<State>())
+    , listenerId(0)
+{
+    state->config = config;
+    state->backend = backend ? std::move(backend) : SocketBackend::getDefault();
+
+    // 回调只唤醒维护线程，实际的预热与清理都以维护线程读到的活跃节点为准，不依赖事件到达的顺序
+    std::weak_ptr<State> weakState = state;
+    listenerId = balancer.addNodeListener([weakState](LoadBalancer::NodeEvent, const std::string&, uint16_t) {
+        auto state = weakState.lock();
+        if (!state) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->nodesChanged = true;
+        }
+        state->cond.notify_all();
+    });
+
+    maintenanceThread = std::thread(&ConnectionPool::maintenanceLoop, this);
+}
+
+ConnectionPool::~ConnectionPool() {
+    balancer.removeNodeListener(listenerId);
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->stopping = true;
+    }
+    state->cond.notify_all();
+    maintenanceThread.join();
+
+    std::map<Endpoint, std::deque<State::IdleConnection>> idle;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        idle.swap(state->idle);
+    }
+}
+
+ConnectionPool::Connection ConnectionPool::acquire() {
+    for (int attempt = 0; attempt < MAX_ACQUIRE_ATTEMPTS; attempt++) {
+        Connection connection = acquireFrom(balancer.acquireNode());
+        if (connection) {
+            return connection;
+        }
+    }
+    throw std::runtime_error("Failed to connect to any node");
+}
+
+ConnectionPool::Connection ConnectionPool::acquire(const std::string& key) {
+    for (int attempt = 0; attempt < MAX_ACQUIRE_ATTEMPTS; attempt++) {
+        Connection connection = acquireFrom(balancer.acquireNode(key));
+        if (connection) {
+            return connection;
+        }
+    }
+    throw std::runtime_error("Failed to connect to any node");
+}
+
+size_t ConnectionPool::idleCount() const {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    size_t count = 0;
+    for (const auto& entry : state->idle) {
+        count += entry.second.size();
+    }
+    return count;
+}
+
+size_t ConnectionPool::idleCount(const std::string& address, uint16_t port) const {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    auto it = state->idle.find({address, port});
+    return it == state->idle.end() ? 0 : it->second.size();
+}
+
+// 优先复用所选节点的空闲连接，没有时当场建立；建立失败返回空连接，由调用方换一个节点重试
+ConnectionPool::Connection ConnectionPool::acquireFrom(LoadBalancer::Lease lease) {
+    Endpoint endpoint(lease.address(), lease.port());
+    std::unique_ptr<Protocol> protocol = state->take(endpoint);
+    if (!protocol) {
+        protocol = std::make_unique<Protocol>(state->backend);
+        if (!protocol->initializeConnection(endpoint.first, endpoint.second, state->config.connectTimeoutMs)) {
+            return Connection();
+        }
+    }
+    return Connection(state, std::move(lease), std::move(protocol));
+}
+
+void ConnectionPool::maintenanceLoop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->cond.wait_for(lock, std::chrono::milliseconds(state->config.maintenanceIntervalMs),
+                                 [this] { return state->stopping || state->nodesChanged; });
+            if (state->stopping) {
+                return;
+            }
+            state->nodesChanged = false;
+        }
+        maintain();
+    }
+}
+
+void ConnectionPool::maintain() {
+    std::vector<Endpoint> active = balancer.getActiveNodes();
+    std::sort(active.begin(), active.end());
+    const Config& config = state->config;
+
+    std::vector<std::unique_ptr<Protocol>> closing;
+    std::vector<Endpoint> warming;   // 每一项代表需要新建一条连接
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        int64_t now = nowMillis();
+        for (auto it = state->idle.begin(); it != state->idle.end();) {
+            auto& queue = it->second;
+            if (!std::binary_search(active.begin(), active.end(), it->first)) {
+                // 节点已移除或下线
+                for (auto& entry : queue) {
+                    closing.push_back(std::move(entry.protocol));
+                }
+                it = state->idle.erase(it);
+                continue;
+            }
+
+            // 对端已关闭（服务端重启、空闲超时主动断开等）的连接不等借用时才发现
+            for (auto entry = queue.begin(); entry != queue.end();) {
+                if (entry->protocol->isConnected()) {
+                    ++entry;
+                    continue;
+                }
+                closing.push_back(std::move(entry->protocol));
+                entry = queue.erase(entry);
+            }
+
+            while (queue.size() > config.minIdle && now - queue.front().idleSinceMs >= config.idleTimeoutMs) {
+                closing.push_back(std::move(queue.front().protocol));
+                queue.pop_front();
+            }
+            ++it;
+        }
+
+        for (const auto& endpoint : active) {
+            auto it = state->idle.find(endpoint);
+            size_t count = it == state->idle.end() ? 0 : it->second.size();
+            for (size_t i = count; i < config.minIdle; i++) {
+                warming.push_back(endpoint);
+            }
+        }
+    }
+    closing.clear();
+    if (warming.empty()) {
+        return;
+    }
+
+    // 同一节点的连接合为一组，最近失败过的节点排到后面
+    std::vector<std::pair<Endpoint, size_t>> groups;
+    for (const auto& endpoint : warming) {
+        if (!groups.empty() && groups.back().first == endpoint) {
+            groups.back().second++;
+        } else {
+            groups.emplace_back(endpoint, 1);
+        }
+    }
+    auto& failedAt = state->warmFailedAt;
+    for (auto it = failedAt.begin(); it != failedAt.end();) {
+        it = std::binary_search(active.begin(), active.end(), it->first) ? std::next(it) : failedAt.erase(it);
+    }
+    auto lastFailure = [&failedAt](const Endpoint& endpoint) {
+        auto it = failedAt.find(endpoint);
+        return it == failedAt.end() ? int64_t(0) : it->second;
+    };
+    std::stable_sort(groups.begin(), groups.end(),
+                     [&lastFailure](const std::pair<Endpoint, size_t>& a, const std::pair<Endpoint, size_t>& b) {
+                         return lastFailure(a.first) < lastFailure(b.first);
+                     });
+
+    // 建立连接可能要等到超时：在锁外由几个线程并行进行，不可达的节点不会串行累加等待时间；
+    // 只在一个连接超时之内发起新连接（一轮至多约两个超时），剩下的节点留到下一轮，回收与剔除不会被长时间推迟
+    // 同一节点失败一次后本轮不再尝试
+    int64_t deadline = nowMillis() + config.connectTimeoutMs;
+    std::atomic<size_t> nextGroup{0};
+    std::mutex failedMutex;
+    auto worker = [&] {
+        while (!state->stopping && nowMillis() < deadline) {
+            size_t index = nextGroup.fetch_add(1);
+            if (index >= groups.size()) {
+                return;
+            }
+            const Endpoint& endpoint = groups[index].first;
+            for (size_t i = 0; i < groups[index].second && !state->stopping && nowMillis() < deadline; i++) {
+                auto protocol = std::make_unique<Protocol>(state->backend);
+                if (!protocol->initializeConnection(endpoint.first, endpoint.second, config.connectTimeoutMs)) {
+                    std::lock_guard<std::mutex> lock(failedMutex);
+                    failedAt[endpoint] = nowMillis();
+                    break;
+                }
+                state->giveBack(endpoint, std::move(protocol));
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    size_t threadCount = std::min(groups.size(), MAX_WARMUP_THREADS);
+    for (size_t i = 1; i < threadCount; i++) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+}
@@ -0,0 +1,249 @@
+// NetworkUtils 的 CRC32C（Castagnoli，多项式 0x82F63B78）实现
+// x86-64 上运行时检测 SSE4.2，使用 crc32 指令三路并行计算；否则使用 slicing-by-8 查表
+#include "Utils.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CRC32C_X86 1
+#include <nmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace {
+
+const uint32_t CRC32C_POLY = 0x82F63B78;
+
+// 三路并行时每路处理的块大小
+const size_t CRC32C_LONG = 8192;
+const size_t CRC32C_SHORT = 256;
+
+// GF(2) 上 32x32 矩阵乘向量
+uint32_t gf2MatrixTimes(const uint32_t* mat, uint32_t vec) {
+    uint32_t sum = 0;
+    while (vec) {
+        if (vec & 1) {
+            sum ^= *mat;
+        }
+        vec >>= 1;
+        mat++;
+    }
+    return sum;
+}
+
+void gf2MatrixSquare(uint32_t* square, const uint32_t* mat) {
+    for (int n = 0; n < 32; n++) {
+        square[n] = gf2MatrixTimes(mat, mat[n]);
+    }
+}
+
+// 构造“在 crc 后追加 length 个零字节”的线性算子，length 必须是2的幂
+void zerosOperator(uint32_t* even, size_t length) {
+    uint32_t odd[32];
+
+    // 一个零比特的算子
+    odd[0] = CRC32C_POLY;
+    uint32_t row = 1;
+    for (int n = 1; n < 32; n++) {
+        odd[n] = row;
+        row <<= 1;
+    }
+
+    gf2MatrixSquare(even, odd);  // 2个零比特
+    gf2MatrixSquare(odd, even);  // 4个零比特
+
+    // 之后每次平方翻倍，第一次平方得到1个零字节
+    do {
+        gf2MatrixSquare(even, odd);
+        length >>= 1;
+        if (length == 0) {
+            return;
+        }
+        gf2MatrixSquare(odd, even);
+        length >>= 1;
+    } while (length);
+
+    std::memcpy(even, odd, sizeof(odd));
+}
+
+struct Crc32cTables {
+    uint32_t slicing[8][256];    // slicing-by-8 软件查表
+    uint32_t longShift[4][256];  // 移位 CRC32C_LONG 个零字节
+    uint32_t shortShift[4][256]; // 移位 CRC32C_SHORT 个零字节
+    bool hardware;
+
+    Crc32cTables() {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t crc = n;
+            for (int k = 0; k < 8; k++) {
+                crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+            }
+            slicing[0][n] = crc;
+        }
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t crc = slicing[0][n];
+            for (int k = 1; k < 8; k++) {
+                crc = slicing[0][crc & 0xff] ^ (crc >> 8);
+                slicing[k][n] = crc;
+            }
+        }
+
+        buildShiftTable(longShift, CRC32C_LONG);
+        buildShiftTable(shortShift, CRC32C_SHORT);
+
+        hardware = detectHardware();
+    }
+
+    static void buildShiftTable(uint32_t table[4][256], size_t length) {
+        uint32_t op[32];
+        zerosOperator(op, length);
+        for (uint32_t n = 0; n < 256; n++) {
+            table[0][n] = gf2MatrixTimes(op, n);
+            table[1][n] = gf2MatrixTimes(op, n << 8);
+            table[2][n] = gf2MatrixTimes(op, n << 16);
+            table[3][n] = gf2MatrixTimes(op, n << 24);
+        }
+    }
+
+    static bool detectHardware() {
+#if defined(CRC32C_X86) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 20)) != 0;
+#elif defined(CRC32C_X86)
+        return __builtin_cpu_supports("sse4.2");
+#else
+        return false;
+#endif
+    }
+};
+
+const Crc32cTables& tables() {
+    static const Crc32cTables instance;
+    return instance;
+}
+
+inline uint32_t shift(const uint32_t table[4][256], uint32_t crc) {
+    return table[0][crc & 0xff] ^ table[1][(crc >> 8) & 0xff] ^
+           table[2][(crc >> 16) & 0xff] ^ table[3][crc >> 24];
+}
+
+uint32_t crc32cSoftware(const Crc32cTables& t, uint32_t crc, const uint8_t* data, size_t length) {
+    while (length && (reinterpret_cast<uintptr_t>(data) & 7) != 0) {
+        crc = t.slicing[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+        length--;
+    }
+
+    // 按小端序一次处理8字节
+    while (length >= 8) {
+        uint32_t one;
+        uint32_t two;
+        std::memcpy(&one, data, 4);
+        std::memcpy(&two, data + 4, 4);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        one = __builtin_bswap32(one);
+        two = __builtin_bswap32(two);
+#endif
+        one ^= crc;
+        crc = t.slicing[7][one & 0xff] ^ t.slicing[6][(one >> 8) & 0xff] ^
+              t.slicing[5][(one >> 16) & 0xff] ^ t.slicing[4][one >> 24] ^
+              t.slicing[3][two & 0xff] ^ t.slicing[2][(two >> 8) & 0xff] ^
+              t.slicing[1][(two >> 16) & 0xff] ^ t.slicing[0][two >> 24];
+        data += 8;
+        length -= 8;
+    }
+
+    while (length--) {
+        crc = t.slicing[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#ifdef CRC32C_X86
+
+#if defined(__GNUC__)
+#define CRC32C_TARGET_SSE42 __attribute__((target("sse4.2")))
+#else
+#define CRC32C_TARGET_SSE42
+#endif
+
+inline uint64_t load64(const uint8_t* data) {
+    uint64_t value;
+    std::memcpy(&value, data, 8);
+    return value;
+}
+
+// 三条相互独立的 crc32 指令流水并行，再用移位表合并，隐藏指令的3周期延迟
+CRC32C_TARGET_SSE42
+uint32_t crc32cHardware(const Crc32cTables& t, uint32_t crc, const uint8_t* data, size_t length) {
+    uint64_t crc0 = crc;
+
+    while (length && (reinterpret_cast<uintptr_t>(data) & 7) != 0) {
+        crc0 = _mm_crc32_u8(static_cast<uint32_t>(crc0), *data++);
+        length--;
+    }
+
+    while (length >= CRC32C_LONG * 3) {
+        uint64_t crc1 = 0;
+        uint64_t crc2 = 0;
+        const uint8_t* end = data + CRC32C_LONG;
+        do {
+            crc0 = _mm_crc32_u64(crc0, load64(data));
+            crc1 = _mm_crc32_u64(crc1, load64(data + CRC32C_LONG));
+            crc2 = _mm_crc32_u64(crc2, load64(data + CRC32C_LONG * 2));
+            data += 8;
+        } while (data < end);
+        crc0 = shift(t.longShift, static_cast<uint32_t>(crc0)) ^ crc1;
+        crc0 = shift(t.longShift, static_cast<uint32_t>(crc0)) ^ crc2;
+        data += CRC32C_LONG * 2;
+        length -= CRC32C_LONG * 3;
+    }
+
+    while (length >= CRC32C_SHORT * 3) {
+        uint64_t crc1 = 0;
+        uint64_t crc2 = 0;
+        const uint8_t* end = data + CRC32C_SHORT;
+        do {
+            crc0 = _mm_crc32_u64(crc0, load64(data));
+            crc1 = _mm_crc32_u64(crc1, load64(data + CRC32C_SHORT));
+            crc2 = _mm_crc32_u64(crc2, load64(data + CRC32C_SHORT * 2));
+            data += 8;
+        } while (data < end);
+        crc0 = shift(t.shortShift, static_cast<uint32_t>(crc0)) ^ crc1;
+        crc0 = shift(t.shortShift, static_cast<uint32_t>(crc0)) ^ crc2;
+        data += CRC32C_SHORT * 2;
+        length -= CRC32C_SHORT * 3;
+    }
+
+    const uint8_t* end = data + (length - (length & 7));
+    while (data < end) {
+        crc0 = _mm_crc32_u64(crc0, load64(data));
+        data += 8;
+    }
+    length &= 7;
+
+    while (length--) {
+        crc0 = _mm_crc32_u8(static_cast<uint32_t>(crc0), *data++);
+    }
+    return static_cast<uint32_t>(crc0);
+}
+
+#endif // CRC32C_X86
+
+} // namespace
+
+uint32_t NetworkUtils::crc32cUpdate(uint32_t crc, const uint8_t* data, size_t length) {
+    const Crc32cTables& t = tables();
+    crc = ~crc;
+#ifdef CRC32C_X86
+    if (t.hardware) {
+        return ~crc32cHardware(t, crc, data, length);
+    }
+#endif
+    return ~crc32cSoftware(t, crc, data, length);
+}
+
+bool NetworkUtils::isCrc32cHardwareAccelerated() {
+    return tables().hardware;
+}
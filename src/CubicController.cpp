@@ -0,0 +1,99 @@
+#include "CubicController.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+CubicController::CubicController(uint32_t mss)
+    : mss(mss)
+{
+    reset();
+}
+
+void CubicController::onAck(const AckEvent& event) {
+    if (event.rttMicros > 0) {
+        lastRttMicros = event.rttMicros;
+        if (minRttMicros == 0 || event.rttMicros < minRttMicros) {
+            minRttMicros = event.rttMicros;
+        }
+    }
+
+    double acked = static_cast<double>(event.bytesAcked) / mss;
+    if (acked <= 0) {
+        return;
+    }
+
+    if (cwnd < ssthresh) {
+        // 慢启动：每确认一个 MSS 窗口加一个 MSS
+        cwnd += acked;
+        return;
+    }
+
+    if (epochStart < 0) {
+        epochStart = event.timestampMicros;
+        if (cwnd < wMax) {
+            k = std::cbrt((wMax - cwnd) / C);
+            originPoint = wMax;
+        } else {
+            k = 0;
+            originPoint = cwnd;
+        }
+        wEst = cwnd;
+    }
+
+    // 目标取一个 RTT 之后的三次函数值
+    double t = static_cast<double>(event.timestampMicros - epochStart + minRttMicros) / 1e6;
+    double target = originPoint + C * std::pow(t - k, 3);
+    target = std::min(target, cwnd * 1.5);
+
+    if (target > cwnd) {
+        cwnd += (target - cwnd) / cwnd * acked;
+    } else {
+        cwnd += acked / (100 * cwnd);
+    }
+
+    // Reno 友好区域：三次函数增长慢于 Reno 时按 Reno 增长
+    wEst += 3 * (1 - BETA) / (1 + BETA) * acked / cwnd;
+    cwnd = std::max(cwnd, wEst);
+}
+
+void CubicController::onLoss(const LossEvent& event) {
+    if (!event.timeout && event.timestampMicros < recoveryUntil) {
+        return;
+    }
+
+    epochStart = -1;
+    // 快速收敛：窗口还没回到上次的 W_max 就再次拥塞，说明有新的流加入，主动让出带宽
+    if (cwnd < wMax) {
+        wMax = cwnd * (1 + BETA) / 2;
+    } else {
+        wMax = cwnd;
+    }
+    ssthresh = std::max(cwnd * BETA, MIN_WINDOW);
+    cwnd = event.timeout ? 1 : ssthresh;
+    recoveryUntil = event.timestampMicros + std::max(lastRttMicros, minRttMicros);
+}
+
+uint64_t CubicController::getCongestionWindow() const {
+    return static_cast<uint64_t>(std::max(cwnd, 1.0) * mss);
+}
+
+uint64_t CubicController::getSlowStartThreshold() const {
+    // 第一次拥塞事件之前阈值为无穷大
+    if (ssthresh == std::numeric_limits<double>::max()) {
+        return 0;
+    }
+    return static_cast<uint64_t>(ssthresh * mss);
+}
+
+void CubicController::reset() {
+    cwnd = INITIAL_WINDOW;
+    ssthresh = std::numeric_limits<double>::max();
+    wMax = 0;
+    k = 0;
+    originPoint = 0;
+    wEst = 0;
+    epochStart = -1;
+    minRttMicros = 0;
+    lastRttMicros = 0;
+    recoveryUntil = 0;
+}
@@ -0,0 +1,361 @@
+#include "EpollBackend.h"
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <linux/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+namespace {
+
+// 就绪状态：反应器线程递增读写计数，等待方比较计数判断是否有新的边缘
+struct Readiness {
+    std::atomic<uint64_t> readEpoch{0};
+    std::atomic<uint64_t> writeEpoch{0};
+    std::atomic<bool> closed{false};
+    std::atomic<bool> peerClosed{false};
+    std::atomic<int> waiters{0};
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::mutex callbackMutex;
+    // 每次就绪都要在锁外调用，拷贝 shared_ptr 而不是拷贝 std::function，事件分发时不分配内存
+    std::shared_ptr<std::function<void()>> onReady;
+
+    void notify() {
+        if (waiters.load() > 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            cond.notify_all();
+        }
+    }
+
+    bool waitChange(const std::atomic<uint64_t>& epoch, uint64_t seen, int timeoutMs) {
+        auto changed = [&] {
+            return epoch.load() != seen || closed.load();
+        };
+
+        waiters.fetch_add(1);
+        std::unique_lock<std::mutex> lock(mutex);
+        bool ok;
+        if (timeoutMs < 0) {
+            cond.wait(lock, changed);
+            ok = true;
+        } else {
+            ok = cond.wait_for(lock, std::chrono::milliseconds(timeoutMs), changed);
+        }
+        lock.unlock();
+        waiters.fetch_sub(1);
+        return ok && !closed.load();
+    }
+};
+
+class EpollSocket : public TransportSocket {
+public:
+    explicit EpollSocket(std::shared_ptr<EventLoop> loop)
+        : loop_(std::move(loop))
+        , fd_(-1)
+        , state_(std::make_shared<Readiness>())
+        , blockedReadEpoch_(0)
+        , blockedWriteEpoch_(0)
+    {
+    }
+
+    ~EpollSocket() override {
+        close();
+    }
+
+    bool connect(const std::string& host, uint16_t port, int timeoutMs) override {
+        close();
+
+        sockaddr_in serverAddr{};
+        serverAddr.sin_family = AF_INET;
+        serverAddr.sin_port = htons(port);
+        if (inet_pton(AF_INET, host.c_str(), &serverAddr.sin_addr) != 1) {
+            return false;
+        }
+
+        fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+        if (fd_ < 0) {
+            return false;
+        }
+
+        // 先发起连接再注册：尚未连接的套接字会立即报告 EPOLLHUP，先注册会被误认为对端已关闭；
+        // 注册时内核会检查当前状态，连接在注册之前完成也不会丢失边缘
+        int connected = ::connect(fd_, reinterpret_cast<sockaddr*>(&serverAddr), sizeof(serverAddr));
+        if (connected < 0 && errno != EINPROGRESS) {
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+        if (!registerFd()) {
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+
+        if (connected < 0) {
+            if (!state_->waitChange(state_->writeEpoch, 0, timeoutMs)) {
+                close();
+                return false;
+            }
+
+            int error = 0;
+            socklen_t len = sizeof(error);
+            if (getsockopt(fd_, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error != 0) {
+                close();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool adopt(intptr_t handle) override {
+        close();
+
+        int fd = static_cast<int>(handle);
+        int flags = ::fcntl(fd, F_GETFL);
+        if (flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+            return false;
+        }
+        fd_ = fd;
+        if (!registerFd()) {
+            // 注册失败时句柄仍归调用方
+            fd_ = -1;
+            return false;
+        }
+        return true;
+    }
+
+    IoResult send(const void* data, size_t length) override {
+        if (fd_ < 0) {
+            return {IoStatus::CLOSED, 0};
+        }
+
+        // 先记录计数再发起系统调用，避免错过 EAGAIN 之后到来的边缘
+        uint64_t epoch = state_->writeEpoch.load();
+        ssize_t sent = ::send(fd_, data, length, MSG_NOSIGNAL);
+        return sendResult(sent, epoch);
+    }
+
+    IoResult receive(void* buffer, size_t length) override {
+        if (fd_ < 0) {
+            return {IoStatus::CLOSED, 0};
+        }
+
+        uint64_t epoch = state_->readEpoch.load();
+        ssize_t received = ::recv(fd_, buffer, length, 0);
+        return receiveResult(received, epoch);
+    }
+
+    IoResult sendv(const IoVec* vecs, size_t count) override {
+        if (fd_ < 0) {
+            return {IoStatus::CLOSED, 0};
+        }
+
+        iovec iov[MAX_IOV];
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = toIovec(vecs, count, iov);
+
+        uint64_t epoch = state_->writeEpoch.load();
+        ssize_t sent = ::sendmsg(fd_, &msg, MSG_NOSIGNAL);
+        return sendResult(sent, epoch);
+    }
+
+    IoResult receivev(const IoVec* vecs, size_t count) override {
+        if (fd_ < 0) {
+            return {IoStatus::CLOSED, 0};
+        }
+
+        iovec iov[MAX_IOV];
+        size_t iovCount = toIovec(vecs, count, iov);
+
+        uint64_t epoch = state_->readEpoch.load();
+        ssize_t received = ::readv(fd_, iov, static_cast<int>(iovCount));
+        return receiveResult(received, epoch);
+    }
+
+    bool waitReadable(int timeoutMs) override {
+        return fd_ >= 0 && state_->waitChange(state_->readEpoch, blockedReadEpoch_, timeoutMs);
+    }
+
+    bool waitWritable(int timeoutMs) override {
+        return fd_ >= 0 && state_->waitChange(state_->writeEpoch, blockedWriteEpoch_, timeoutMs);
+    }
+
+    bool getPathInfo(PathInfo& info) const override {
+        if (fd_ < 0) {
+            return false;
+        }
+        tcp_info ti{};
+        socklen_t length = sizeof(ti);
+        if (::getsockopt(fd_, IPPROTO_TCP, TCP_INFO, &ti, &length) != 0) {
+            return false;
+        }
+
+        info.rttMicros = ti.tcpi_rtt;
+        info.mss = ti.tcpi_snd_mss;
+        info.bytesInFlight = static_cast<uint64_t>(ti.tcpi_unacked) * ti.tcpi_snd_mss;
+        info.totalRetransmits = ti.tcpi_total_retrans;
+        // 较旧的内核不返回这两个字段
+        info.bytesAcked = length >= offsetof(tcp_info, tcpi_bytes_acked) + sizeof(ti.tcpi_bytes_acked)
+                              ? ti.tcpi_bytes_acked : 0;
+        info.deliveryRate = length >= offsetof(tcp_info, tcpi_delivery_rate) + sizeof(ti.tcpi_delivery_rate)
+                                ? ti.tcpi_delivery_rate : 0;
+        return true;
+    }
+
+    // EPOLLRDHUP 由反应器线程记录，这里只读一个原子变量，不需要系统调用
+    bool isPeerClosed() const override {
+        return fd_ >= 0 && state_->peerClosed.load();
+    }
+
+    bool setReadyCallback(std::function<void()> callback) override {
+        readyCallback_ = callback ? std::make_shared<std::function<void()>>(std::move(callback)) : nullptr;
+        std::lock_guard<std::mutex> lock(state_->callbackMutex);
+        state_->onReady = readyCallback_;
+        return true;
+    }
+
+    void close() override {
+        if (fd_ < 0) {
+            return;
+        }
+        loop_->removeFd(fd_);
+        ::close(fd_);
+        fd_ = -1;
+
+        state_->closed = true;
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->cond.notify_all();
+    }
+
+    bool isOpen() const override {
+        return fd_ >= 0;
+    }
+
+private:
+    // 为 fd_ 创建新的就绪状态并注册到事件循环
+    bool registerFd() {
+        // 小消息由 Protocol 自己合并，关闭 Nagle：否则消息尾部会等对端的延迟确认，每条消息多停顿几十到几百毫秒
+        int one = 1;
+        ::setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        state_ = std::make_shared<Readiness>();
+        state_->onReady = readyCallback_;
+        std::weak_ptr<Readiness> weakState = state_;
+        bool registered = loop_->addFd(fd_, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET,
+            [weakState](uint32_t events) {
+                auto state = weakState.lock();
+                if (!state) {
+                    return;
+                }
+                if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                    state->readEpoch.fetch_add(1);
+                }
+                if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                    state->peerClosed.store(true);
+                }
+                if (events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) {
+                    state->writeEpoch.fetch_add(1);
+                }
+                state->notify();
+
+                // 拷贝一份再调用，回调中可以安全地替换或取消自身
+                std::shared_ptr<std::function<void()>> ready;
+                {
+                    std::lock_guard<std::mutex> lock(state->callbackMutex);
+                    ready = state->onReady;
+                }
+                if (ready) {
+                    (*ready)();
+                }
+            });
+        return registered;
+    }
+
+    // 将系统调用结果转换为 IoResult，WOULD_BLOCK 时记录调用前的就绪计数
+    IoResult sendResult(ssize_t sent, uint64_t epoch) {
+        if (sent >= 0) {
+            return {IoStatus::OK, static_cast<size_t>(sent)};
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            blockedWriteEpoch_ = epoch;
+            return {IoStatus::WOULD_BLOCK, 0};
+        }
+        if (errno == EINTR) {
+            return {IoStatus::OK, 0};
+        }
+        return {errno == EPIPE || errno == ECONNRESET ? IoStatus::CLOSED : IoStatus::FAILED, 0};
+    }
+
+    IoResult receiveResult(ssize_t received, uint64_t epoch) {
+        if (received > 0) {
+            return {IoStatus::OK, static_cast<size_t>(received)};
+        }
+        if (received == 0) {
+            return {IoStatus::CLOSED, 0};
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            blockedReadEpoch_ = epoch;
+            return {IoStatus::WOULD_BLOCK, 0};
+        }
+        if (errno == EINTR) {
+            return {IoStatus::OK, 0};
+        }
+        return {errno == ECONNRESET ? IoStatus::CLOSED : IoStatus::FAILED, 0};
+    }
+
+    static size_t toIovec(const IoVec* vecs, size_t count, iovec* iov) {
+        count = count < MAX_IOV ? count : MAX_IOV;
+        for (size_t i = 0; i < count; i++) {
+            iov[i].iov_base = vecs[i].base;
+            iov[i].iov_len = vecs[i].length;
+        }
+        return count;
+    }
+
+    std::shared_ptr<EventLoop> loop_;
+    int fd_;
+    std::shared_ptr<Readiness> state_;
+    uint64_t blockedReadEpoch_;
+    uint64_t blockedWriteEpoch_;
+    std::shared_ptr<std::function<void()>> readyCallback_;  // 重新连接时转交给新的就绪状态
+};
+
+} // namespace
+
+EpollBackend::EpollBackend(std::shared_ptr<EventLoop> loop)
+    : loop(loop ? std::move(loop) : EventLoop::getShared())
+{
+}
+
+std::unique_ptr<TransportSocket> EpollBackend::createSocket() {
+    return std::unique_ptr<TransportSocket>(new EpollSocket(loop));
+}
+
+const char* EpollBackend::name() const {
+    return "epoll";
+}
+
+bool EpollBackend::runAfter(int64_t delayMicros, std::function<void()> task) {
+    if (delayMicros <= 0) {
+        // 不需要延迟的任务直接投递，不必等到时间轮的下一个刻度
+        loop->queueInLoop(std::move(task));
+        return true;
+    }
+    loop->runAfter(delayMicros, std::move(task));
+    return true;
+}
+
+std::shared_ptr<EventLoop> EpollBackend::getLoop() const {
+    return loop;
+}
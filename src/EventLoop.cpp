@@ -0,0 +1,267 @@
+#include "EventLoop.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <stdexcept>
+
+namespace {
+    const int MAX_EVENTS_PER_POLL = 256;
+
+    // 时间轮刻度：足够细，使按速率发送的数据在一个 RTT 内均匀分布
+    const int64_t TIMER_TICK_MICROS = 100;
+    const size_t TIMER_SLOTS = 1024;
+
+    int64_t nowMicros() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+EventLoop::EventLoop()
+    : epollFd(-1)
+    , wakeupFd(-1)
+    , timerFd(-1)
+    , running(false)
+    , timers(TIMER_TICK_MICROS, TIMER_SLOTS)
+    , timerDeadline(0)
+    , nextTimerId(1)
+{
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        throw std::runtime_error("epoll_create1 failed");
+    }
+
+    wakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeupFd < 0) {
+        ::close(epollFd);
+        throw std::runtime_error("eventfd failed");
+    }
+
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerFd < 0) {
+        ::close(wakeupFd);
+        ::close(epollFd);
+        throw std::runtime_error("timerfd_create failed");
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = wakeupFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeupFd, &ev);
+
+    ev.data.fd = timerFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &ev);
+}
+
+EventLoop::~EventLoop() {
+    stop();
+    ::close(timerFd);
+    ::close(wakeupFd);
+    ::close(epollFd);
+}
+
+void EventLoop::start() {
+    if (running.exchange(true)) {
+        return;
+    }
+    loopThread = std::thread([this] {
+        runLoop();
+    });
+}
+
+void EventLoop::run() {
+    running = true;
+    runLoop();
+}
+
+void EventLoop::runLoop() {
+    loopThreadId = std::this_thread::get_id();
+
+    epoll_event events[MAX_EVENTS_PER_POLL];
+    while (running) {
+        int count = epoll_wait(epollFd, events, MAX_EVENTS_PER_POLL, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+            if (fd == wakeupFd) {
+                uint64_t value;
+                while (::read(wakeupFd, &value, sizeof(value)) > 0) {
+                }
+                continue;
+            }
+            if (fd == timerFd) {
+                handleTimer();
+                continue;
+            }
+
+            // 拷贝一份回调再调用，回调中可以安全地注销自身
+            std::shared_ptr<EventCallback> callback;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto it = handlers.find(fd);
+                if (it != handlers.end()) {
+                    callback = it->second;
+                }
+            }
+            if (callback) {
+                (*callback)(events[i].events);
+            }
+        }
+
+        runPendingTasks();
+    }
+
+    loopThreadId = std::thread::id();
+}
+
+void EventLoop::stop() {
+    running = false;
+    wakeup();
+    if (loopThread.joinable() && loopThread.get_id() != std::this_thread::get_id()) {
+        loopThread.join();
+    }
+}
+
+bool EventLoop::addFd(int fd, uint32_t events, EventCallback callback) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        handlers[fd] = std::make_shared<EventCallback>(std::move(callback));
+    }
+
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.fd = fd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        handlers.erase(fd);
+        return false;
+    }
+    return true;
+}
+
+bool EventLoop::modifyFd(int fd, uint32_t events) {
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.fd = fd;
+    return epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+void EventLoop::removeFd(int fd) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    std::lock_guard<std::mutex> lock(mutex);
+    handlers.erase(fd);
+}
+
+void EventLoop::queueInLoop(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pendingTasks.push_back(std::move(task));
+    }
+    wakeup();
+}
+
+EventLoop::TimerId EventLoop::runAfter(int64_t delayMicros, Task task) {
+    TimerId id = nextTimerId.fetch_add(1);
+    int64_t submitted = nowMicros();
+    if (isInLoopThread()) {
+        addTimer(id, submitted, delayMicros, std::move(task));
+    } else {
+        // std::function 要求可拷贝，任务通过 shared_ptr 转交给循环线程
+        auto shared = std::make_shared<Task>(std::move(task));
+        queueInLoop([this, id, submitted, delayMicros, shared] {
+            addTimer(id, submitted, delayMicros, std::move(*shared));
+        });
+    }
+    return id;
+}
+
+void EventLoop::cancelTimer(TimerId id) {
+    if (isInLoopThread()) {
+        timers.cancel(id);
+    } else {
+        queueInLoop([this, id] {
+            timers.cancel(id);
+        });
+    }
+}
+
+bool EventLoop::isInLoopThread() const {
+    return loopThreadId.load() == std::this_thread::get_id();
+}
+
+std::shared_ptr<EventLoop> EventLoop::getShared() {
+    static std::shared_ptr<EventLoop> sharedLoop = [] {
+        auto loop = std::make_shared<EventLoop>();
+        loop->start();
+        return loop;
+    }();
+    return sharedLoop;
+}
+
+void EventLoop::wakeup() {
+    uint64_t one = 1;
+    ssize_t n = ::write(wakeupFd, &one, sizeof(one));
+    (void)n;
+}
+
+void EventLoop::runPendingTasks() {
+    // 两个列表来回交换，各自保留容量，稳定状态下投递任务不再扩容
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        runningTasks.swap(pendingTasks);
+    }
+    for (auto& task : runningTasks) {
+        task();
+    }
+    runningTasks.clear();
+}
+
+void EventLoop::addTimer(TimerId id, int64_t submittedMicros, int64_t delayMicros, Task task) {
+    // 延迟从调用 runAfter 时算起，排队到循环线程的时间也计入其中
+    int64_t now = nowMicros();
+    int64_t expiry = timers.add(id, now, submittedMicros + delayMicros - now, std::move(task));
+    if (timerDeadline == 0 || expiry < timerDeadline) {
+        armTimer(expiry);
+    }
+}
+
+void EventLoop::handleTimer() {
+    uint64_t expirations;
+    while (::read(timerFd, &expirations, sizeof(expirations)) > 0) {
+    }
+
+    // timerfd 是一次性的，执行完到期任务后按时间轮中最早的到期时刻重新设置；
+    // 没有定时器时不再设置，空闲的循环不会被唤醒
+    timerDeadline = 0;
+    timers.advance(nowMicros());
+    armTimer(timers.nextExpiry());
+}
+
+void EventLoop::armTimer(int64_t deadlineMicros) {
+    if (deadlineMicros <= 0) {
+        if (timerDeadline != 0) {
+            itimerspec spec{};
+            timerfd_settime(timerFd, 0, &spec, nullptr);
+            timerDeadline = 0;
+        }
+        return;
+    }
+    if (deadlineMicros == timerDeadline) {
+        return;
+    }
+    // steady_clock 与 CLOCK_MONOTONIC 同源，直接按绝对时刻设置
+    itimerspec spec{};
+    spec.it_value.tv_sec = deadlineMicros / 1000000;
+    spec.it_value.tv_nsec = (deadlineMicros % 1000000) * 1000;
+    timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+    timerDeadline = deadlineMicros;
+}
@@ -0,0 +1,253 @@
+#include "Framing.h"
+#include "Compression.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    void writeUint32(uint8_t* out, uint32_t value) {
+        out[0] = static_cast<uint8_t>(value >> 24);
+        out[1] = static_cast<uint8_t>(value >> 16);
+        out[2] = static_cast<uint8_t>(value >> 8);
+        out[3] = static_cast<uint8_t>(value);
+    }
+
+    void writeUint16(uint8_t* out, uint16_t value) {
+        out[0] = static_cast<uint8_t>(value >> 8);
+        out[1] = static_cast<uint8_t>(value);
+    }
+
+    uint32_t readUint32(const uint8_t* in) {
+        return (static_cast<uint32_t>(in[0]) << 24) | (static_cast<uint32_t>(in[1]) << 16) |
+               (static_cast<uint32_t>(in[2]) << 8) | static_cast<uint32_t>(in[3]);
+    }
+
+    uint16_t readUint16(const uint8_t* in) {
+        return static_cast<uint16_t>((in[0] << 8) | in[1]);
+    }
+}
+
+void FrameHeader::encode(uint8_t* out) const {
+    writeUint32(out, length);
+    writeUint16(out + 4, flags);
+    writeUint16(out + 6, streamId);
+    writeUint32(out + 8, checksum);
+}
+
+FrameHeader FrameHeader::decode(const uint8_t* in) {
+    FrameHeader header;
+    header.length = readUint32(in);
+    header.flags = readUint16(in + 4);
+    header.streamId = readUint16(in + 6);
+    header.checksum = readUint32(in + 8);
+    return header;
+}
+
+FrameHeader FrameHeader::forPayload(const uint8_t* payload, size_t length, uint16_t flags, uint16_t streamId) {
+    FrameHeader header;
+    header.length = static_cast<uint32_t>(length);
+    header.flags = flags;
+    header.streamId = streamId;
+    header.checksum = NetworkUtils::calculateChecksum(payload, length);
+    return header;
+}
+
+FrameDecoder::FrameDecoder(size_t ringCapacity, std::shared_ptr<BufferPool> pool)
+    : ring(ringCapacity)
+    , current()
+    , headerParsed(false)
+    , frameStart(0)
+    , payloadReceived(0)
+    , payloadCrc(0)
+    , directReadLength(0)
+    , pool(pool ? std::move(pool) : BufferPool::create())
+    , assembling(nullptr)
+    , maxMessageSize(DEFAULT_MAX_MESSAGE_SIZE)
+    , maxPartialStreams(DEFAULT_MAX_PARTIAL_STREAMS)
+    , partialStreams(0)
+{
+}
+
+void FrameDecoder::setLimits(size_t maxMessageSize, size_t maxPartialStreams) {
+    this->maxMessageSize = maxMessageSize;
+    this->maxPartialStreams = maxPartialStreams;
+}
+
+size_t FrameDecoder::prepareRead(TransportSocket::IoVec* vecs, size_t maxVecs) {
+    size_t count = 0;
+    directReadLength = 0;
+
+    // 大帧负载尚缺的部分直接读到消息缓冲区中（此时环形缓冲区一定为空）
+    if (headerParsed && ring.empty() && maxVecs > 0) {
+        size_t remaining = current.length - payloadReceived;
+        if (remaining >= DIRECT_READ_THRESHOLD) {
+            vecs[count++] = {framePayload() + payloadReceived, remaining};
+            directReadLength = remaining;
+        }
+    }
+
+    RingBuffer::Span spans[2];
+    size_t spanCount = ring.writableSpans(spans);
+    for (size_t i = 0; i < spanCount && count < maxVecs; i++) {
+        vecs[count++] = {spans[i].data, spans[i].length};
+    }
+    return count;
+}
+
+bool FrameDecoder::commitRead(size_t bytes) {
+    size_t direct = std::min(bytes, directReadLength);
+    if (direct > 0) {
+        updatePayloadCrc(payloadReceived, direct);
+        payloadReceived += direct;
+    }
+    ring.commitWrite(bytes - direct);
+    directReadLength = 0;
+    return parse();
+}
+
+bool FrameDecoder::hasMessage(uint16_t streamId) const {
+    auto it = ready.find(streamId);
+    return it != ready.end() && !it->second.empty();
+}
+
+Buffer FrameDecoder::popMessage(uint16_t streamId) {
+    auto it = ready.find(streamId);
+    if (it == ready.end() || it->second.empty()) {
+        return Buffer();
+    }
+    Buffer message = std::move(it->second.front());
+    it->second.pop_front();
+    return message;
+}
+
+void FrameDecoder::reset() {
+    ring.clear();
+    headerParsed = false;
+    frameStart = 0;
+    payloadReceived = 0;
+    payloadCrc = 0;
+    directReadLength = 0;
+    assembling = nullptr;
+    for (auto& entry : partial) {
+        entry.second.reset();
+    }
+    partialStreams = 0;
+    for (auto& entry : ready) {
+        entry.second.clear();
+    }
+}
+
+bool FrameDecoder::parse() {
+    while (true) {
+        if (!headerParsed) {
+            uint8_t headerBytes[FrameHeader::SIZE];
+            if (!ring.peek(headerBytes, FrameHeader::SIZE)) {
+                return true;
+            }
+            ring.consume(FrameHeader::SIZE);
+
+            current = FrameHeader::decode(headerBytes);
+            if (current.length > FrameHeader::MAX_PAYLOAD) {
+                return false;
+            }
+
+            headerParsed = true;
+            assembling = &partial[current.streamId];
+            payloadReceived = 0;
+            payloadCrc = 0;
+            if (!*assembling) {
+                // 该流开始一条新消息（上一条交出后句柄为空）
+                if (partialStreams >= maxPartialStreams) {
+                    return false;
+                }
+                partialStreams++;
+            }
+            if (current.flags & FrameHeader::FLAG_COMPRESSED) {
+                // 解压后的长度要等负载收齐才知道，消息缓冲区到时再预留
+                if (!compressedPayload || compressedPayload.capacity() < current.length) {
+                    compressedPayload = pool->acquire(current.length);
+                }
+                compressedPayload.resize(current.length);
+            } else if (!reserveFrame(current.length)) {
+                return false;
+            }
+        }
+
+        size_t needed = current.length - payloadReceived;
+        if (needed > 0) {
+            size_t copied = ring.read(framePayload() + payloadReceived, needed);
+            updatePayloadCrc(payloadReceived, copied);
+            payloadReceived += copied;
+            if (payloadReceived < current.length) {
+                return true;
+            }
+        }
+
+        if (!finishFrame()) {
+            return false;
+        }
+    }
+}
+
+// 为当前帧的负载在消息缓冲区末尾留出空间；容量不够时换一块更大的缓冲区，已收到的帧随之拷贝过去
+// 消息超过 maxMessageSize 时返回 false
+bool FrameDecoder::reserveFrame(size_t length) {
+    frameStart = assembling->size();
+    size_t required = frameStart + length;
+    if (required > maxMessageSize) {
+        return false;
+    }
+    if (!*assembling || assembling->capacity() < required) {
+        // 多帧消息按倍数增长，拷贝的总量与消息长度成正比；增长不超过消息上限
+        size_t capacity = std::min(std::max(required, assembling->capacity() * 2), maxMessageSize);
+        Buffer larger = pool->acquire(capacity);
+        if (frameStart > 0) {
+            std::memcpy(larger.data(), assembling->data(), frameStart);
+        }
+        *assembling = std::move(larger);
+    }
+    assembling->resize(required);
+    return true;
+}
+
+uint8_t* FrameDecoder::framePayload() {
+    if (current.flags & FrameHeader::FLAG_COMPRESSED) {
+        return compressedPayload.data();
+    }
+    return assembling->data() + frameStart;
+}
+
+void FrameDecoder::updatePayloadCrc(size_t offset, size_t length) {
+    // 数据刚写入、仍在缓存中时增量计算校验和，帧收齐后不必再扫描一遍
+    const uint8_t* data = framePayload() + offset;
+    payloadCrc = NetworkUtils::crc32cUpdate(payloadCrc, data, length);
+}
+
+bool FrameDecoder::finishFrame() {
+    if (payloadCrc != current.checksum) {
+        return false;
+    }
+
+    if (current.flags & FrameHeader::FLAG_COMPRESSED) {
+        size_t rawLength;
+        if (!ChunkCompressor::rawLength(compressedPayload.data(), current.length, rawLength) ||
+            rawLength > FrameHeader::MAX_PAYLOAD) {
+            return false;
+        }
+        if (!reserveFrame(rawLength)) {
+            return false;
+        }
+        if (!ChunkCompressor::decompress(compressedPayload.data(), current.length,
+                                         assembling->data() + frameStart, rawLength)) {
+            return false;
+        }
+    }
+
+    headerParsed = false;
+    if (current.flags & FrameHeader::FLAG_END_OF_MESSAGE) {
+        ready[current.streamId].push_back(std::move(*assembling));
+        partialStreams--;
+    }
+    assembling = nullptr;
+    return true;
+}
@@ -0,0 +1,420 @@
+#include "HealthChecker.h"
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+
+namespace {
+
+int64_t nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string endpointKey(const std::string& address, uint16_t port) {
+    return address + ":" + std::to_string(port);
+}
+
+} // namespace
+
+// 一个被探测的节点；窗口与计数受 State::mutex 保护，其余字段只在循环线程中访问
+struct HealthChecker::Target {
+    std::string address;
+    uint16_t port = 0;
+    sockaddr_in peer{};
+
+    bool healthy = true;
+    uint32_t consecutiveFailures = 0;
+    uint32_t consecutiveSuccesses = 0;
+    uint64_t probes = 0;
+    uint64_t failures = 0;
+    uint32_t lastRttMicros = 0;
+    std::vector<int64_t> window;        // 环形缓冲区，失败记为 -1
+    size_t windowNext = 0;
+
+    bool removed = false;
+    bool queued = false;                // 在 State::waiting 中等待探测名额
+    int fd = -1;
+    int64_t probeStartMicros = 0;
+    EventLoop::TimerId probeTimer = 0;  // 下一次探测
+    EventLoop::TimerId timeoutTimer = 0;
+};
+
+struct HealthChecker::State : std::enable_shared_from_this<State> {
+    LoadBalancer* balancer = nullptr;
+    std::shared_ptr<EventLoop> loop;
+    Config config;
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<Target>> targets;   // 只在循环线程中修改
+
+    // 只在循环线程中访问
+    bool stopped = false;
+    size_t inFlight = 0;
+    std::deque<std::shared_ptr<Target>> waiting;
+    std::mt19937_64 random{std::random_device()()};
+
+    // 在循环线程中执行；循环线程之外调用时投递过去
+    template <typename Task>
+    void inLoop(Task task) {
+        if (loop->isInLoopThread()) {
+            task();
+        } else {
+            loop->queueInLoop(std::move(task));
+        }
+    }
+
+    int64_t jittered(int64_t micros) {
+        std::uniform_real_distribution<double> factor(1 - config.jitter, 1 + config.jitter);
+        return static_cast<int64_t>(micros * factor(random));
+    }
+
+    // 解析地址后投递到循环线程加入，地址不是 IPv4 时返回 false
+    bool queueAdd(const std::string& address, uint16_t port) {
+        sockaddr_in peer{};
+        peer.sin_family = AF_INET;
+        peer.sin_port = htons(port);
+        if (inet_pton(AF_INET, address.c_str(), &peer.sin_addr) != 1) {
+            return false;
+        }
+        auto self = shared_from_this();
+        inLoop([self, address, port, peer] {
+            self->add(address, port, peer);
+        });
+        return true;
+    }
+
+    void add(const std::string& address, uint16_t port, const sockaddr_in& peer) {
+        if (stopped) {
+            return;
+        }
+        std::string key = endpointKey(address, port);
+        auto target = std::make_shared<Target>();
+        target->address = address;
+        target->port = port;
+        target->peer = peer;
+        target->window.reserve(config.windowSize);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!targets.emplace(key, target).second) {
+                return;
+            }
+        }
+        // 首次探测在一个间隔内随机错开，大批节点同时加入时探测也均匀分布
+        std::uniform_int_distribution<int64_t> offset(0, std::max<int64_t>(config.intervalMicros, 1) - 1);
+        scheduleProbe(target, offset(random));
+    }
+
+    void remove(const std::string& address, uint16_t port) {
+        std::shared_ptr<Target> target;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = targets.find(endpointKey(address, port));
+            if (it == targets.end()) {
+                return;
+            }
+            target = it->second;
+            targets.erase(it);
+        }
+        cancel(*target);
+        startWaiting();
+    }
+
+    // 取消节点上的定时器和进行中的探测
+    void cancel(Target& target) {
+        target.removed = true;
+        if (target.probeTimer != 0) {
+            loop->cancelTimer(target.probeTimer);
+            target.probeTimer = 0;
+        }
+        if (target.fd >= 0) {
+            closeProbe(target);
+        }
+    }
+
+    void shutdown() {
+        stopped = true;
+        std::unordered_map<std::string, std::shared_ptr<Target>> all;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            all.swap(targets);
+        }
+        for (auto& entry : all) {
+            cancel(*entry.second);
+        }
+        waiting.clear();
+    }
+
+    void scheduleProbe(const std::shared_ptr<Target>& target, int64_t delayMicros) {
+        std::weak_ptr<State> weakState = shared_from_this();
+        target->probeTimer = loop->runAfter(delayMicros, [weakState, target] {
+            auto state = weakState.lock();
+            if (!state || target->removed) {
+                return;
+            }
+            target->probeTimer = 0;
+            state->startProbe(target);
+        });
+    }
+
+    void startProbe(const std::shared_ptr<Target>& target) {
+        if (stopped || target->removed) {
+            return;
+        }
+        if (inFlight >= config.maxInFlight) {
+            if (!target->queued) {
+                target->queued = true;
+                waiting.push_back(target);
+            }
+            return;
+        }
+
+        int64_t start = nowMicros();
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+        if (fd < 0) {
+            // 本地资源不足不是节点的问题，不计入结果，稍后重试
+            scheduleProbe(target, jittered(config.intervalMicros));
+            return;
+        }
+        // 关闭时直接发送 RST：探测连接不进入 TIME_WAIT，高频探测不会耗尽本地端口
+        linger abort{1, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &abort, sizeof(abort));
+
+        target->probeStartMicros = start;
+        int result = ::connect(fd, reinterpret_cast<const sockaddr*>(&target->peer), sizeof(target->peer));
+        if (result == 0 || errno != EINPROGRESS) {
+            ::close(fd);
+            finish(target, result == 0);
+            return;
+        }
+
+        std::weak_ptr<State> weakState = shared_from_this();
+        bool added = loop->addFd(fd, EPOLLOUT, [weakState, target](uint32_t events) {
+            auto state = weakState.lock();
+            if (!state || target->removed || target->fd < 0) {
+                return;
+            }
+            int error = 0;
+            socklen_t length = sizeof(error);
+            if (::getsockopt(target->fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0) {
+                error = errno;
+            }
+            bool connected = false;
+            if (error == 0 && !(events & (EPOLLERR | EPOLLHUP))) {
+                // 描述符编号可能被复用，同一批事件中属于已关闭描述符的事件会落到这里，
+                // 连接尚未建立（getpeername 返回 ENOTCONN）时继续等待
+                sockaddr_in peer{};
+                socklen_t peerLength = sizeof(peer);
+                if (::getpeername(target->fd, reinterpret_cast<sockaddr*>(&peer), &peerLength) < 0) {
+                    return;
+                }
+                connected = true;
+            }
+            state->closeProbe(*target);
+            state->finish(target, connected);
+        });
+        if (!added) {
+            ::close(fd);
+            scheduleProbe(target, jittered(config.intervalMicros));
+            return;
+        }
+        target->fd = fd;
+        inFlight++;
+        target->timeoutTimer = loop->runAfter(config.timeoutMicros, [weakState, target] {
+            auto state = weakState.lock();
+            if (!state || target->removed || target->fd < 0) {
+                return;
+            }
+            target->timeoutTimer = 0;
+            state->closeProbe(*target);
+            state->finish(target, false);
+        });
+    }
+
+    void closeProbe(Target& target) {
+        if (target.timeoutTimer != 0) {
+            loop->cancelTimer(target.timeoutTimer);
+            target.timeoutTimer = 0;
+        }
+        loop->removeFd(target.fd);
+        ::close(target.fd);
+        target.fd = -1;
+        inFlight--;
+    }
+
+    // 记录一次探测结果，按滞回阈值判断状态是否翻转，并安排下一次探测
+    void finish(const std::shared_ptr<Target>& target, bool success) {
+        int64_t now = nowMicros();
+        int64_t rtt = now - target->probeStartMicros;
+        bool changed = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Target& t = *target;
+            t.probes++;
+            int64_t sample = success ? rtt : -1;
+            if (t.window.size() < config.windowSize) {
+                t.window.push_back(sample);
+            } else if (!t.window.empty()) {
+                t.window[t.windowNext] = sample;
+                t.windowNext = (t.windowNext + 1) % t.window.size();
+            }
+            if (success) {
+                t.lastRttMicros = static_cast<uint32_t>(rtt);
+                t.consecutiveSuccesses++;
+                t.consecutiveFailures = 0;
+                if (!t.healthy && t.consecutiveSuccesses >= config.riseThreshold) {
+                    t.healthy = true;
+                    changed = true;
+                }
+            } else {
+                t.failures++;
+                t.consecutiveFailures++;
+                t.consecutiveSuccesses = 0;
+                if (t.healthy && t.consecutiveFailures >= config.fallThreshold) {
+                    t.healthy = false;
+                    changed = true;
+                }
+            }
+        }
+        if (changed) {
+            balancer->updateNodeStatus(target->address, target->port, target->healthy);
+        }
+
+        // 下一次探测从本次开始时算起；本次已超时（节点无响应）时立即再探测，尽快确认故障
+        int64_t next = target->probeStartMicros + jittered(config.intervalMicros);
+        scheduleProbe(target, std::max<int64_t>(next - now, 0));
+        startWaiting();
+    }
+
+    void startWaiting() {
+        while (!waiting.empty() && inFlight < config.maxInFlight && !stopped) {
+            auto target = std::move(waiting.front());
+            waiting.pop_front();
+            target->queued = false;
+            startProbe(target);
+        }
+    }
+
+    HealthChecker::NodeHealth describe(const Target& target) const {
+        NodeHealth health;
+        health.address = target.address;
+        health.port = target.port;
+        health.healthy = target.healthy;
+        health.consecutiveFailures = target.consecutiveFailures;
+        health.consecutiveSuccesses = target.consecutiveSuccesses;
+        health.probes = target.probes;
+        health.failures = target.failures;
+        health.lastRttMicros = target.lastRttMicros;
+        health.windowSamples = target.window.size();
+
+        std::vector<int64_t> rtts;
+        rtts.reserve(target.window.size());
+        for (int64_t sample : target.window) {
+            if (sample < 0) {
+                health.windowFailures++;
+            } else {
+                rtts.push_back(sample);
+            }
+        }
+        if (!rtts.empty()) {
+            auto at = [&rtts](double fraction) {
+                size_t index = std::min(rtts.size() - 1, static_cast<size_t>(fraction * rtts.size()));
+                std::nth_element(rtts.begin(), rtts.begin() + index, rtts.end());
+                return static_cast<uint32_t>(rtts[index]);
+            };
+            health.rttP50Micros = at(0.50);
+            health.rttP99Micros = at(0.99);
+        }
+        return health;
+    }
+};
+
+HealthChecker::HealthChecker(LoadBalancer& balancer, std::shared_ptr<EventLoop> loop)
+    : HealthChecker(balancer, Config(), std::move(loop))
+{
+}
+
+HealthChecker::HealthChecker(LoadBalancer& balancer, const Config& config, std::shared_ptr<EventLoop> loop)
+    : balancer(balancer)
+    , state(std::make_shared<State>())
+    , listenerId(0)
+{
+    state->balancer = &balancer;
+    state->loop = loop ? std::move(loop) : EventLoop::getShared();
+    state->config = config;
+    state->config.windowSize = std::max<size_t>(state->config.windowSize, 1);
+    state->config.maxInFlight = std::max<size_t>(state->config.maxInFlight, 1);
+    state->config.jitter = std::min(std::max(state->config.jitter, 0.0), 1.0);
+
+    // 先订阅再读取活跃节点，两者之间加入的节点不会漏掉（重复加入会被忽略）。
+    // 回调可能在取消订阅时仍在其他线程中执行，因此只持有 State 的弱引用
+    std::weak_ptr<State> weakState = state;
+    listenerId = balancer.addNodeListener([weakState](LoadBalancer::NodeEvent event, const std::string& address,
+                                                      uint16_t port) {
+        auto state = weakState.lock();
+        if (!state) {
+            return;
+        }
+        if (event == LoadBalancer::NodeEvent::ADDED) {
+            state->queueAdd(address, port);
+        } else if (event == LoadBalancer::NodeEvent::REMOVED) {
+            state->inLoop([state, address, port] {
+                state->remove(address, port);
+            });
+        }
+    });
+    for (const auto& node : balancer.getActiveNodes()) {
+        state->queueAdd(node.first, node.second);
+    }
+}
+
+HealthChecker::~HealthChecker() {
+    balancer.removeNodeListener(listenerId);
+    stop();
+}
+
+bool HealthChecker::addNode(const std::string& address, uint16_t port) {
+    return state->queueAdd(address, port);
+}
+
+void HealthChecker::removeNode(const std::string& address, uint16_t port) {
+    auto state = this->state;
+    state->inLoop([state, address, port] {
+        state->remove(address, port);
+    });
+}
+
+void HealthChecker::stop() {
+    auto state = this->state;
+    if (state->loop->isInLoopThread()) {
+        state->shutdown();
+        return;
+    }
+    // 在循环线程中关闭，等待完成后不会再有回调修改负载均衡器
+    auto done = std::make_shared<std::promise<void>>();
+    std::future<void> finished = done->get_future();
+    state->loop->queueInLoop([state, done] {
+        state->shutdown();
+        done->set_value();
+    });
+    finished.wait();
+}
+
+std::vector<HealthChecker::NodeHealth> HealthChecker::getNodeHealth() const {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    std::vector<NodeHealth> result;
+    result.reserve(state->targets.size());
+    for (const auto& entry : state->targets) {
+        result.push_back(state->describe(*entry.second));
+    }
+    return result;
+}
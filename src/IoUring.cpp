@@ -0,0 +1,281 @@
+#include "IoUring.h"
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+// 探测结果最多覆盖的操作码个数
+const unsigned PROBE_OPS = 256;
+
+} // namespace
+
+IoUring::IoUring()
+    : ringFd(-1)
+    , sqPoll(false)
+    , featureFlags(0)
+    , sqRing(nullptr)
+    , sqRingSize(0)
+    , cqRing(nullptr)
+    , cqRingSize(0)
+    , sqes(nullptr)
+    , sqesSize(0)
+    , sqHead(nullptr)
+    , sqTail(nullptr)
+    , sqFlags(nullptr)
+    , sqMask(0)
+    , sqEntries(0)
+    , cqHead(nullptr)
+    , cqTail(nullptr)
+    , cqMask(0)
+    , cqes(nullptr)
+    , sqeTail(0)
+    , submitted(0)
+{
+}
+
+IoUring::~IoUring() {
+    close();
+}
+
+bool IoUring::init(unsigned entries, unsigned cqEntries, bool useSqPoll, unsigned sqThreadIdleMs) {
+    close();
+
+    io_uring_params params{};
+    if (cqEntries > 0) {
+        params.flags |= IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP;
+        params.cq_entries = cqEntries;
+    }
+    if (useSqPoll) {
+        params.flags |= IORING_SETUP_SQPOLL;
+        params.sq_thread_idle = sqThreadIdleMs;
+    }
+
+    int fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0) {
+        return false;
+    }
+    ringFd = fd;
+    sqPoll = useSqPoll;
+    featureFlags = params.features;
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMmap) {
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+    }
+
+    sqRing = ::mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                    IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) {
+        sqRing = nullptr;
+        int error = errno;
+        close();
+        errno = error;
+        return false;
+    }
+    if (singleMmap) {
+        cqRing = sqRing;
+    } else {
+        cqRing = ::mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                        IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) {
+            cqRing = nullptr;
+            int error = errno;
+            close();
+            errno = error;
+            return false;
+        }
+    }
+
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* mapped = ::mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                          IORING_OFF_SQES);
+    if (mapped == MAP_FAILED) {
+        int error = errno;
+        close();
+        errno = error;
+        return false;
+    }
+    sqes = static_cast<io_uring_sqe*>(mapped);
+
+    uint8_t* sq = static_cast<uint8_t*>(sqRing);
+    sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqFlags = reinterpret_cast<unsigned*>(sq + params.sq_off.flags);
+    sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqEntries = params.sq_entries;
+    // 提交项与索引数组一一对应，之后不再改动索引数组
+    unsigned* array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    for (unsigned i = 0; i < sqEntries; i++) {
+        array[i] = i;
+    }
+
+    uint8_t* cq = static_cast<uint8_t*>(cqRing);
+    cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    sqeTail = *sqTail;
+    submitted = sqeTail;
+    return true;
+}
+
+void IoUring::close() {
+    if (sqes) {
+        ::munmap(sqes, sqesSize);
+        sqes = nullptr;
+    }
+    if (cqRing && cqRing != sqRing) {
+        ::munmap(cqRing, cqRingSize);
+    }
+    cqRing = nullptr;
+    if (sqRing) {
+        ::munmap(sqRing, sqRingSize);
+        sqRing = nullptr;
+    }
+    if (ringFd >= 0) {
+        ::close(ringFd);
+        ringFd = -1;
+    }
+}
+
+io_uring_sqe* IoUring::getSqe() {
+    unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    if (sqeTail - head >= sqEntries) {
+        return nullptr;
+    }
+    io_uring_sqe* sqe = &sqes[sqeTail & sqMask];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqeTail++;
+    return sqe;
+}
+
+int IoUring::submit() {
+    if (sqeTail != submitted) {
+        __atomic_store_n(sqTail, sqeTail, __ATOMIC_RELEASE);
+        submitted = sqeTail;
+    }
+
+    if (sqPoll) {
+        // 发布队尾之后再读唤醒标志，两者之间需要完整的内存屏障，否则可能错过刚进入休眠的内核线程
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_load_n(sqFlags, __ATOMIC_RELAXED) & IORING_SQ_NEED_WAKEUP) {
+            int result = enter(0, 0, IORING_ENTER_SQ_WAKEUP);
+            if (result < 0) {
+                return result;
+            }
+        }
+        return 0;
+    }
+
+    // 上一次没有被内核取走的提交项（例如完成队列溢出时）也一并交出
+    unsigned toSubmit = sqeTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    if (toSubmit == 0) {
+        return 0;
+    }
+    return enter(toSubmit, 0, 0);
+}
+
+int IoUring::submitAndWait(unsigned waitNr) {
+    int result = submit();
+    if (result < 0) {
+        return result;
+    }
+    return enter(0, waitNr, 0);
+}
+
+bool IoUring::hasOverflow() const {
+    return (__atomic_load_n(sqFlags, __ATOMIC_RELAXED) & IORING_SQ_CQ_OVERFLOW) != 0;
+}
+
+int IoUring::flushOverflow() {
+    return enter(0, 0, IORING_ENTER_GETEVENTS);
+}
+
+bool IoUring::supportsOp(uint8_t opcode) const {
+    alignas(io_uring_probe) uint8_t buffer[sizeof(io_uring_probe) + PROBE_OPS * sizeof(io_uring_probe_op)] = {};
+    io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(buffer);
+    if (registerOp(IORING_REGISTER_PROBE, probe, PROBE_OPS) < 0) {
+        return false;
+    }
+    return opcode <= probe->last_op && (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED) != 0;
+}
+
+int IoUring::registerEventFd(int eventFd) {
+    return registerOp(IORING_REGISTER_EVENTFD, &eventFd, 1);
+}
+
+int IoUring::registerSparseFiles(unsigned count) {
+    io_uring_rsrc_register reg{};
+    reg.nr = count;
+    reg.flags = IORING_RSRC_REGISTER_SPARSE;
+    return registerOp(IORING_REGISTER_FILES2, &reg, sizeof(reg));
+}
+
+int IoUring::updateFile(unsigned slot, int fd) {
+    io_uring_rsrc_update2 update{};
+    update.offset = slot;
+    update.data = reinterpret_cast<uint64_t>(&fd);
+    update.nr = 1;
+    return registerOp(IORING_REGISTER_FILES_UPDATE2, &update, sizeof(update));
+}
+
+int IoUring::registerSparseBuffers(unsigned count) {
+    io_uring_rsrc_register reg{};
+    reg.nr = count;
+    reg.flags = IORING_RSRC_REGISTER_SPARSE;
+    return registerOp(IORING_REGISTER_BUFFERS2, &reg, sizeof(reg));
+}
+
+int IoUring::updateBuffer(unsigned slot, void* base, size_t length) {
+    iovec vec{base, length};
+    io_uring_rsrc_update2 update{};
+    update.offset = slot;
+    update.data = reinterpret_cast<uint64_t>(&vec);
+    update.nr = 1;
+    return registerOp(IORING_REGISTER_BUFFERS_UPDATE, &update, sizeof(update));
+}
+
+int IoUring::registerBufferRing(io_uring_buf_ring* ring, unsigned entries, uint16_t groupId) {
+    io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<uint64_t>(ring);
+    reg.ring_entries = entries;
+    reg.bgid = groupId;
+    return registerOp(IORING_REGISTER_PBUF_RING, &reg, 1);
+}
+
+bool IoUring::isAvailable() {
+    static const bool available = [] {
+        // 内核过旧、被 seccomp 或 io_uring_disabled 禁用时创建失败
+        IoUring ring;
+        return ring.init(1);
+    }();
+    return available;
+}
+
+int IoUring::enter(unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    if (minComplete > 0) {
+        flags |= IORING_ENTER_GETEVENTS;
+    }
+    while (true) {
+        long result = ::syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0);
+        if (result >= 0) {
+            return static_cast<int>(result);
+        }
+        if (errno != EINTR) {
+            return -errno;
+        }
+    }
+}
+
+int IoUring::registerOp(unsigned opcode, const void* arg, unsigned count) const {
+    long result = ::syscall(__NR_io_uring_register, ringFd, opcode, arg, count);
+    return result < 0 ? -errno : 0;
+}
@@ -0,0 +1,1029 @@
+#include "IoUringBackend.h"
+#include "FifoQueue.h"
+#include "IoUring.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 所有连接的多次接收共用一个提供缓冲区组
+const uint16_t BUFFER_GROUP = 0;
+
+// user_data 的低 8 位是操作类型，其余是连接的槽位
+const uint64_t OP_RECEIVE = 1;
+const uint64_t OP_SEND = 2;
+const unsigned OP_BITS = 8;
+
+// 关闭时还有数据没写出的连接最多再等这么久，对端一直不读时不会无限占用槽位
+const int64_t CLOSE_LINGER_MICROS = 5 * 1000 * 1000;
+
+// 一次归还给缓冲区环的缓冲区个数上限（栈上暂存）
+const size_t RECYCLE_BATCH = 64;
+
+// 内核只在零拷贝发送上接受固定缓冲区；零拷贝要多等一个通知完成项，只对足够大的发送划算
+const size_t ZERO_COPY_MIN_BYTES = 16 * 1024;
+
+// 一条多次接收的完成项交来的数据：提供缓冲区编号及其中尚未被取走的部分
+struct Received {
+    uint16_t bufferId = 0;
+    uint32_t offset = 0;
+    uint32_t length = 0;
+};
+
+// 一个连接在调用线程与事件循环线程之间共享的状态
+// 发送缓冲区是环形的：调用方在 sendTail 处追加，内核从 sendHead 处写出，同一时刻最多一个发送在途以保证顺序。
+// 零拷贝发送完成后内核仍引用其数据，直到通知完成项到达，这之前从该发送的起点开始的空间都不能覆盖
+struct Channel {
+    unsigned slot = 0;
+    int fd = -1;
+
+    std::mutex mutex;
+    uint8_t* sendBuffer = nullptr;
+    size_t sendCapacity = 0;
+    uint64_t sendHead = 0;          // 累计已写出的字节数
+    uint64_t sendTail = 0;          // 累计已拷入的字节数
+    bool sendInFlight = false;
+    bool zeroCopyInFlight = false;
+    FifoQueue<uint64_t> zeroCopyHeld;   // 等待通知的零拷贝发送的起点，按提交顺序
+    int sendError = 0;
+    FifoQueue<Received> received;
+    bool receiveArmed = false;
+    bool receiveStarved = false;    // 缓冲区环耗尽，多次接收已结束，等缓冲区归还后重新挂起
+    bool endOfStream = false;
+    int receiveError = 0;
+    bool closing = false;
+    bool lingerExpired = false;
+    bool shutdownDone = false;
+
+    // 就绪计数：事件循环线程递增，同步等待方比较计数判断是否有新的进展
+    std::atomic<uint64_t> readEpoch{0};
+    std::atomic<uint64_t> writeEpoch{0};
+    std::atomic<bool> closed{false};
+    std::atomic<bool> peerClosed{false};
+    std::atomic<int> waiters{0};
+    std::mutex waitMutex;
+    std::condition_variable cond;
+
+    std::mutex callbackMutex;
+    std::shared_ptr<std::function<void()>> onReady;
+
+    // 以下只在事件循环线程中访问
+    bool readyPending = false;
+    bool retireQueued = false;
+    // 以下由 State::mutex 保护
+    bool requested = false;
+
+    void notify() {
+        if (waiters.load() > 0) {
+            std::lock_guard<std::mutex> lock(waitMutex);
+            cond.notify_all();
+        }
+    }
+
+    // 发送缓冲区中可以覆盖的位置
+    uint64_t releasedHead() const {
+        return zeroCopyHeld.empty() ? sendHead : zeroCopyHeld.front();
+    }
+
+    bool hasPendingOps() const {
+        return receiveArmed || sendInFlight || !zeroCopyHeld.empty();
+    }
+
+    bool waitChange(const std::atomic<uint64_t>& epoch, uint64_t seen, int timeoutMs) {
+        auto changed = [&] {
+            return epoch.load() != seen || closed.load();
+        };
+
+        waiters.fetch_add(1);
+        std::unique_lock<std::mutex> lock(waitMutex);
+        bool ok;
+        if (timeoutMs < 0) {
+            cond.wait(lock, changed);
+            ok = true;
+        } else {
+            ok = cond.wait_for(lock, std::chrono::milliseconds(timeoutMs), changed);
+        }
+        lock.unlock();
+        waiters.fetch_sub(1);
+        return ok && !closed.load();
+    }
+};
+
+TransportSocket::IoStatus errorStatus(int error) {
+    return error == EPIPE || error == ECONNRESET ? TransportSocket::IoStatus::CLOSED
+                                                 : TransportSocket::IoStatus::FAILED;
+}
+
+} // namespace
+
+struct IoUringBackend::State : std::enable_shared_from_this<State> {
+    Config config;
+    std::shared_ptr<EventLoop> loop;
+    int eventFd = -1;
+
+    // 提交队列和完成队列只在事件循环线程中访问（析构时除外）
+    IoUring ring;
+    bool fixedFiles = false;
+    bool fixedBuffers = false;
+
+    // 提供缓冲区环：内核从环中取缓冲区装入收到的数据，调用方取走数据后把缓冲区放回环尾
+    io_uring_buf_ring* bufferRing = nullptr;
+    size_t bufferRingSize = 0;
+    uint8_t* bufferMemory = nullptr;
+    size_t bufferMemorySize = 0;
+    std::mutex bufferMutex;
+    uint16_t bufferTail = 0;
+    std::atomic<size_t> starvedCount{0};
+
+    std::mutex mutex;
+    // 槽位只在空闲时由建立连接的线程填入、在事件循环线程中清空，完成项按槽位找到连接时不需要加锁
+    std::vector<std::shared_ptr<Channel>> slots;
+    std::vector<unsigned> freeSlots;
+    // 每个槽位的发送缓冲区，第一次使用时分配并注册为固定缓冲区，之后随槽位复用
+    std::vector<std::unique_ptr<uint8_t[]>> sendBuffers;
+    std::vector<unsigned> requests;     // 其他线程请求事件循环处理的槽位
+    std::vector<unsigned> starved;
+    bool kickPending = false;
+
+    // 以下只在事件循环线程中访问
+    std::vector<unsigned> working;
+    std::vector<Channel*> touched;      // 本轮有进展、需要调用就绪回调的连接
+    std::vector<Channel*> retiring;     // 已关闭、等待挂起的操作结束后释放槽位的连接
+    bool driving = false;
+
+    ~State() {
+        if (eventFd >= 0) {
+            loop->removeFd(eventFd);
+        }
+        if (ring.isOpen()) {
+            drainBeforeClose();
+            ring.close();
+        }
+        for (auto& channel : slots) {
+            if (channel && channel->fd >= 0) {
+                ::close(channel->fd);
+            }
+        }
+        if (bufferMemory) {
+            ::munmap(bufferMemory, bufferMemorySize);
+        }
+        if (bufferRing) {
+            ::munmap(bufferRing, bufferRingSize);
+        }
+        if (eventFd >= 0) {
+            ::close(eventFd);
+        }
+    }
+
+    bool init() {
+        unsigned bufferCount = config.receiveBufferCount;
+        if (bufferCount == 0 || (bufferCount & (bufferCount - 1)) != 0 || bufferCount > 32768 ||
+            config.maxConnections == 0 || config.sendBufferSize == 0 || config.receiveBufferSize == 0) {
+            return false;
+        }
+        if (!ring.init(config.ringEntries, config.ringEntries * 4, config.sqPoll, config.sqThreadIdleMs)) {
+            return false;
+        }
+        // 多次接收、提供缓冲区环和固定缓冲区发送在 6.0 前后陆续加入，没有直接的探测方法，
+        // 以同一版本加入的 SEND_ZC 作为内核足够新的依据
+        if (!ring.supportsOp(IORING_OP_SEND_ZC)) {
+            return false;
+        }
+
+        bufferRingSize = bufferCount * sizeof(io_uring_buf);
+        void* mapped = ::mmap(nullptr, bufferRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+        bufferRing = static_cast<io_uring_buf_ring*>(mapped);
+        bufferMemorySize = bufferCount * config.receiveBufferSize;
+        mapped = ::mmap(nullptr, bufferMemorySize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+        bufferMemory = static_cast<uint8_t*>(mapped);
+        if (ring.registerBufferRing(bufferRing, bufferCount, BUFFER_GROUP) < 0) {
+            return false;
+        }
+        for (unsigned i = 0; i < bufferCount; i++) {
+            putBuffer(static_cast<uint16_t>(i));
+        }
+        __atomic_store_n(&bufferRing->tail, bufferTail, __ATOMIC_RELEASE);
+
+        // 固定文件和固定缓冲区只是省去每次操作的引用计数与页面锁定，注册失败时照常使用普通的描述符和地址
+        fixedFiles = ring.registerSparseFiles(config.maxConnections) == 0;
+        fixedBuffers = ring.registerSparseBuffers(config.maxConnections) == 0;
+
+        slots.resize(config.maxConnections);
+        sendBuffers.resize(config.maxConnections);
+        for (unsigned i = config.maxConnections; i > 0; i--) {
+            freeSlots.push_back(i - 1);
+        }
+        requests.reserve(config.maxConnections);
+        working.reserve(config.maxConnections);
+        starved.reserve(config.maxConnections);
+        touched.reserve(config.maxConnections);
+        retiring.reserve(config.maxConnections);
+
+        eventFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (eventFd < 0 || ring.registerEventFd(eventFd) < 0) {
+            return false;
+        }
+        // 边缘触发且从不读取：内核每写一次 eventfd 都会产生新的边缘，省掉每轮一次 read
+        std::weak_ptr<State> weakState = shared_from_this();
+        if (!loop->addFd(eventFd, EPOLLIN | EPOLLET, [weakState](uint32_t) {
+                if (auto state = weakState.lock()) {
+                    state->drive();
+                }
+            })) {
+            ::close(eventFd);
+            eventFd = -1;
+            return false;
+        }
+        return true;
+    }
+
+    // 为新连接分配槽位并准备好发送缓冲区，槽位用完时返回 false
+    bool attach(const std::shared_ptr<Channel>& channel) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (freeSlots.empty()) {
+            return false;
+        }
+        unsigned slot = freeSlots.back();
+        if (fixedFiles && ring.updateFile(slot, channel->fd) < 0) {
+            return false;
+        }
+        std::unique_ptr<uint8_t[]>& buffer = sendBuffers[slot];
+        if (!buffer) {
+            buffer.reset(new uint8_t[config.sendBufferSize]);
+            if (fixedBuffers && ring.updateBuffer(slot, buffer.get(), config.sendBufferSize) < 0) {
+                buffer.reset();
+                return false;
+            }
+        }
+        freeSlots.pop_back();
+        channel->slot = slot;
+        channel->sendBuffer = buffer.get();
+        channel->sendCapacity = config.sendBufferSize;
+        slots[slot] = channel;
+        return true;
+    }
+
+    // 请求事件循环处理该连接：提交发送、挂起接收或推进关闭。可从任意线程调用，调用方不能持有 channel.mutex
+    void request(Channel& channel) {
+        if (loop->isInLoopThread()) {
+            service(channel);
+            if (!driving) {
+                processRetiring();
+                submit();
+            }
+            return;
+        }
+        bool kick = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!channel.requested) {
+                channel.requested = true;
+                requests.push_back(channel.slot);
+            }
+            if (!kickPending) {
+                kickPending = true;
+                kick = true;
+            }
+        }
+        if (kick) {
+            wakeup();
+        }
+    }
+
+    // 把取走数据的缓冲区放回环尾；有连接因缓冲区耗尽而停止接收时，请事件循环重新挂起它们
+    void recycle(const uint16_t* bufferIds, size_t count) {
+        if (count == 0) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(bufferMutex);
+            for (size_t i = 0; i < count; i++) {
+                putBuffer(bufferIds[i]);
+            }
+            __atomic_store_n(&bufferRing->tail, bufferTail, __ATOMIC_RELEASE);
+        }
+        if (starvedCount.load() == 0) {
+            return;
+        }
+
+        bool inLoop = loop->isInLoopThread();
+        bool kick = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (unsigned slot : starved) {
+                Channel* channel = slots[slot].get();
+                if (!channel) {
+                    continue;
+                }
+                {
+                    std::lock_guard<std::mutex> channelLock(channel->mutex);
+                    channel->receiveStarved = false;
+                }
+                if (!channel->requested) {
+                    channel->requested = true;
+                    requests.push_back(slot);
+                }
+            }
+            starved.clear();
+            starvedCount = 0;
+            if (!inLoop && !kickPending) {
+                kickPending = true;
+                kick = true;
+            }
+        }
+        if (inLoop) {
+            takeRequests();
+            if (!driving) {
+                submit();
+            }
+        } else if (kick) {
+            wakeup();
+        }
+    }
+
+    uint8_t* bufferAddress(uint16_t bufferId) const {
+        return bufferMemory + static_cast<size_t>(bufferId) * config.receiveBufferSize;
+    }
+
+private:
+    void putBuffer(uint16_t bufferId) {
+        // 环的各项从环首开始（队尾与第 0 项的保留字段重叠）；不用 bufs 成员：
+        // 内核头文件的柔性数组宏在 C++ 中会给它插入一个空结构体，偏移不再是 0
+        io_uring_buf* entries = reinterpret_cast<io_uring_buf*>(bufferRing);
+        io_uring_buf& entry = entries[bufferTail & (config.receiveBufferCount - 1)];
+        entry.addr = reinterpret_cast<uint64_t>(bufferAddress(bufferId));
+        entry.len = static_cast<uint32_t>(config.receiveBufferSize);
+        entry.bid = bufferId;
+        bufferTail++;
+    }
+
+    void wakeup() {
+        uint64_t one = 1;
+        ssize_t n = ::write(eventFd, &one, sizeof(one));
+        (void)n;
+    }
+
+    // 事件循环线程的入口：处理其他线程的请求和到达的完成项，调用就绪回调，最后一次性提交本轮产生的操作
+    void drive() {
+        driving = true;
+        takeRequests();
+        do {
+            ring.drainCompletions([this](const io_uring_cqe& cqe) {
+                handleCompletion(cqe);
+            });
+        } while (ring.hasOverflow() && ring.flushOverflow() >= 0);
+
+        for (Channel* channel : touched) {
+            channel->readyPending = false;
+            std::shared_ptr<std::function<void()>> ready;
+            {
+                std::lock_guard<std::mutex> lock(channel->callbackMutex);
+                ready = channel->onReady;
+            }
+            if (ready) {
+                (*ready)();
+            }
+        }
+        touched.clear();
+
+        processRetiring();
+        driving = false;
+        submit();
+    }
+
+    void takeRequests() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            working.swap(requests);
+            for (unsigned slot : working) {
+                if (slots[slot]) {
+                    slots[slot]->requested = false;
+                }
+            }
+            kickPending = false;
+        }
+        for (unsigned slot : working) {
+            // 请求发出后连接可能已经释放，槽位甚至已被新连接占用；多处理一次没有副作用
+            if (Channel* channel = slots[slot].get()) {
+                service(*channel);
+            }
+        }
+        working.clear();
+    }
+
+    void submit() {
+        int result = ring.submit();
+        if (result == -EBUSY || result == -EAGAIN) {
+            // 完成队列积压，先处理完成项再重试
+            wakeup();
+        }
+    }
+
+    io_uring_sqe* nextSqe() {
+        io_uring_sqe* sqe = ring.getSqe();
+        while (!sqe) {
+            // 提交队列已满：先交给内核腾出位置（SQPOLL 模式下等内核线程取走）
+            ring.submit();
+            sqe = ring.getSqe();
+            if (!sqe) {
+                std::this_thread::yield();
+            }
+        }
+        return sqe;
+    }
+
+    void setTarget(io_uring_sqe* sqe, const Channel& channel) {
+        if (fixedFiles) {
+            sqe->fd = static_cast<int>(channel.slot);
+            sqe->flags |= IOSQE_FIXED_FILE;
+        } else {
+            sqe->fd = channel.fd;
+        }
+    }
+
+    // 需持有 channel.mutex
+    void prepareSend(Channel& channel) {
+        size_t start = static_cast<size_t>(channel.sendHead % channel.sendCapacity);
+        size_t length = std::min<size_t>(channel.sendTail - channel.sendHead, channel.sendCapacity - start);
+        io_uring_sqe* sqe = nextSqe();
+        sqe->opcode = IORING_OP_SEND;
+        setTarget(sqe, channel);
+        sqe->addr = reinterpret_cast<uint64_t>(channel.sendBuffer + start);
+        sqe->len = static_cast<uint32_t>(length);
+        sqe->msg_flags = MSG_NOSIGNAL;
+        channel.zeroCopyInFlight = fixedBuffers && length >= ZERO_COPY_MIN_BYTES;
+        if (channel.zeroCopyInFlight) {
+            sqe->opcode = IORING_OP_SEND_ZC;
+            sqe->ioprio = IORING_RECVSEND_FIXED_BUF;
+            sqe->buf_index = static_cast<uint16_t>(channel.slot);
+        }
+        sqe->user_data = (static_cast<uint64_t>(channel.slot) << OP_BITS) | OP_SEND;
+        channel.sendInFlight = true;
+    }
+
+    // 按发送的完成项更新在途状态，返回 false 表示这是零拷贝的通知（数据不再被内核引用）。需持有 channel.mutex
+    static bool completeSend(Channel& channel, const io_uring_cqe& cqe) {
+        if (cqe.flags & IORING_CQE_F_NOTIF) {
+            channel.zeroCopyHeld.pop_front();
+            return false;
+        }
+        channel.sendInFlight = false;
+        if (channel.zeroCopyInFlight && (cqe.flags & IORING_CQE_F_MORE)) {
+            // 还会有通知到来；同一时刻只有一个发送在途，sendHead 就是这次发送的起点
+            channel.zeroCopyHeld.push_back(channel.sendHead);
+        }
+        return true;
+    }
+
+    // 需持有 channel.mutex
+    void prepareReceive(Channel& channel) {
+        io_uring_sqe* sqe = nextSqe();
+        sqe->opcode = IORING_OP_RECV;
+        setTarget(sqe, channel);
+        sqe->flags |= IOSQE_BUFFER_SELECT;
+        sqe->buf_group = BUFFER_GROUP;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->user_data = (static_cast<uint64_t>(channel.slot) << OP_BITS) | OP_RECEIVE;
+        channel.receiveArmed = true;
+    }
+
+    // 按连接当前的状态补上需要的操作（事件循环线程）
+    void service(Channel& channel) {
+        std::lock_guard<std::mutex> lock(channel.mutex);
+        bool sendable = channel.sendError == 0 && !(channel.closing && channel.lingerExpired);
+        if (!channel.sendInFlight && channel.sendTail > channel.sendHead && sendable) {
+            prepareSend(channel);
+        }
+        if (!channel.receiveArmed && !channel.receiveStarved && !channel.endOfStream &&
+            channel.receiveError == 0 && !channel.closing) {
+            prepareReceive(channel);
+        }
+        if (channel.closing && !channel.retireQueued) {
+            channel.retireQueued = true;
+            retiring.push_back(&channel);
+        }
+    }
+
+    void handleCompletion(const io_uring_cqe& cqe) {
+        unsigned slot = static_cast<unsigned>(cqe.user_data >> OP_BITS);
+        Channel* channel = slots[slot].get();
+        if (!channel) {
+            return;
+        }
+        if ((cqe.user_data & ((1u << OP_BITS) - 1)) == OP_RECEIVE) {
+            onReceive(*channel, cqe);
+        } else {
+            onSend(*channel, cqe);
+        }
+        if (!channel->readyPending) {
+            channel->readyPending = true;
+            touched.push_back(channel);
+        }
+    }
+
+    void onReceive(Channel& channel, const io_uring_cqe& cqe) {
+        bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+        bool starvedNow = false;
+        uint16_t dropped = 0;
+        bool drop = false;
+        {
+            std::lock_guard<std::mutex> lock(channel.mutex);
+            if (!more) {
+                channel.receiveArmed = false;
+            }
+            if (cqe.res > 0) {
+                uint16_t bufferId = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+                if (channel.closing) {
+                    // 已关闭的连接不再有人读取，缓冲区直接归还
+                    dropped = bufferId;
+                    drop = true;
+                } else {
+                    channel.received.push_back({bufferId, 0, static_cast<uint32_t>(cqe.res)});
+                }
+            } else if (cqe.res == 0) {
+                channel.endOfStream = true;
+            } else if (cqe.res == -ENOBUFS) {
+                channel.receiveStarved = true;
+                starvedNow = true;
+            } else {
+                channel.receiveError = -cqe.res;
+            }
+            // 多次接收也可能因为完成队列溢出等原因结束，只要连接还正常就重新挂起
+            if (!more && cqe.res > 0 && !channel.closing) {
+                prepareReceive(channel);
+            }
+        }
+
+        if (drop) {
+            recycle(&dropped, 1);
+        }
+        if (starvedNow) {
+            std::lock_guard<std::mutex> lock(mutex);
+            starved.push_back(channel.slot);
+            starvedCount++;
+        }
+        if (cqe.res == 0 || (cqe.res < 0 && cqe.res != -ENOBUFS)) {
+            channel.peerClosed = true;
+        }
+        channel.readEpoch.fetch_add(1);
+        channel.notify();
+    }
+
+    void onSend(Channel& channel, const io_uring_cqe& cqe) {
+        {
+            std::lock_guard<std::mutex> lock(channel.mutex);
+            // 零拷贝的通知只释放发送缓冲区的空间
+            if (completeSend(channel, cqe)) {
+                if (cqe.res > 0) {
+                    channel.sendHead += static_cast<uint64_t>(cqe.res);
+                } else if (cqe.res == -EINVAL && channel.zeroCopyInFlight) {
+                    // 套接字或内核不支持零拷贝发送，之后都改用普通发送重发
+                    fixedBuffers = false;
+                } else if (cqe.res < 0) {
+                    channel.sendError = -cqe.res;
+                    channel.peerClosed = true;
+                }
+            }
+            bool sendable = channel.sendError == 0 && !(channel.closing && channel.lingerExpired);
+            if (!channel.sendInFlight && channel.sendTail > channel.sendHead && sendable) {
+                prepareSend(channel);
+            }
+        }
+        channel.writeEpoch.fetch_add(1);
+        channel.notify();
+    }
+
+    void processRetiring() {
+        for (size_t i = 0; i < retiring.size();) {
+            if (tryRetire(*retiring[i])) {
+                retiring[i] = retiring.back();
+                retiring.pop_back();
+            } else {
+                i++;
+            }
+        }
+    }
+
+    // 已关闭的连接先写完剩余数据（最多等到 linger 超时），再关闭两个方向，
+    // 等挂起的发送和多次接收都结束后才关闭描述符并释放槽位。释放后返回 true
+    bool tryRetire(Channel& channel) {
+        FifoQueue<Received> held;
+        {
+            std::lock_guard<std::mutex> lock(channel.mutex);
+            bool unsent = channel.sendTail > channel.sendHead && channel.sendError == 0 && !channel.lingerExpired;
+            if (unsent) {
+                return false;
+            }
+            if (!channel.shutdownDone) {
+                ::shutdown(channel.fd, SHUT_RDWR);
+                channel.shutdownDone = true;
+            }
+            if (channel.hasPendingOps()) {
+                return false;
+            }
+            // 归还缓冲区可能要处理其他连接，不能持有本连接的锁
+            std::swap(held, channel.received);
+        }
+        while (!held.empty()) {
+            uint16_t bufferId = held.front().bufferId;
+            held.pop_front();
+            recycle(&bufferId, 1);
+        }
+
+        unsigned slot = channel.slot;
+        if (fixedFiles) {
+            ring.updateFile(slot, -1);
+        }
+        ::close(channel.fd);
+        channel.fd = -1;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        freeSlots.push_back(slot);
+        // 连接在这里销毁
+        slots[slot].reset();
+        return true;
+    }
+
+    // 析构前让内核结束所有挂起的操作，之后才能释放它们引用的缓冲区
+    void drainBeforeClose() {
+        size_t busy = 0;
+        for (auto& channel : slots) {
+            if (channel && channel->hasPendingOps()) {
+                ::shutdown(channel->fd, SHUT_RDWR);
+                channel->closing = true;
+                busy++;
+            }
+        }
+        while (busy > 0) {
+            if (ring.submitAndWait(1) < 0) {
+                return;
+            }
+            ring.drainCompletions([this](const io_uring_cqe& cqe) {
+                Channel* channel = slots[cqe.user_data >> OP_BITS].get();
+                if (!channel) {
+                    return;
+                }
+                if ((cqe.user_data & ((1u << OP_BITS) - 1)) == OP_RECEIVE) {
+                    if (!(cqe.flags & IORING_CQE_F_MORE)) {
+                        channel->receiveArmed = false;
+                    }
+                } else {
+                    completeSend(*channel, cqe);
+                }
+            });
+            busy = 0;
+            for (auto& channel : slots) {
+                if (channel && channel->hasPendingOps()) {
+                    busy++;
+                }
+            }
+        }
+    }
+};
+
+class IoUringBackend::Socket : public TransportSocket {
+public:
+    explicit Socket(std::shared_ptr<State> state)
+        : state_(std::move(state))
+        , blockedReadEpoch_(0)
+        , blockedWriteEpoch_(0)
+    {
+    }
+
+    ~Socket() override {
+        close();
+    }
+
+    bool connect(const std::string& host, uint16_t port, int timeoutMs) override {
+        close();
+
+        sockaddr_in serverAddr{};
+        serverAddr.sin_family = AF_INET;
+        serverAddr.sin_port = htons(port);
+        if (inet_pton(AF_INET, host.c_str(), &serverAddr.sin_addr) != 1) {
+            return false;
+        }
+
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+        if (fd < 0) {
+            return false;
+        }
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&serverAddr), sizeof(serverAddr)) < 0) {
+            pollfd pfd{fd, POLLOUT, 0};
+            int error = 0;
+            socklen_t len = sizeof(error);
+            if (errno != EINPROGRESS || ::poll(&pfd, 1, timeoutMs) <= 0 ||
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error != 0) {
+                ::close(fd);
+                return false;
+            }
+        }
+        if (!attach(fd)) {
+            ::close(fd);
+            return false;
+        }
+        return true;
+    }
+
+    bool adopt(intptr_t handle) override {
+        close();
+        return attach(static_cast<int>(handle));
+    }
+
+    IoResult send(const void* data, size_t length) override {
+        IoVec vec{const_cast<void*>(data), length};
+        return sendv(&vec, 1);
+    }
+
+    IoResult receive(void* buffer, size_t length) override {
+        IoVec vec{buffer, length};
+        return receivev(&vec, 1);
+    }
+
+    // 拷入发送缓冲区后立即返回，由事件循环提交
+    IoResult sendv(const IoVec* vecs, size_t count) override {
+        if (!channel_) {
+            return {IoStatus::CLOSED, 0};
+        }
+        Channel& channel = *channel_;
+
+        // 先记录计数再检查空间，避免错过检查之后到来的完成
+        uint64_t epoch = channel.writeEpoch.load();
+        size_t total = 0;
+        bool kick;
+        {
+            std::lock_guard<std::mutex> lock(channel.mutex);
+            if (channel.sendError != 0) {
+                return {errorStatus(channel.sendError), 0};
+            }
+            size_t space = channel.sendCapacity - static_cast<size_t>(channel.sendTail - channel.releasedHead());
+            if (space == 0) {
+                blockedWriteEpoch_ = epoch;
+                return {IoStatus::WOULD_BLOCK, 0};
+            }
+            for (size_t i = 0; i < count && space > 0; i++) {
+                size_t length = std::min(vecs[i].length, space);
+                const uint8_t* source = static_cast<const uint8_t*>(vecs[i].base);
+                size_t position = static_cast<size_t>(channel.sendTail % channel.sendCapacity);
+                size_t first = std::min(length, channel.sendCapacity - position);
+                std::memcpy(channel.sendBuffer + position, source, first);
+                std::memcpy(channel.sendBuffer, source + first, length - first);
+                channel.sendTail += length;
+                space -= length;
+                total += length;
+            }
+            kick = !channel.sendInFlight;
+        }
+        if (kick) {
+            state_->request(channel);
+        }
+        return {IoStatus::OK, total};
+    }
+
+    // 从多次接收已经交来的缓冲区中拷出，不进入内核
+    IoResult receivev(const IoVec* vecs, size_t count) override {
+        if (!channel_) {
+            return {IoStatus::CLOSED, 0};
+        }
+        Channel& channel = *channel_;
+
+        uint64_t epoch = channel.readEpoch.load();
+        uint16_t bufferIds[RECYCLE_BATCH];
+        size_t freed = 0;
+        size_t total = 0;
+        {
+            std::lock_guard<std::mutex> lock(channel.mutex);
+            size_t index = 0;
+            size_t offset = 0;
+            while (!channel.received.empty() && index < count && freed < RECYCLE_BATCH) {
+                Received& chunk = channel.received.front();
+                size_t length = std::min<size_t>(chunk.length - chunk.offset, vecs[index].length - offset);
+                std::memcpy(static_cast<uint8_t*>(vecs[index].base) + offset,
+                            state_->bufferAddress(chunk.bufferId) + chunk.offset, length);
+                chunk.offset += static_cast<uint32_t>(length);
+                offset += length;
+                total += length;
+                if (chunk.offset == chunk.length) {
+                    bufferIds[freed++] = chunk.bufferId;
+                    channel.received.pop_front();
+                }
+                if (offset == vecs[index].length) {
+                    index++;
+                    offset = 0;
+                }
+            }
+            if (total == 0) {
+                if (channel.receiveError != 0) {
+                    return {errorStatus(channel.receiveError), 0};
+                }
+                if (channel.endOfStream) {
+                    return {IoStatus::CLOSED, 0};
+                }
+                blockedReadEpoch_ = epoch;
+                return {IoStatus::WOULD_BLOCK, 0};
+            }
+        }
+        state_->recycle(bufferIds, freed);
+        return {IoStatus::OK, total};
+    }
+
+    bool waitReadable(int timeoutMs) override {
+        return channel_ && channel_->waitChange(channel_->readEpoch, blockedReadEpoch_, timeoutMs);
+    }
+
+    bool waitWritable(int timeoutMs) override {
+        return channel_ && channel_->waitChange(channel_->writeEpoch, blockedWriteEpoch_, timeoutMs);
+    }
+
+    bool getPathInfo(PathInfo& info) const override {
+        if (!channel_) {
+            return false;
+        }
+        tcp_info ti{};
+        socklen_t length = sizeof(ti);
+        if (::getsockopt(channel_->fd, IPPROTO_TCP, TCP_INFO, &ti, &length) != 0) {
+            return false;
+        }
+
+        info.rttMicros = ti.tcpi_rtt;
+        info.mss = ti.tcpi_snd_mss;
+        info.bytesInFlight = static_cast<uint64_t>(ti.tcpi_unacked) * ti.tcpi_snd_mss;
+        info.totalRetransmits = ti.tcpi_total_retrans;
+        info.bytesAcked = length >= offsetof(tcp_info, tcpi_bytes_acked) + sizeof(ti.tcpi_bytes_acked)
+                              ? ti.tcpi_bytes_acked : 0;
+        info.deliveryRate = length >= offsetof(tcp_info, tcpi_delivery_rate) + sizeof(ti.tcpi_delivery_rate)
+                                ? ti.tcpi_delivery_rate : 0;
+        return true;
+    }
+
+    // 多次接收收到 0 字节或出错时由事件循环线程记录
+    bool isPeerClosed() const override {
+        return channel_ && channel_->peerClosed.load();
+    }
+
+    bool setReadyCallback(std::function<void()> callback) override {
+        readyCallback_ = callback ? std::make_shared<std::function<void()>>(std::move(callback)) : nullptr;
+        if (channel_) {
+            std::lock_guard<std::mutex> lock(channel_->callbackMutex);
+            channel_->onReady = readyCallback_;
+        }
+        return true;
+    }
+
+    // 已经拷入发送缓冲区的数据仍会写出，与关闭普通套接字时内核继续发送缓冲区中的数据一致
+    void close() override {
+        if (!channel_) {
+            return;
+        }
+        std::shared_ptr<Channel> channel = std::move(channel_);
+        bool unsent;
+        {
+            std::lock_guard<std::mutex> lock(channel->mutex);
+            channel->closing = true;
+            unsent = channel->sendTail > channel->sendHead && channel->sendError == 0;
+        }
+        {
+            std::lock_guard<std::mutex> lock(channel->callbackMutex);
+            channel->onReady.reset();
+        }
+        channel->closed = true;
+        {
+            std::lock_guard<std::mutex> lock(channel->waitMutex);
+            channel->cond.notify_all();
+        }
+
+        if (unsent) {
+            std::weak_ptr<Channel> weakChannel = channel;
+            std::weak_ptr<State> weakState = state_;
+            state_->loop->runAfter(CLOSE_LINGER_MICROS, [weakChannel, weakState] {
+                auto channel = weakChannel.lock();
+                auto state = weakState.lock();
+                if (!channel || !state) {
+                    return;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(channel->mutex);
+                    channel->lingerExpired = true;
+                }
+                state->request(*channel);
+            });
+        }
+        state_->request(*channel);
+    }
+
+    bool isOpen() const override {
+        return channel_ != nullptr;
+    }
+
+private:
+    // 为已连接的描述符分配槽位并挂起多次接收，失败时描述符仍归调用方
+    bool attach(int fd) {
+        // io_uring 对非阻塞的描述符不会等待就绪，而是直接返回 EAGAIN；
+        // 恢复为阻塞模式后由内核在就绪时完成操作（不会阻塞任何线程）
+        int flags = ::fcntl(fd, F_GETFL);
+        if (flags < 0 || ::fcntl(fd, F_SETFL, flags & ~O_NONBLOCK) < 0) {
+            return false;
+        }
+        // 小消息由 Protocol 自己合并，关闭 Nagle 以免与对端的延迟确认叠加
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        auto channel = std::make_shared<Channel>();
+        channel->fd = fd;
+        channel->onReady = readyCallback_;
+        if (!state_->attach(channel)) {
+            return false;
+        }
+        channel_ = channel;
+        blockedReadEpoch_ = 0;
+        blockedWriteEpoch_ = 0;
+        // 由事件循环挂起多次接收
+        state_->request(*channel_);
+        return true;
+    }
+
+    std::shared_ptr<State> state_;
+    std::shared_ptr<Channel> channel_;
+    uint64_t blockedReadEpoch_;
+    uint64_t blockedWriteEpoch_;
+    std::shared_ptr<std::function<void()>> readyCallback_;  // 重新连接时转交给新的连接状态
+};
+
+std::shared_ptr<IoUringBackend> IoUringBackend::create(std::shared_ptr<EventLoop> loop) {
+    return create(Config(), std::move(loop));
+}
+
+std::shared_ptr<IoUringBackend> IoUringBackend::create(const Config& config, std::shared_ptr<EventLoop> loop) {
+    if (!isSupported()) {
+        return nullptr;
+    }
+    auto state = std::make_shared<State>();
+    state->config = config;
+    state->loop = loop ? std::move(loop) : EventLoop::getShared();
+    if (!state->init()) {
+        return nullptr;
+    }
+    return std::shared_ptr<IoUringBackend>(new IoUringBackend(std::move(state)));
+}
+
+bool IoUringBackend::isSupported() {
+    static const bool supported = [] {
+        if (!IoUring::isAvailable()) {
+            return false;
+        }
+        IoUring ring;
+        return ring.init(1) && ring.supportsOp(IORING_OP_SEND_ZC);
+    }();
+    return supported;
+}
+
+IoUringBackend::IoUringBackend(std::shared_ptr<State> state)
+    : state(std::move(state))
+{
+}
+
+IoUringBackend::~IoUringBackend() = default;
+
+std::unique_ptr<TransportSocket> IoUringBackend::createSocket() {
+    return std::unique_ptr<TransportSocket>(new Socket(state));
+}
+
+const char* IoUringBackend::name() const {
+    return "io_uring";
+}
+
+bool IoUringBackend::runAfter(int64_t delayMicros, std::function<void()> task) {
+    if (delayMicros <= 0) {
+        state->loop->queueInLoop(std::move(task));
+        return true;
+    }
+    state->loop->runAfter(delayMicros, std::move(task));
+    return true;
+}
+
+std::shared_ptr<EventLoop> IoUringBackend::getLoop() const {
+    return state->loop;
+}
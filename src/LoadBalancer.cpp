@@ -1,158 +1,836 @@
 #include "LoadBalancer.h"
 #include "Utils.h"
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <queue>
 #include <random>
 #include <stdexcept>
+#include <thread>
+#include <unordered_map>
 
-LoadBalancer::LoadBalancer()
-    : currentStrategy(Strategy::ROUND_ROBIN), currentIndex(0)
+namespace
 {
+    // 每个线程固定使用一个读者计数分片
+    size_t threadStripe(size_t stripes)
+    {
+        static std::atomic<size_t> nextStripe{0};
+        thread_local size_t stripe = nextStripe.fetch_add(1);
+        return stripe % stripes;
+    }
+
+    // 每个线程独立的随机数状态，只在线程第一次使用时播种
+    std::mt19937_64 &threadRandom()
+    {
+        thread_local std::mt19937_64 gen(std::random_device{}());
+        return gen;
+    }
+
+    // 用一个64位随机数取出 [0, n) 中两个不同的下标（n >= 2）：第二个在其余 n-1 个中选，再跳过第一个
+    void pickTwo(size_t n, size_t &first, size_t &second)
+    {
+        uint64_t random = threadRandom()();
+        first = static_cast<size_t>(((random >> 32) * n) >> 32);
+        second = static_cast<size_t>(((random & 0xffffffffULL) * (n - 1)) >> 32);
+        if (second >= first)
+        {
+            second++;
+        }
+    }
+
+    // 峰值 EWMA 的时间戳：单调时钟的毫秒数，只取低32位，比较时按回绕差值计算
+    uint32_t latencyClockMillis()
+    {
+        return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+    }
+
+    uint64_t packLatency(float micros, uint32_t millis)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &micros, sizeof(bits));
+        return (static_cast<uint64_t>(bits) << 32) | millis;
+    }
+
+    float unpackLatency(uint64_t packed)
+    {
+        uint32_t bits = static_cast<uint32_t>(packed >> 32);
+        float micros;
+        std::memcpy(&micros, &bits, sizeof(micros));
+        return micros;
+    }
+
+    // 距上次更新 elapsedMillis 后的衰减系数 exp(-t/τ)
+    double latencyDecay(uint32_t elapsedMillis, uint32_t decayMillis)
+    {
+        return std::exp(-static_cast<double>(elapsedMillis) / decayMillis);
+    }
+
+    // 有在途请求却还没有延迟样本的节点按该代价计算，不会在冷启动时被一拥而上
+    const double UNMEASURED_PENALTY = 1e12;
+
+    // 哈希环上每个节点的虚拟节点数
+    const uint32_t VIRTUAL_NODES_PER_NODE = 160;
+    // Maglev 查找表的最小槽位数（素数），节点较多时取不小于 100 倍节点数的素数
+    const uint64_t MAGLEV_MIN_TABLE_SIZE = 65537;
+
+    uint64_t mix64(uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    // FNV-1a 加上 64 位终结混合，对短 key 分布足够均匀，且不分配内存
+    uint64_t hashBytes(const void *data, size_t length, uint64_t seed)
+    {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        uint64_t h = 14695981039346656037ULL ^ mix64(seed);
+        for (size_t i = 0; i < length; i++)
+        {
+            h ^= bytes[i];
+            h *= 1099511628211ULL;
+        }
+        return mix64(h);
+    }
+
+    // 节点身份只取决于地址和端口，因此节点变化时其他节点的位置不动
+    uint64_t hashEndpoint(const std::string &address, uint16_t port, uint64_t seed)
+    {
+        return mix64(hashBytes(address.data(), address.size(), seed) ^ port);
+    }
+
+    bool isPrime(uint64_t value)
+    {
+        if (value < 2)
+        {
+            return false;
+        }
+        for (uint64_t d = 2; d * d <= value; d++)
+        {
+            if (value % d == 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 平滑加权轮询序列的最大长度（约简后的总权重超过时按比例缩小权重）
+    const uint64_t MAX_SCHEDULE_LENGTH = 1 << 20;
+    // 逐步模拟 nginx 算法的计算量上限（节点数 x 序列长度），超过时改用堆实现的步进调度
+    const uint64_t MAX_EXACT_SCHEDULE_WORK = 1 << 24;
+
+    // 生成一个完整周期的平滑加权轮询序列，返回的是 weights 中的下标
+    std::vector<uint32_t> smoothSchedule(std::vector<uint64_t> weights)
+    {
+        uint64_t divisor = 0;
+        for (uint64_t w : weights)
+        {
+            divisor = std::gcd(divisor, w);
+        }
+        uint64_t total = 0;
+        for (auto &w : weights)
+        {
+            w /= divisor;
+            total += w;
+        }
+
+        if (total > MAX_SCHEDULE_LENGTH)
+        {
+            double scale = static_cast<double>(MAX_SCHEDULE_LENGTH) / total;
+            total = 0;
+            for (auto &w : weights)
+            {
+                w = std::max<uint64_t>(1, static_cast<uint64_t>(w * scale));
+                total += w;
+            }
+        }
+
+        std::vector<uint32_t> schedule;
+        schedule.reserve(total);
+
+        if (total * weights.size() <= MAX_EXACT_SCHEDULE_WORK)
+        {
+            // nginx 平滑加权轮询：每轮所有节点的当前权重加上自身权重，选最大者并减去总权重
+            std::vector<int64_t> current(weights.size(), 0);
+            for (uint64_t step = 0; step < total; step++)
+            {
+                size_t best = 0;
+                for (size_t i = 0; i < weights.size(); i++)
+                {
+                    current[i] += static_cast<int64_t>(weights[i]);
+                    if (current[i] > current[best])
+                    {
+                        best = i;
+                    }
+                }
+                current[best] -= static_cast<int64_t>(total);
+                schedule.push_back(static_cast<uint32_t>(best));
+            }
+        }
+        else
+        {
+            // 节点很多时按虚拟时间步进调度：节点第 k 次被选中的时刻为 (k+0.5)/w，同样均匀交错
+            using Entry = std::pair<double, uint32_t>;
+            std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+            std::vector<uint64_t> picks(weights.size(), 0);
+            for (size_t i = 0; i < weights.size(); i++)
+            {
+                heap.push({0.5 / weights[i], static_cast<uint32_t>(i)});
+            }
+            for (uint64_t step = 0; step < total; step++)
+            {
+                uint32_t i = heap.top().second;
+                heap.pop();
+                schedule.push_back(i);
+                picks[i]++;
+                heap.push({(picks[i] + 0.5) / weights[i], i});
+            }
+        }
+
+        return schedule;
+    }
 }
 
-void LoadBalancer::addNode(const std::string &address, uint16_t port, uint32_t weight)
+// 读端临界区：登记到当前纪元的计数上，写入方据此判断旧快照何时可以回收
+class LoadBalancer::ReadGuard
 {
-    // 检查节点是否已存在
-    auto it = std::find_if(nodes.begin(), nodes.end(),
-                           [&](const Node &node)
-                           {
-                               return node.address == address && node.port == port;
-                           });
+public:
+    explicit ReadGuard(LoadBalancer &lb)
+        : lb_(lb), stripe_(threadStripe(READER_STRIPES))
+    {
+        while (true)
+        {
+            parity_ = lb_.epoch.load() & 1;
+            lb_.readers[stripe_].count[parity_].fetch_add(1);
+            // 登记期间纪元没有变化才算进入成功，否则写入方可能已经不再等待这一组计数
+            if ((lb_.epoch.load() & 1) == parity_)
+            {
+                break;
+            }
+            lb_.readers[stripe_].count[parity_].fetch_sub(1);
+        }
+        snap_ = lb_.snapshot.load();
+    }
+
+    ~ReadGuard()
+    {
+        lb_.readers[stripe_].count[parity_].fetch_sub(1);
+    }
 
-    if (it != nodes.end())
+    const Snapshot &snapshot() const
     {
-        it->weight = weight;
-        it->isActive = true;
+        return *snap_;
     }
-    else
+
+private:
+    LoadBalancer &lb_;
+    size_t stripe_;
+    uint64_t parity_;
+    const Snapshot *snap_;
+};
+
+LoadBalancer::LoadBalancer()
+    : snapshot(new Snapshot()), epoch(0), currentStrategy(Strategy::ROUND_ROBIN), currentIndex(0),
+      nextListenerId(0)
+{
+    for (auto &stripe : readers)
     {
-        nodes.push_back({address, port, weight, 0, true});
+        stripe.count[0] = 0;
+        stripe.count[1] = 0;
     }
 }
 
-void LoadBalancer::removeNode(const std::string &address, uint16_t port)
+LoadBalancer::~LoadBalancer()
 {
-    nodes.erase(
-        std::remove_if(nodes.begin(), nodes.end(),
-                       [&](const Node &node)
-                       {
-                           return node.address == address && node.port == port;
-                       }),
-        nodes.end());
+    delete snapshot.load();
 }
 
-std::pair<std::string, uint16_t> LoadBalancer::getNextNode()
+void LoadBalancer::addNode(const std::string &address, uint16_t port, uint32_t weight)
 {
-    if (nodes.empty())
+    // 只改权重时节点集合不变，不通知
+    bool changed = true;
+    NodeEvent event = NodeEvent::ADDED;
     {
-        throw std::runtime_error("No available nodes");
+        std::lock_guard<std::mutex> lock(writeMutex);
+
+        // 检查节点是否已存在
+        auto it = std::find_if(nodes.begin(), nodes.end(),
+                               [&](const Node &node)
+                               {
+                                   return node.address == address && node.port == port;
+                               });
+
+        if (it != nodes.end())
+        {
+            if (it->weight == weight && it->isActive)
+            {
+                return;
+            }
+            changed = !it->isActive;
+            event = NodeEvent::ACTIVATED;
+            it->weight = weight;
+            it->isActive = true;
+        }
+        else
+        {
+            nodes.push_back({address, port, weight, std::make_shared<NodeStats>(), true});
+        }
+
+        publishSnapshot();
     }
 
-    switch (currentStrategy)
+    if (changed)
     {
-    case Strategy::ROUND_ROBIN:
-        return getRoundRobinNode();
-    case Strategy::WEIGHTED_ROUND_ROBIN:
-        return getWeightedRoundRobinNode();
-    case Strategy::LEAST_CONNECTIONS:
-        return getLeastConnectionsNode();
-    case Strategy::RANDOM:
-        return getRandomNode();
-    default:
-        throw std::runtime_error("Unknown strategy");
+        notifyNodeListeners(event, address, port);
     }
 }
 
+void LoadBalancer::addNodes(const std::vector<NodeSpec> &specs)
+{
+    std::vector<std::pair<NodeEvent, size_t>> events;
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+
+        // 按地址索引已有节点，避免每个节点都线性查找
+        auto key = [](const std::string &address, uint16_t port)
+        {
+            return address + ':' + std::to_string(port);
+        };
+        std::unordered_map<std::string, size_t> index;
+        index.reserve(nodes.size() + specs.size());
+        for (size_t i = 0; i < nodes.size(); i++)
+        {
+            index.emplace(key(nodes[i].address, nodes[i].port), i);
+        }
+
+        bool modified = false;
+        for (size_t i = 0; i < specs.size(); i++)
+        {
+            const NodeSpec &spec = specs[i];
+            auto inserted = index.emplace(key(spec.address, spec.port), nodes.size());
+            if (inserted.second)
+            {
+                nodes.push_back({spec.address, spec.port, spec.weight, std::make_shared<NodeStats>(), true});
+                events.push_back({NodeEvent::ADDED, i});
+                modified = true;
+                continue;
+            }
+
+            Node &node = nodes[inserted.first->second];
+            if (node.weight == spec.weight && node.isActive)
+            {
+                continue;
+            }
+            if (!node.isActive)
+            {
+                events.push_back({NodeEvent::ACTIVATED, i});
+            }
+            node.weight = spec.weight;
+            node.isActive = true;
+            modified = true;
+        }
+
+        if (!modified)
+        {
+            return;
+        }
+        publishSnapshot();
+    }
+
+    for (const auto &event : events)
+    {
+        notifyNodeListeners(event.first, specs[event.second].address, specs[event.second].port);
+    }
+}
+
+void LoadBalancer::removeNode(const std::string &address, uint16_t port)
+{
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+
+        auto it = std::remove_if(nodes.begin(), nodes.end(),
+                                 [&](const Node &node)
+                                 {
+                                     return node.address == address && node.port == port;
+                                 });
+        if (it == nodes.end())
+        {
+            return;
+        }
+        nodes.erase(it, nodes.end());
+
+        publishSnapshot();
+    }
+
+    notifyNodeListeners(NodeEvent::REMOVED, address, port);
+}
+
+std::pair<std::string, uint16_t> LoadBalancer::getNextNode()
+{
+    ReadGuard guard(*this);
+    const Node &node = selectNode(guard.snapshot());
+    return {node.address, node.port};
+}
+
+std::pair<std::string, uint16_t> LoadBalancer::getNextNode(const std::string &key)
+{
+    ReadGuard guard(*this);
+    const Node &node = selectNode(guard.snapshot(), key);
+    return {node.address, node.port};
+}
+
+LoadBalancer::Lease LoadBalancer::acquireNode()
+{
+    ReadGuard guard(*this);
+    const Node &node = selectNode(guard.snapshot());
+    return Lease(node.address, node.port, node.stats);
+}
+
+LoadBalancer::Lease LoadBalancer::acquireNode(const std::string &key)
+{
+    ReadGuard guard(*this);
+    const Node &node = selectNode(guard.snapshot(), key);
+    return Lease(node.address, node.port, node.stats);
+}
+
 void LoadBalancer::setStrategy(Strategy strategy)
 {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    // 先发布带有新策略所需结构的快照再切换，选择节点时看到的快照总有当前策略要用的结构
+    if (strategy != currentStrategy.load())
+    {
+        publishSnapshot(strategy);
+    }
     currentStrategy = strategy;
     currentIndex = 0; // 重置索引
 }
 
 void LoadBalancer::updateNodeStatus(const std::string &address, uint16_t port, bool isActive)
 {
-    auto it = std::find_if(nodes.begin(), nodes.end(),
-                           [&](const Node &node)
-                           {
-                               return node.address == address && node.port == port;
-                           });
-
-    if (it != nodes.end())
     {
+        std::lock_guard<std::mutex> lock(writeMutex);
+
+        auto it = std::find_if(nodes.begin(), nodes.end(),
+                               [&](const Node &node)
+                               {
+                                   return node.address == address && node.port == port;
+                               });
+
+        if (it == nodes.end() || it->isActive == isActive)
+        {
+            return;
+        }
         it->isActive = isActive;
+        publishSnapshot();
     }
+
+    notifyNodeListeners(isActive ? NodeEvent::ACTIVATED : NodeEvent::DEACTIVATED, address, port);
 }
 
-// 私有辅助方法实现
-std::pair<std::string, uint16_t> LoadBalancer::getRoundRobinNode()
+std::vector<std::pair<std::string, uint16_t>> LoadBalancer::getActiveNodes()
 {
-    // 找到下一个活跃节点
-    size_t startIndex = currentIndex;
-    do
+    ReadGuard guard(*this);
+    const Snapshot &snap = guard.snapshot();
+    std::vector<std::pair<std::string, uint16_t>> result;
+    result.reserve(snap.activeNodes.size());
+    for (size_t index : snap.activeNodes)
+    {
+        result.emplace_back(snap.nodes[index].address, snap.nodes[index].port);
+    }
+    return result;
+}
+
+size_t LoadBalancer::addNodeListener(NodeListener listener)
+{
+    std::lock_guard<std::mutex> lock(listenerMutex);
+    size_t id = nextListenerId++;
+    listeners.emplace_back(id, std::move(listener));
+    return id;
+}
+
+void LoadBalancer::removeNodeListener(size_t id)
+{
+    std::lock_guard<std::mutex> lock(listenerMutex);
+    listeners.erase(std::remove_if(listeners.begin(), listeners.end(),
+                                   [id](const std::pair<size_t, NodeListener> &entry)
+                                   {
+                                       return entry.first == id;
+                                   }),
+                    listeners.end());
+}
+
+void LoadBalancer::notifyNodeListeners(NodeEvent event, const std::string &address, uint16_t port)
+{
+    // 复制一份再回调，回调中可以安全地增删订阅
+    std::vector<std::pair<size_t, NodeListener>> current;
+    {
+        std::lock_guard<std::mutex> lock(listenerMutex);
+        current = listeners;
+    }
+    for (auto &entry : current)
+    {
+        entry.second(event, address, port);
+    }
+}
+
+void LoadBalancer::publishSnapshot()
+{
+    publishSnapshot(currentStrategy.load());
+}
+
+void LoadBalancer::publishSnapshot(Strategy strategy)
+{
+    Snapshot *next = new Snapshot();
+    next->nodes = nodes;
+    for (size_t i = 0; i < next->nodes.size(); i++)
+    {
+        if (next->nodes[i].isActive)
+        {
+            next->activeNodes.push_back(i);
+            next->totalActiveWeight += next->nodes[i].weight;
+            if (next->nodes[i].weight > 0)
+            {
+                next->weightedNodes.push_back(static_cast<uint32_t>(i));
+            }
+        }
+    }
+
+    // 构建耗时与总权重或节点数成正比，放在写入方，选择节点的路径上从不分配内存或等待
+    buildStructures(*next, currentStrategy.load());
+    if (strategy != currentStrategy.load())
+    {
+        buildStructures(*next, strategy);
+    }
+
+    const Snapshot *old = snapshot.exchange(next);
+    waitForReaders();
+    delete old;
+}
+
+void LoadBalancer::buildStructures(Snapshot &snap, Strategy strategy)
+{
+    switch (strategy)
+    {
+    case Strategy::WEIGHTED_ROUND_ROBIN:
+        buildSmoothSchedule(snap);
+        break;
+    case Strategy::WEIGHTED_RANDOM:
+        buildAliasTable(snap);
+        break;
+    case Strategy::CONSISTENT_HASH:
+        buildHashRing(snap);
+        break;
+    case Strategy::MAGLEV:
+        buildMaglevTable(snap);
+        break;
+    default:
+        break;
+    }
+}
+
+void LoadBalancer::buildSmoothSchedule(Snapshot &snap)
+{
+    std::vector<uint64_t> weights;
+    weights.reserve(snap.weightedNodes.size());
+    for (uint32_t index : snap.weightedNodes)
+    {
+        weights.push_back(snap.nodes[index].weight);
+    }
+    if (!weights.empty())
+    {
+        snap.smoothSchedule = smoothSchedule(std::move(weights));
+    }
+}
+
+void LoadBalancer::buildAliasTable(Snapshot &snap)
+{
+    // Vose 别名法：把每列的概率补齐到 1/n，不足的部分由一个“别名”节点填充
+    size_t n = snap.weightedNodes.size();
+    double total = static_cast<double>(snap.totalActiveWeight);
+    std::vector<double> scaled(n);
+    std::vector<uint32_t> small;
+    std::vector<uint32_t> large;
+    for (size_t i = 0; i < n; i++)
+    {
+        scaled[i] = snap.nodes[snap.weightedNodes[i]].weight * static_cast<double>(n) / total;
+        (scaled[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+    }
+
+    const double scale32 = 4294967296.0;
+    snap.aliasTable.assign(n, {UINT32_MAX, 0});
+    while (!small.empty() && !large.empty())
     {
-        currentIndex = (currentIndex + 1) % nodes.size();
-        if (nodes[currentIndex].isActive)
+        uint32_t less = small.back();
+        small.pop_back();
+        uint32_t more = large.back();
+
+        snap.aliasTable[less] = {static_cast<uint32_t>(std::min(scaled[less] * scale32, scale32 - 1)), more};
+        scaled[more] -= 1.0 - scaled[less];
+        if (scaled[more] < 1.0)
         {
-            return {nodes[currentIndex].address, nodes[currentIndex].port};
+            large.pop_back();
+            small.push_back(more);
         }
-    } while (currentIndex != startIndex);
+    }
 
-    throw std::runtime_error("No active nodes available");
+    // 剩余的列概率为1（浮点误差导致的也按1处理），别名指向自己
+    for (uint32_t i : large)
+    {
+        snap.aliasTable[i] = {UINT32_MAX, i};
+    }
+    for (uint32_t i : small)
+    {
+        snap.aliasTable[i] = {UINT32_MAX, i};
+    }
 }
 
-std::pair<std::string, uint16_t> LoadBalancer::getWeightedRoundRobinNode()
+void LoadBalancer::buildHashRing(Snapshot &snap)
 {
-    uint32_t totalWeight = 0;
-    for (const auto &node : nodes)
+    snap.hashRing.reserve(snap.activeNodes.size() * VIRTUAL_NODES_PER_NODE);
+    for (size_t index : snap.activeNodes)
     {
-        if (node.isActive)
+        const Node &node = snap.nodes[index];
+        for (uint32_t replica = 0; replica < VIRTUAL_NODES_PER_NODE; replica++)
         {
-            totalWeight += node.weight;
+            snap.hashRing.push_back({hashEndpoint(node.address, node.port, replica), static_cast<uint32_t>(index)});
         }
     }
 
-    if (totalWeight == 0)
+    std::sort(snap.hashRing.begin(), snap.hashRing.end(),
+              [](const RingPoint &a, const RingPoint &b)
+              {
+                  return a.hash < b.hash || (a.hash == b.hash && a.node < b.node);
+              });
+}
+
+void LoadBalancer::buildMaglevTable(Snapshot &snap)
+{
+    size_t n = snap.activeNodes.size();
+    if (n == 0)
     {
-        throw std::runtime_error("No active nodes available");
+        return;
     }
 
-    uint32_t point = rand() % totalWeight;
-    uint32_t accumulator = 0;
+    uint64_t tableSize = std::max<uint64_t>(MAGLEV_MIN_TABLE_SIZE, n * 100);
+    while (!isPrime(tableSize))
+    {
+        tableSize++;
+    }
+
+    // 每个节点按自己的排列 (offset + j * skip) % M 依次认领空槽，直到填满
+    std::vector<uint64_t> offset(n);
+    std::vector<uint64_t> skip(n);
+    std::vector<uint64_t> next(n, 0);
+    for (size_t i = 0; i < n; i++)
+    {
+        const Node &node = snap.nodes[snap.activeNodes[i]];
+        offset[i] = hashEndpoint(node.address, node.port, 0x6d61676c6576ULL) % tableSize;
+        skip[i] = hashEndpoint(node.address, node.port, 0x736b6970ULL) % (tableSize - 1) + 1;
+    }
 
-    for (const auto &node : nodes)
+    snap.maglevTable.assign(tableSize, UINT32_MAX);
+    uint64_t filled = 0;
+    while (true)
     {
-        if (!node.isActive)
-            continue;
-        accumulator += node.weight;
-        if (accumulator > point)
+        for (size_t i = 0; i < n; i++)
         {
-            return {node.address, node.port};
+            uint64_t slot = (offset[i] + next[i] * skip[i]) % tableSize;
+            while (snap.maglevTable[slot] != UINT32_MAX)
+            {
+                next[i]++;
+                slot = (offset[i] + next[i] * skip[i]) % tableSize;
+            }
+            snap.maglevTable[slot] = static_cast<uint32_t>(snap.activeNodes[i]);
+            next[i]++;
+            if (++filled == tableSize)
+            {
+                return;
+            }
         }
     }
+}
 
-    // 防止意外情况，返回第一个活跃节点
-    for (const auto &node : nodes)
+void LoadBalancer::waitForReaders()
+{
+    // 翻转纪元后，新读者只能看到新快照；等待旧纪元的读者全部退出
+    uint64_t parity = epoch.fetch_add(1) & 1;
+    while (true)
     {
-        if (node.isActive)
+        int64_t active = 0;
+        for (const auto &stripe : readers)
+        {
+            active += stripe.count[parity].load();
+        }
+        if (active == 0)
         {
-            return {node.address, node.port};
+            return;
         }
+        std::this_thread::yield();
     }
+}
 
-    throw std::runtime_error("No active nodes available");
+LoadBalancer::Lease::Lease(const std::string &address, uint16_t port, std::shared_ptr<NodeStats> stats)
+    : address_(address), port_(port), stats_(std::move(stats))
+{
+    stats_->activeConnections.fetch_add(1, std::memory_order_relaxed);
 }
 
-std::pair<std::string, uint16_t> LoadBalancer::getLeastConnectionsNode()
+LoadBalancer::Lease::~Lease()
+{
+    release();
+}
+
+LoadBalancer::Lease::Lease(Lease &&other) noexcept
+    : address_(std::move(other.address_)), port_(other.port_), stats_(std::move(other.stats_))
+{
+}
+
+LoadBalancer::Lease &LoadBalancer::Lease::operator=(Lease &&other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        address_ = std::move(other.address_);
+        port_ = other.port_;
+        stats_ = std::move(other.stats_);
+    }
+    return *this;
+}
+
+void LoadBalancer::Lease::reportLatency(uint64_t latencyMicros)
+{
+    if (!stats_)
+    {
+        return;
+    }
+
+    // 样本高于当前估计时直接取样本（峰值），否则按距上次更新的时间做指数加权，越久未更新样本权重越大
+    double sample = static_cast<double>(latencyMicros);
+    uint64_t current = stats_->latency.load(std::memory_order_relaxed);
+    uint64_t next;
+    do
+    {
+        uint32_t now = latencyClockMillis();
+        double estimate = unpackLatency(current);
+        if (sample > estimate)
+        {
+            estimate = sample;
+        }
+        else
+        {
+            double w = latencyDecay(now - static_cast<uint32_t>(current), LATENCY_DECAY_MILLIS);
+            estimate = estimate * w + sample * (1 - w);
+        }
+        next = packLatency(static_cast<float>(estimate), now);
+    } while (!stats_->latency.compare_exchange_weak(current, next, std::memory_order_relaxed));
+}
+
+void LoadBalancer::Lease::release()
+{
+    if (stats_)
+    {
+        stats_->activeConnections.fetch_sub(1, std::memory_order_relaxed);
+        stats_.reset();
+    }
+}
+
+const LoadBalancer::Node &LoadBalancer::selectNode(const Snapshot &snap)
+{
+    if (snap.nodes.empty())
+    {
+        throw std::runtime_error("No available nodes");
+    }
+
+    switch (currentStrategy.load(std::memory_order_relaxed))
+    {
+    case Strategy::ROUND_ROBIN:
+        return getRoundRobinNode(snap);
+    case Strategy::WEIGHTED_ROUND_ROBIN:
+        return getWeightedRoundRobinNode(snap);
+    case Strategy::LEAST_CONNECTIONS:
+        return getLeastConnectionsNode(snap);
+    case Strategy::RANDOM:
+        return getRandomNode(snap);
+    case Strategy::WEIGHTED_RANDOM:
+        return getWeightedRandomNode(snap);
+    case Strategy::CONSISTENT_HASH:
+        // 没有 key 时用随机哈希值，分布与按 key 选择一致
+        return getHashRingNode(snap, threadRandom()());
+    case Strategy::MAGLEV:
+        return getMaglevNode(snap, threadRandom()());
+    case Strategy::POWER_OF_TWO_CHOICES:
+        return getPowerOfTwoChoicesNode(snap);
+    case Strategy::PEAK_EWMA:
+        return getPeakEwmaNode(snap);
+    default:
+        throw std::runtime_error("Unknown strategy");
+    }
+}
+
+const LoadBalancer::Node &LoadBalancer::selectNode(const Snapshot &snap, const std::string &key)
+{
+    Strategy strategy = currentStrategy.load(std::memory_order_relaxed);
+    if (strategy != Strategy::CONSISTENT_HASH && strategy != Strategy::MAGLEV)
+    {
+        return selectNode(snap);
+    }
+
+    if (snap.nodes.empty())
+    {
+        throw std::runtime_error("No available nodes");
+    }
+
+    uint64_t keyHash = hashBytes(key.data(), key.size(), 0);
+    return strategy == Strategy::CONSISTENT_HASH ? getHashRingNode(snap, keyHash)
+                                                 : getMaglevNode(snap, keyHash);
+}
+
+// 私有辅助方法实现
+const LoadBalancer::Node &LoadBalancer::getRoundRobinNode(const Snapshot &snap)
+{
+    // 活跃节点列表已在快照中预先算好，游标只需一次原子自增
+    if (snap.activeNodes.empty())
+    {
+        throw std::runtime_error("No active nodes available");
+    }
+
+    size_t index = currentIndex.fetch_add(1, std::memory_order_relaxed) % snap.activeNodes.size();
+    return snap.nodes[snap.activeNodes[index]];
+}
+
+const LoadBalancer::Node &LoadBalancer::getWeightedRoundRobinNode(const Snapshot &snap)
+{
+    // 序列在发布快照时已经生成，按游标取下一个即可
+    if (snap.smoothSchedule.empty())
+    {
+        throw std::runtime_error("No active nodes available");
+    }
+
+    size_t position = currentIndex.fetch_add(1, std::memory_order_relaxed) % snap.smoothSchedule.size();
+    return snap.nodes[snap.weightedNodes[snap.smoothSchedule[position]]];
+}
+
+const LoadBalancer::Node &LoadBalancer::getLeastConnectionsNode(const Snapshot &snap)
 {
     const Node *selectedNode = nullptr;
     uint32_t minConnections = UINT32_MAX;
 
-    for (const auto &node : nodes)
+    for (size_t index : snap.activeNodes)
     {
-        if (!node.isActive)
-            continue;
-        if (node.currentConnections < minConnections)
+        const Node &node = snap.nodes[index];
+        uint32_t connections = node.stats->activeConnections.load(std::memory_order_relaxed);
+        if (!selectedNode || connections < minConnections)
         {
-            minConnections = node.currentConnections;
+            minConnections = connections;
             selectedNode = &node;
         }
     }
@@ -162,29 +840,121 @@ std::pair<std::string, uint16_t> LoadBalancer::getLeastConnectionsNode()
         throw std::runtime_error("No active nodes available");
     }
 
-    return {selectedNode->address, selectedNode->port};
+    return *selectedNode;
 }
 
-std::pair<std::string, uint16_t> LoadBalancer::getRandomNode()
+const LoadBalancer::Node &LoadBalancer::getRandomNode(const Snapshot &snap)
 {
-    std::vector<const Node *> activeNodes;
-    for (const auto &node : nodes)
+    if (snap.activeNodes.empty())
     {
-        if (node.isActive)
-        {
-            activeNodes.push_back(&node);
-        }
+        throw std::runtime_error("No active nodes available");
+    }
+
+    std::uniform_int_distribution<size_t> dis(0, snap.activeNodes.size() - 1);
+
+    return snap.nodes[snap.activeNodes[dis(threadRandom())]];
+}
+
+const LoadBalancer::Node &LoadBalancer::getWeightedRandomNode(const Snapshot &snap)
+{
+    if (snap.aliasTable.empty())
+    {
+        throw std::runtime_error("No active nodes available");
     }
 
-    if (activeNodes.empty())
+    // 一个64位随机数：高32位选列（乘法取高位，无取模偏差），低32位决定取本列还是别名
+    uint64_t random = threadRandom()();
+    size_t column = static_cast<size_t>(((random >> 32) * snap.aliasTable.size()) >> 32);
+    const AliasEntry &entry = snap.aliasTable[column];
+    uint32_t chosen = static_cast<uint32_t>(random) < entry.threshold ? static_cast<uint32_t>(column) : entry.alias;
+
+    return snap.nodes[snap.weightedNodes[chosen]];
+}
+
+const LoadBalancer::Node &LoadBalancer::getHashRingNode(const Snapshot &snap, uint64_t keyHash)
+{
+    if (snap.hashRing.empty())
     {
         throw std::runtime_error("No active nodes available");
     }
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, activeNodes.size() - 1);
+    // 顺时针找到第一个不小于 key 哈希值的虚拟节点
+    auto it = std::lower_bound(snap.hashRing.begin(), snap.hashRing.end(), keyHash,
+                               [](const RingPoint &point, uint64_t hash)
+                               {
+                                   return point.hash < hash;
+                               });
+    if (it == snap.hashRing.end())
+    {
+        it = snap.hashRing.begin();
+    }
+
+    return snap.nodes[it->node];
+}
 
-    const Node *selectedNode = activeNodes[dis(gen)];
-    return {selectedNode->address, selectedNode->port};
-}
\ No newline at end of file
+const LoadBalancer::Node &LoadBalancer::getMaglevNode(const Snapshot &snap, uint64_t keyHash)
+{
+    if (snap.maglevTable.empty())
+    {
+        throw std::runtime_error("No active nodes available");
+    }
+
+    return snap.nodes[snap.maglevTable[keyHash % snap.maglevTable.size()]];
+}
+
+const LoadBalancer::Node &LoadBalancer::getPowerOfTwoChoicesNode(const Snapshot &snap)
+{
+    size_t n = snap.activeNodes.size();
+    if (n == 0)
+    {
+        throw std::runtime_error("No active nodes available");
+    }
+    if (n == 1)
+    {
+        return snap.nodes[snap.activeNodes[0]];
+    }
+
+    size_t first, second;
+    pickTwo(n, first, second);
+
+    const Node &a = snap.nodes[snap.activeNodes[first]];
+    const Node &b = snap.nodes[snap.activeNodes[second]];
+    uint32_t loadA = a.stats->activeConnections.load(std::memory_order_relaxed);
+    uint32_t loadB = b.stats->activeConnections.load(std::memory_order_relaxed);
+    return loadB < loadA ? b : a;
+}
+
+const LoadBalancer::Node &LoadBalancer::getPeakEwmaNode(const Snapshot &snap)
+{
+    size_t n = snap.activeNodes.size();
+    if (n == 0)
+    {
+        throw std::runtime_error("No active nodes available");
+    }
+    if (n == 1)
+    {
+        return snap.nodes[snap.activeNodes[0]];
+    }
+
+    size_t first, second;
+    pickTwo(n, first, second);
+
+    // 预期代价 = 衰减到当前时刻的延迟估计 × (在途连接数 + 1)：慢节点和积压的节点都少分流量，
+    // 估计只读不写，选择过程没有任何写共享
+    uint32_t now = latencyClockMillis();
+    auto cost = [now](const Node &node)
+    {
+        uint64_t packed = node.stats->latency.load(std::memory_order_relaxed);
+        uint32_t pending = node.stats->activeConnections.load(std::memory_order_relaxed);
+        double latency = unpackLatency(packed) * latencyDecay(now - static_cast<uint32_t>(packed), LATENCY_DECAY_MILLIS);
+        if (latency == 0 && pending != 0)
+        {
+            return UNMEASURED_PENALTY + pending;
+        }
+        return latency * (pending + 1);
+    };
+
+    const Node &a = snap.nodes[snap.activeNodes[first]];
+    const Node &b = snap.nodes[snap.activeNodes[second]];
+    return cost(b) < cost(a) ? b : a;
+}
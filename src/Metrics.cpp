@@ -0,0 +1,428 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <mutex>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+// 最高位的位置，value 不为 0
+unsigned highestBit(uint64_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<unsigned>(index);
+#else
+    return 63 - static_cast<unsigned>(__builtin_clzll(value));
+#endif
+}
+
+// 只有所属线程写入：读出再写回即可，不需要带锁前缀的原子加法；快照线程读到的是某个较新的值
+inline void bump(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+struct HistogramShard {
+    std::array<std::atomic<uint64_t>, LatencyHistogram::BUCKET_COUNT> counts{};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> min{std::numeric_limits<uint64_t>::max()};
+    std::atomic<uint64_t> max{0};
+
+    void record(uint64_t value) {
+        bump(counts[LatencyHistogram::bucketIndex(value)], 1);
+        bump(sum, value);
+        if (value < min.load(std::memory_order_relaxed)) {
+            min.store(value, std::memory_order_relaxed);
+        }
+        if (value > max.load(std::memory_order_relaxed)) {
+            max.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    LatencyHistogram load() const {
+        LatencyHistogram::Buckets buckets;
+        for (size_t i = 0; i < buckets.size(); i++) {
+            buckets[i] = counts[i].load(std::memory_order_relaxed);
+        }
+        return LatencyHistogram(buckets, sum.load(std::memory_order_relaxed),
+                                min.load(std::memory_order_relaxed), max.load(std::memory_order_relaxed));
+    }
+};
+
+struct Shard {
+    std::array<std::atomic<uint64_t>, Metrics::COUNTER_COUNT> counters{};
+    std::array<HistogramShard, Metrics::LATENCY_COUNT> latencies;
+
+    void addTo(Metrics::Snapshot& snapshot) const {
+        for (size_t i = 0; i < counters.size(); i++) {
+            snapshot.counters[i] += counters[i].load(std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < latencies.size(); i++) {
+            snapshot.latencies[i].merge(latencies[i].load());
+        }
+    }
+};
+
+// 所有线程的分片，以及已退出线程的累计值
+struct Registry {
+    std::mutex mutex;
+    std::vector<Shard*> shards;
+    Metrics::Snapshot retired;
+};
+
+Registry& registry() {
+    // 不析构：其他线程的 thread_local 可能在静态对象析构之后才退出
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+// 分片在堆上（约 14KB），线程第一次记录时创建
+class LocalShard {
+public:
+    LocalShard() : shard(new Shard()) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.shards.push_back(shard.get());
+    }
+
+    ~LocalShard() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        shard->addTo(r.retired);
+        r.shards.erase(std::find(r.shards.begin(), r.shards.end(), shard.get()));
+    }
+
+    Shard& get() {
+        return *shard;
+    }
+
+private:
+    std::unique_ptr<Shard> shard;
+};
+
+Shard& localShard() {
+    thread_local LocalShard local;
+    return local.get();
+}
+
+const char* const COUNTER_NAMES[] = {
+    "connections_opened_total",
+    "connections_closed_total",
+    "bytes_sent_total",
+    "bytes_received_total",
+    "messages_sent_total",
+    "messages_received_total",
+    "frames_sent_total",
+    "send_calls_total",
+    "receive_calls_total",
+    "send_blocked_total",
+    "pacing_waits_total",
+    "loss_events_total",
+    "frames_compressed_total",
+    "compression_saved_bytes_total",
+};
+
+const char* const COUNTER_HELP[] = {
+    "Connections established or adopted.",
+    "Connections that became unusable or were closed.",
+    "Bytes written to sockets, including frame headers.",
+    "Bytes read from sockets, including frame headers.",
+    "Messages completely written to the kernel.",
+    "Messages delivered to receivers.",
+    "Frames (chunks) completely written to the kernel.",
+    "Send calls issued to the socket backend.",
+    "Receive calls issued to the socket backend.",
+    "Sends that found the socket buffer full.",
+    "Times sending waited for pacing tokens or the coalescing deadline.",
+    "Retransmission reports forwarded to the congestion controller.",
+    "Frames sent with a compressed payload.",
+    "Payload bytes saved by compressing frames.",
+};
+
+const char* const LATENCY_NAMES[] = {
+    "send_latency_seconds",
+    "receive_latency_seconds",
+    "round_trip_latency_seconds",
+};
+
+const char* const LATENCY_HELP[] = {
+    "Time from submitting a message until it is completely written to the kernel.",
+    "Time from posting a receive until a message is delivered.",
+    "Time from submitting a request until its response is delivered.",
+};
+
+static_assert(sizeof(COUNTER_NAMES) / sizeof(COUNTER_NAMES[0]) == Metrics::COUNTER_COUNT, "counter names");
+static_assert(sizeof(COUNTER_HELP) / sizeof(COUNTER_HELP[0]) == Metrics::COUNTER_COUNT, "counter help");
+static_assert(sizeof(LATENCY_NAMES) / sizeof(LATENCY_NAMES[0]) == Metrics::LATENCY_COUNT, "latency names");
+static_assert(sizeof(LATENCY_HELP) / sizeof(LATENCY_HELP[0]) == Metrics::LATENCY_COUNT, "latency help");
+
+// Prometheus 直方图的边界：2^0 到 2^26 微秒（约 67 秒），都是某个桶的上界加一
+constexpr unsigned PROMETHEUS_MAX_EXPONENT = 26;
+
+void appendHeader(std::string& out, const std::string& name, const char* help, const char* type) {
+    out += "# HELP " + name + " " + help + "\n";
+    out += "# TYPE " + name + " " + type + "\n";
+}
+
+void appendSample(std::string& out, const std::string& name, const std::string& labels, uint64_t value) {
+    out += name;
+    if (!labels.empty()) {
+        out += "{" + labels + "}";
+    }
+    out += " " + std::to_string(value) + "\n";
+}
+
+std::string formatSeconds(double seconds) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.9g", seconds);
+    return text;
+}
+
+// 标签值中的反斜杠、双引号和换行需要转义
+std::string escapeLabel(const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+} // namespace
+
+LatencyHistogram::LatencyHistogram()
+    : counts{}
+    , total(0)
+    , sumValue(0)
+    , minValue(std::numeric_limits<uint64_t>::max())
+    , maxValue(0)
+{
+}
+
+LatencyHistogram::LatencyHistogram(const Buckets& buckets, uint64_t sum, uint64_t min, uint64_t max)
+    : counts(buckets)
+    , total(0)
+    , sumValue(sum)
+    , minValue(min)
+    , maxValue(max)
+{
+    for (uint64_t count : counts) {
+        total += count;
+    }
+}
+
+size_t LatencyHistogram::bucketIndex(uint64_t value) {
+    if (value < SUB_BUCKET_COUNT) {
+        return static_cast<size_t>(value);
+    }
+    unsigned exponent = highestBit(value);
+    if (exponent >= MAX_EXPONENT) {
+        return BUCKET_COUNT - 1;
+    }
+    // 最高 SUB_BUCKET_BITS+1 位决定桶：指数选区间，其后 SUB_BUCKET_BITS 位选区间内的子桶
+    unsigned shift = exponent - SUB_BUCKET_BITS;
+    return SUB_BUCKET_COUNT + shift * SUB_BUCKET_COUNT + static_cast<size_t>((value >> shift) - SUB_BUCKET_COUNT);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index) {
+    if (index < SUB_BUCKET_COUNT) {
+        return index;
+    }
+    if (index >= BUCKET_COUNT - 1) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    size_t shift = (index - SUB_BUCKET_COUNT) / SUB_BUCKET_COUNT;
+    uint64_t sub = (index - SUB_BUCKET_COUNT) % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT;
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value) {
+    counts[bucketIndex(value)]++;
+    total++;
+    sumValue += value;
+    minValue = std::min(minValue, value);
+    maxValue = std::max(maxValue, value);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < counts.size(); i++) {
+        counts[i] += other.counts[i];
+    }
+    total += other.total;
+    sumValue += other.sumValue;
+    minValue = std::min(minValue, other.minValue);
+    maxValue = std::max(maxValue, other.maxValue);
+}
+
+void LatencyHistogram::reset() {
+    *this = LatencyHistogram();
+}
+
+uint64_t LatencyHistogram::count() const {
+    return total;
+}
+
+uint64_t LatencyHistogram::sum() const {
+    return sumValue;
+}
+
+uint64_t LatencyHistogram::min() const {
+    return total > 0 ? minValue : 0;
+}
+
+uint64_t LatencyHistogram::max() const {
+    return maxValue;
+}
+
+double LatencyHistogram::mean() const {
+    return total > 0 ? static_cast<double>(sumValue) / total : 0.0;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const {
+    if (total == 0) {
+        return 0;
+    }
+    p = std::min(std::max(p, 0.0), 100.0);
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p / 100.0 * total)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return std::max(std::min(bucketUpperBound(i), maxValue), min());
+        }
+    }
+    return maxValue;
+}
+
+uint64_t LatencyHistogram::countAtOrBelow(uint64_t value) const {
+    uint64_t below = 0;
+    size_t last = bucketIndex(value);
+    for (size_t i = 0; i <= last; i++) {
+        below += counts[i];
+    }
+    // value 不是桶的上界时，它所在的桶只有一部分不超过 value，按不计入处理
+    if (bucketUpperBound(last) != value) {
+        below -= counts[last];
+    }
+    return below;
+}
+
+const LatencyHistogram::Buckets& LatencyHistogram::buckets() const {
+    return counts;
+}
+
+void Metrics::add(Counter counter, uint64_t value) {
+    bump(localShard().counters[static_cast<size_t>(counter)], value);
+}
+
+void Metrics::record(Latency latency, uint64_t micros) {
+    localShard().latencies[static_cast<size_t>(latency)].record(micros);
+}
+
+Metrics::Snapshot Metrics::snapshot() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    Snapshot snapshot = r.retired;
+    for (const Shard* shard : r.shards) {
+        shard->addTo(snapshot);
+    }
+    return snapshot;
+}
+
+const char* Metrics::name(Counter counter) {
+    return COUNTER_NAMES[static_cast<size_t>(counter)];
+}
+
+const char* Metrics::name(Latency latency) {
+    return LATENCY_NAMES[static_cast<size_t>(latency)];
+}
+
+std::string Metrics::toPrometheus(const Snapshot& snapshot, const std::string& prefix) {
+    std::string out;
+    for (size_t i = 0; i < COUNTER_COUNT; i++) {
+        std::string metric = prefix + "_" + COUNTER_NAMES[i];
+        appendHeader(out, metric, COUNTER_HELP[i], "counter");
+        appendSample(out, metric, "", snapshot.counters[i]);
+    }
+
+    for (size_t i = 0; i < LATENCY_COUNT; i++) {
+        const LatencyHistogram& histogram = snapshot.latencies[i];
+        std::string metric = prefix + "_" + LATENCY_NAMES[i];
+        appendHeader(out, metric, LATENCY_HELP[i], "histogram");
+        // 2^k 微秒以下的样本数，即不超过 2^k-1（一个桶的上界）的样本数
+        for (unsigned k = 0; k <= PROMETHEUS_MAX_EXPONENT; k++) {
+            uint64_t bound = uint64_t(1) << k;
+            appendSample(out, metric + "_bucket", "le=\"" + formatSeconds(bound / 1e6) + "\"",
+                         histogram.countAtOrBelow(bound - 1));
+        }
+        appendSample(out, metric + "_bucket", "le=\"+Inf\"", histogram.count());
+        out += metric + "_sum " + formatSeconds(histogram.sum() / 1e6) + "\n";
+        appendSample(out, metric + "_count", "", histogram.count());
+    }
+    return out;
+}
+
+std::string Metrics::toPrometheus(const std::vector<std::pair<std::string, ConnectionSnapshot>>& connections,
+                                  const std::string& prefix) {
+    std::vector<std::string> labels;
+    labels.reserve(connections.size());
+    for (const auto& connection : connections) {
+        labels.push_back("connection=\"" + escapeLabel(connection.first) + "\"");
+    }
+
+    // 同一指标的所有样本必须连续出现
+    std::string out;
+    for (size_t i = 0; i < COUNTER_COUNT; i++) {
+        std::string metric = prefix + "_connection_" + COUNTER_NAMES[i];
+        appendHeader(out, metric, COUNTER_HELP[i], "counter");
+        for (size_t c = 0; c < connections.size(); c++) {
+            appendSample(out, metric, labels[c], connections[c].second.counters[i]);
+        }
+    }
+
+    struct Gauge {
+        const char* name;
+        const char* help;
+        uint64_t (*value)(const ConnectionSnapshot&);
+    };
+    static const Gauge gauges[] = {
+        {"congestion_window_bytes", "Current congestion window.",
+         [](const ConnectionSnapshot& s) { return s.congestionWindow; }},
+        {"slow_start_threshold_bytes", "Current slow start threshold, 0 if the controller has none.",
+         [](const ConnectionSnapshot& s) { return s.slowStartThreshold; }},
+        {"pacing_rate_bytes", "Current pacing rate in bytes per second, 0 if unpaced.",
+         [](const ConnectionSnapshot& s) { return s.pacingRate; }},
+        {"queued_bytes", "Bytes queued for sending.",
+         [](const ConnectionSnapshot& s) { return s.queuedBytes; }},
+        {"chunk_size_bytes", "Current chunk size.",
+         [](const ConnectionSnapshot& s) { return static_cast<uint64_t>(s.chunkSize); }},
+    };
+    for (const Gauge& gauge : gauges) {
+        std::string metric = prefix + "_connection_" + gauge.name;
+        appendHeader(out, metric, gauge.help, "gauge");
+        for (size_t c = 0; c < connections.size(); c++) {
+            appendSample(out, metric, labels[c], gauge.value(connections[c].second));
+        }
+    }
+
+    std::string rtt = prefix + "_connection_smoothed_rtt_seconds";
+    appendHeader(out, rtt, "Smoothed round-trip time reported by the transport.", "gauge");
+    for (size_t c = 0; c < connections.size(); c++) {
+        out += rtt + "{" + labels[c] + "} " + formatSeconds(connections[c].second.smoothedRttMicros / 1e6) + "\n";
+    }
+    return out;
+}
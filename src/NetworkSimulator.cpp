@@ -0,0 +1,577 @@
+#include "NetworkSimulator.h"
+#include "Framing.h"
+#include "TcpChunkOptimization.h"
+#include "ChunkSizeTuner.h"
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <queue>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+// 内部时间以纳秒计，高速链路上单个包的串行化时间也能精确表示
+const int64_t NANOS_PER_MICRO = 1000;
+const int64_t NANOS_PER_SECOND = 1000000000;
+
+const int64_t TICK_NANOS = 100 * 1000 * 1000;     // 无采样要求时调整分块大小的周期
+const int64_t MIN_RTO_NANOS = 200 * 1000 * 1000;  // 与 Linux 相同的最小重传超时
+const int64_t INITIAL_RTO_NANOS = NANOS_PER_SECOND;
+const uint64_t REORDER_THRESHOLD = 3;             // 之后有3个包被确认即判定丢失
+const uint64_t BULK_WRITE_BYTES = 64 * 1024;      // 不分帧时每次生成的应用数据量
+
+// 排队时延直方图：100us 一档，最后一档收纳更大的值
+const int64_t DELAY_BUCKET_NANOS = 100 * 1000;
+const size_t DELAY_BUCKETS = 20000;
+
+enum class EventType {
+    FLOW_START,
+    SEND,
+    ACK,
+    RTO,
+    TICK
+};
+
+struct Event {
+    int64_t time;
+    uint64_t order;     // 同一时刻的事件按加入顺序处理，保证确定性
+    EventType type;
+    uint32_t flow;
+    uint64_t value;     // ACK: 包序号
+
+    bool operator>(const Event& other) const {
+        return time != other.time ? time > other.time : order > other.order;
+    }
+};
+
+enum class PacketState {
+    IN_FLIGHT,
+    ACKED,
+    LOST
+};
+
+struct SentPacket {
+    uint32_t size;
+    PacketState state;
+    int64_t sentTime;
+    uint64_t deliveredAtSend;       // 发送时已投递的字节数，用于计算投递速率
+    int64_t deliveredTimeAtSend;
+};
+
+// 与标准库分布实现无关的 [0,1) 均匀随机数，不同平台结果一致
+double uniform(std::mt19937_64& rng) {
+    return static_cast<double>(rng() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+} // namespace
+
+class NetworkSimulator::SimulatorImpl {
+public:
+    SimulatorImpl(const LinkConfig& link, uint64_t seed)
+        : link_(link)
+        , seed_(seed)
+    {
+    }
+
+    size_t addFlow(const FlowConfig& flow) {
+        configs_.push_back(flow);
+        return configs_.size() - 1;
+    }
+
+    Report run(int64_t durationMicros, int64_t sampleIntervalMicros) {
+        // 每次运行都从相同的初始状态开始，同一配置可以重复运行得到相同结果
+        rng_.seed(seed_);
+        events_ = decltype(events_)();
+        order_ = 0;
+        linkBusyUntil_ = 0;
+        enqueuedBytes_ = 0;
+        queueDrops_ = 0;
+        randomDrops_ = 0;
+        burstState_ = false;
+        queueLimit_ = link_.queueBytes;
+        if (queueLimit_ == 0) {
+            queueLimit_ = link_.bandwidth * 2 * link_.propagationDelayMicros / 1000000;
+        }
+
+        flows_.clear();
+        for (size_t i = 0; i < configs_.size(); i++) {
+            flows_.emplace_back(configs_[i]);
+            Flow& flow = flows_.back();
+            flow.controller = flow.config.factory ? flow.config.factory()
+                                                  : CongestionController::create(flow.config.controller, flow.config.mss);
+            flow.baseRtt = 2 * link_.propagationDelayMicros * NANOS_PER_MICRO +
+                           flow.config.extraDelayMicros * NANOS_PER_MICRO + serialization(flow.config.mss);
+            schedule(flow.config.startMicros * NANOS_PER_MICRO, EventType::FLOW_START, static_cast<uint32_t>(i), 0);
+        }
+
+        Report report{};
+        int64_t end = durationMicros * NANOS_PER_MICRO;
+        int64_t sampleInterval = sampleIntervalMicros * NANOS_PER_MICRO;
+        int64_t tick = sampleInterval > 0 ? sampleInterval : TICK_NANOS;
+        schedule(tick, EventType::TICK, 0, 0);
+
+        int64_t now = 0;
+        while (!events_.empty() && events_.top().time <= end && !allFinished()) {
+            Event event = events_.top();
+            events_.pop();
+            now = event.time;
+
+            switch (event.type) {
+                case EventType::FLOW_START:
+                    startFlow(flows_[event.flow], now);
+                    break;
+                case EventType::SEND:
+                    flows_[event.flow].sendScheduled = false;
+                    trySend(flows_[event.flow], now);
+                    break;
+                case EventType::ACK:
+                    onAck(flows_[event.flow], event.value, now);
+                    break;
+                case EventType::RTO:
+                    onRetransmitTimeout(flows_[event.flow], now);
+                    break;
+                case EventType::TICK:
+                    onTick(now, tick, sampleInterval > 0 ? &report.timeline : nullptr);
+                    schedule(now + tick, EventType::TICK, 0, 0);
+                    break;
+            }
+        }
+        if (!allFinished()) {
+            now = end;
+        }
+
+        fillReport(report, now);
+        return report;
+    }
+
+private:
+    struct Flow {
+        explicit Flow(const FlowConfig& config)
+            : config(config)
+        {
+            chunker.setMaxChunkSize(64 * 1024);
+            appRemaining = config.bytes;
+        }
+
+        FlowConfig config;
+        std::unique_ptr<CongestionController> controller;
+        TcpChunkOptimization chunker;
+        ChunkSizeTuner tuner;
+        int64_t baseRtt = 0;
+        bool started = false;
+        bool finished = false;
+        int64_t startTime = 0;
+        int64_t completionTime = -1;
+
+        // 待发送的线上字节（新数据与重传），以及生成数据时的应用/线上字节数
+        uint64_t appRemaining = 0;
+        uint64_t wireQueued = 0;
+        uint64_t payloadGenerated = 0;
+        uint64_t wireGenerated = 0;
+
+        std::deque<SentPacket> packets;  // 从 firstSeq 开始的已发送包
+        uint64_t firstSeq = 0;
+        uint64_t nextSeq = 0;
+        uint64_t inflight = 0;
+        uint64_t highestAcked = 0;
+        uint64_t recoveryPoint = 0;      // 该序号之前的丢包属于同一个拥塞事件
+        uint64_t delivered = 0;
+        int64_t deliveredTime = 0;
+
+        int64_t nextSendTime = 0;
+        bool sendScheduled = false;
+        bool rtoArmed = false;
+        int64_t srtt = 0;
+        int64_t rttvar = 0;
+
+        uint64_t packetsSent = 0;
+        uint64_t packetsLost = 0;
+        uint64_t wireDelivered = 0;
+        std::vector<uint64_t> delayHistogram = std::vector<uint64_t>(DELAY_BUCKETS, 0);
+        double delaySum = 0;
+        uint64_t delayCount = 0;
+
+        // 当前采样周期内的统计
+        uint64_t intervalDelivered = 0;
+    };
+
+    LinkConfig link_;
+    uint64_t seed_;
+    std::vector<FlowConfig> configs_;
+
+    std::mt19937_64 rng_;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events_;
+    uint64_t order_ = 0;
+    std::vector<Flow> flows_;
+
+    uint64_t queueLimit_ = 0;
+    int64_t linkBusyUntil_ = 0;
+    uint64_t enqueuedBytes_ = 0;
+    uint64_t queueDrops_ = 0;
+    uint64_t randomDrops_ = 0;
+    bool burstState_ = false;
+
+    void schedule(int64_t time, EventType type, uint32_t flow, uint64_t value) {
+        events_.push({time, order_++, type, flow, value});
+    }
+
+    // FIFO 单服务台：队列中的字节数等于链路剩余的忙碌时间乘以带宽，不需要为离队单独建事件
+    uint64_t queuedBytes(int64_t now) const {
+        if (linkBusyUntil_ <= now) {
+            return 0;
+        }
+        return static_cast<uint64_t>(linkBusyUntil_ - now) * link_.bandwidth / NANOS_PER_SECOND;
+    }
+
+    int64_t serialization(uint64_t bytes) const {
+        return static_cast<int64_t>(bytes * NANOS_PER_SECOND / link_.bandwidth);
+    }
+
+    bool allFinished() const {
+        for (const Flow& flow : flows_) {
+            if (!flow.finished) {
+                return false;
+            }
+        }
+        return !flows_.empty();
+    }
+
+    int64_t retransmitTimeout(const Flow& flow) const {
+        if (flow.srtt == 0) {
+            return INITIAL_RTO_NANOS;
+        }
+        return std::max(MIN_RTO_NANOS, flow.srtt + 4 * flow.rttvar);
+    }
+
+    void startFlow(Flow& flow, int64_t now) {
+        flow.started = true;
+        flow.startTime = now;
+        flow.deliveredTime = now;
+        trySend(flow, now);
+    }
+
+    // 应用写入下一段数据；分帧时按当前分块大小计入帧头开销
+    void generate(Flow& flow) {
+        bool bounded = flow.config.bytes > 0;
+        if (bounded && flow.appRemaining == 0) {
+            return;
+        }
+
+        uint64_t payload = flow.config.messageSize > 0 ? flow.config.messageSize : BULK_WRITE_BYTES;
+        if (bounded) {
+            payload = std::min(payload, flow.appRemaining);
+            flow.appRemaining -= payload;
+        }
+
+        uint64_t wire = payload;
+        if (flow.config.messageSize > 0) {
+            uint64_t chunk = std::max<uint32_t>(flow.chunker.getCurrentOptimalChunkSize(), 1);
+            uint64_t frames = std::max<uint64_t>((payload + chunk - 1) / chunk, 1);
+            wire += frames * FrameHeader::SIZE;
+        }
+
+        flow.payloadGenerated += payload;
+        flow.wireGenerated += wire;
+        flow.wireQueued += wire;
+    }
+
+    void trySend(Flow& flow, int64_t now) {
+        if (!flow.started || flow.finished) {
+            return;
+        }
+
+        while (true) {
+            if (flow.wireQueued < flow.config.mss) {
+                generate(flow);
+            }
+            if (flow.wireQueued == 0) {
+                return;
+            }
+
+            uint32_t size = static_cast<uint32_t>(std::min<uint64_t>(flow.config.mss, flow.wireQueued));
+            uint64_t window = flow.controller->getCongestionWindow();
+            if (flow.inflight > 0 && flow.inflight + size > window) {
+                // 受窗口限制，相当于真实连接阻塞在发送缓冲区上
+                flow.tuner.onBlocked(now / NANOS_PER_MICRO);
+                return;
+            }
+
+            uint64_t rate = flow.controller->getPacingRate();
+            if (rate > 0 && now < flow.nextSendTime) {
+                if (!flow.sendScheduled) {
+                    flow.sendScheduled = true;
+                    schedule(flow.nextSendTime, EventType::SEND, flowIndex(flow), 0);
+                }
+                return;
+            }
+
+            sendPacket(flow, size, now);
+            if (rate > 0) {
+                flow.nextSendTime = std::max(now, flow.nextSendTime) +
+                                    static_cast<int64_t>(size * NANOS_PER_SECOND / rate);
+            }
+        }
+    }
+
+    uint32_t flowIndex(const Flow& flow) const {
+        return static_cast<uint32_t>(&flow - flows_.data());
+    }
+
+    bool dropOnLink() {
+        if (link_.burstEnter > 0) {
+            if (burstState_) {
+                burstState_ = uniform(rng_) >= link_.burstExit;
+            } else {
+                burstState_ = uniform(rng_) < link_.burstEnter;
+            }
+            if (burstState_ && uniform(rng_) < link_.burstLoss) {
+                return true;
+            }
+        }
+        return link_.randomLoss > 0 && uniform(rng_) < link_.randomLoss;
+    }
+
+    void sendPacket(Flow& flow, uint32_t size, int64_t now) {
+        uint64_t seq = flow.nextSeq++;
+        flow.packets.push_back({size, PacketState::IN_FLIGHT, now, flow.delivered, flow.deliveredTime});
+        flow.inflight += size;
+        flow.wireQueued -= size;
+        flow.packetsSent++;
+        flow.tuner.onSent(size, now / NANOS_PER_MICRO);
+
+        if (!flow.rtoArmed) {
+            flow.rtoArmed = true;
+            schedule(now + retransmitTimeout(flow), EventType::RTO, flowIndex(flow), 0);
+        }
+
+        if (dropOnLink()) {
+            randomDrops_++;
+            return;
+        }
+        if (queuedBytes(now) + size > queueLimit_) {
+            queueDrops_++;
+            return;
+        }
+
+        // 排在链路上已有的包之后串行化，离开瓶颈后经传播时延到达接收端，确认再传播回来
+        enqueuedBytes_ += size;
+        int64_t depart = std::max(now, linkBusyUntil_) + serialization(size);
+        linkBusyUntil_ = depart;
+
+        int64_t ackTime = depart + 2 * link_.propagationDelayMicros * NANOS_PER_MICRO +
+                          flow.config.extraDelayMicros * NANOS_PER_MICRO;
+        schedule(ackTime, EventType::ACK, flowIndex(flow), seq);
+    }
+
+    void onAck(Flow& flow, uint64_t seq, int64_t now) {
+        if (seq < flow.firstSeq) {
+            return;
+        }
+        SentPacket& packet = flow.packets[seq - flow.firstSeq];
+        if (packet.state != PacketState::IN_FLIGHT) {
+            return;
+        }
+
+        packet.state = PacketState::ACKED;
+        flow.inflight -= packet.size;
+        flow.delivered += packet.size;
+        flow.deliveredTime = now;
+        flow.wireDelivered += packet.size;
+        flow.intervalDelivered += packet.size;
+
+        // RFC 6298 平滑 RTT
+        int64_t rtt = now - packet.sentTime;
+        if (flow.srtt == 0) {
+            flow.srtt = rtt;
+            flow.rttvar = rtt / 2;
+        } else {
+            flow.rttvar = (3 * flow.rttvar + std::abs(flow.srtt - rtt)) / 4;
+            flow.srtt = (7 * flow.srtt + rtt) / 8;
+        }
+        flow.tuner.onRtt(static_cast<uint32_t>(flow.srtt / NANOS_PER_MICRO));
+
+        int64_t queueDelay = std::max<int64_t>(rtt - flow.baseRtt, 0);
+        flow.delayHistogram[std::min<size_t>(queueDelay / DELAY_BUCKET_NANOS, DELAY_BUCKETS - 1)]++;
+        flow.delaySum += static_cast<double>(queueDelay);
+        flow.delayCount++;
+
+        uint64_t rate = 0;
+        if (now > packet.deliveredTimeAtSend) {
+            rate = (flow.delivered - packet.deliveredAtSend) * NANOS_PER_SECOND /
+                   static_cast<uint64_t>(now - packet.deliveredTimeAtSend);
+        }
+        flow.highestAcked = std::max(flow.highestAcked, seq);
+
+        flow.controller->onAck({packet.size, flow.inflight, static_cast<uint32_t>(rtt / NANOS_PER_MICRO), rate,
+                                now / NANOS_PER_MICRO});
+
+        detectLosses(flow, now);
+        compact(flow);
+
+        if (flow.config.bytes > 0 && flow.appRemaining == 0 && flow.wireQueued == 0 && flow.inflight == 0) {
+            flow.finished = true;
+            flow.completionTime = now;
+            return;
+        }
+        trySend(flow, now);
+    }
+
+    // 序号更大的包已被确认超过阈值个，则更早的在途包判定为丢失
+    void detectLosses(Flow& flow, int64_t now) {
+        for (size_t i = 0; i < flow.packets.size(); i++) {
+            uint64_t seq = flow.firstSeq + i;
+            if (seq + REORDER_THRESHOLD > flow.highestAcked) {
+                break;
+            }
+            if (flow.packets[i].state == PacketState::IN_FLIGHT) {
+                markLost(flow, i);
+                if (seq >= flow.recoveryPoint) {
+                    flow.recoveryPoint = flow.nextSeq;
+                    flow.controller->onLoss({flow.packets[i].size, flow.inflight, false, now / NANOS_PER_MICRO});
+                }
+            }
+        }
+    }
+
+    void markLost(Flow& flow, size_t index) {
+        SentPacket& packet = flow.packets[index];
+        packet.state = PacketState::LOST;
+        flow.inflight -= packet.size;
+        flow.wireQueued += packet.size;  // 重新排队等待重传
+        flow.packetsLost++;
+    }
+
+    void compact(Flow& flow) {
+        while (!flow.packets.empty() && flow.packets.front().state != PacketState::IN_FLIGHT) {
+            flow.packets.pop_front();
+            flow.firstSeq++;
+        }
+    }
+
+    void onRetransmitTimeout(Flow& flow, int64_t now) {
+        flow.rtoArmed = false;
+        compact(flow);
+        if (flow.packets.empty()) {
+            return;
+        }
+
+        int64_t deadline = flow.packets.front().sentTime + retransmitTimeout(flow);
+        if (deadline > now) {
+            flow.rtoArmed = true;
+            schedule(deadline, EventType::RTO, flowIndex(flow), 0);
+            return;
+        }
+
+        // 超时：所有在途包都视为丢失
+        uint64_t lost = 0;
+        for (size_t i = 0; i < flow.packets.size(); i++) {
+            if (flow.packets[i].state == PacketState::IN_FLIGHT) {
+                lost += flow.packets[i].size;
+                markLost(flow, i);
+            }
+        }
+        flow.recoveryPoint = flow.nextSeq;
+        flow.controller->onLoss({lost, flow.inflight, true, now / NANOS_PER_MICRO});
+        compact(flow);
+        trySend(flow, now);
+    }
+
+    void onTick(int64_t now, int64_t interval, std::vector<Sample>* timeline) {
+        Sample sample{now / NANOS_PER_MICRO, queuedBytes(now), {}, {}};
+        for (Flow& flow : flows_) {
+            // 与 Protocol 使用同一个在线估计器调整分块大小
+            if (flow.config.messageSize > 0) {
+                flow.tuner.update(flow.chunker, now / NANOS_PER_MICRO);
+            }
+
+            if (timeline) {
+                sample.congestionWindow.push_back(flow.controller->getCongestionWindow());
+                sample.throughput.push_back(static_cast<double>(flow.intervalDelivered) * NANOS_PER_SECOND / interval);
+            }
+
+            flow.intervalDelivered = 0;
+        }
+        if (timeline) {
+            timeline->push_back(std::move(sample));
+        }
+    }
+
+    static double percentile(const std::vector<uint64_t>& histogram, uint64_t count, double fraction) {
+        if (count == 0) {
+            return 0;
+        }
+        uint64_t target = static_cast<uint64_t>(count * fraction);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < histogram.size(); i++) {
+            seen += histogram[i];
+            if (seen > target) {
+                return static_cast<double>((i + 1) * DELAY_BUCKET_NANOS) / NANOS_PER_MICRO;
+            }
+        }
+        return static_cast<double>(histogram.size() * DELAY_BUCKET_NANOS) / NANOS_PER_MICRO;
+    }
+
+    void fillReport(Report& report, int64_t now) {
+        report.durationMicros = now / NANOS_PER_MICRO;
+        report.linkUtilization = now > 0 ? static_cast<double>(enqueuedBytes_ - queuedBytes(now)) * NANOS_PER_SECOND /
+                                               (static_cast<double>(link_.bandwidth) * now)
+                                         : 0;
+        report.queueDrops = queueDrops_;
+        report.randomDrops = randomDrops_;
+
+        double sum = 0;
+        double sumSquares = 0;
+        double delaySum = 0;
+        uint64_t delayCount = 0;
+        for (Flow& flow : flows_) {
+            FlowStats stats{};
+            stats.controller = flow.controller->name();
+            double ratio = flow.wireGenerated > 0 ? static_cast<double>(flow.payloadGenerated) / flow.wireGenerated : 1;
+            stats.bytesDelivered = flow.finished ? flow.config.bytes
+                                                 : static_cast<uint64_t>(flow.wireDelivered * ratio);
+            stats.packetsSent = flow.packetsSent;
+            stats.packetsLost = flow.packetsLost;
+            stats.lossRate = flow.packetsSent > 0 ? static_cast<double>(flow.packetsLost) / flow.packetsSent : 0;
+            int64_t activeEnd = flow.finished ? flow.completionTime : now;
+            int64_t active = flow.started ? activeEnd - flow.startTime : 0;
+            stats.throughput = active > 0 ? static_cast<double>(stats.bytesDelivered) * NANOS_PER_SECOND / active : 0;
+            stats.avgQueueDelayMicros = flow.delayCount > 0 ? flow.delaySum / flow.delayCount / NANOS_PER_MICRO : 0;
+            stats.p99QueueDelayMicros = percentile(flow.delayHistogram, flow.delayCount, 0.99);
+            stats.completionMicros = flow.completionTime >= 0 ? flow.completionTime / NANOS_PER_MICRO : -1;
+            stats.chunkSize = flow.config.messageSize > 0 ? flow.chunker.getCurrentOptimalChunkSize() : 0;
+            stats.framingOverhead = 1 - ratio;
+
+            sum += stats.throughput;
+            sumSquares += stats.throughput * stats.throughput;
+            delaySum += flow.delaySum;
+            delayCount += flow.delayCount;
+            report.flows.push_back(std::move(stats));
+        }
+
+        report.fairnessIndex = sumSquares > 0 ? sum * sum / (flows_.size() * sumSquares) : 0;
+        report.avgQueueDelayMicros = delayCount > 0 ? delaySum / delayCount / NANOS_PER_MICRO : 0;
+    }
+};
+
+NetworkSimulator::NetworkSimulator(const LinkConfig& link, uint64_t seed)
+{
+    // 带宽用作串行化时间与排队字节换算的除数；队列按带宽时延积推算时时延也必须为正，否则队列容量为 0
+    if (link.bandwidth == 0) {
+        throw std::invalid_argument("NetworkSimulator: bandwidth must be positive");
+    }
+    if (link.queueBytes == 0 && link.propagationDelayMicros <= 0) {
+        throw std::invalid_argument("NetworkSimulator: queueBytes is required when propagation delay is not positive");
+    }
+    impl.reset(new SimulatorImpl(link, seed));
+}
+
+NetworkSimulator::~NetworkSimulator() = default;
+
+size_t NetworkSimulator::addFlow(const FlowConfig& flow) {
+    return impl->addFlow(flow);
+}
+
+NetworkSimulator::Report NetworkSimulator::run(int64_t durationMicros, int64_t sampleIntervalMicros) {
+    return impl->run(durationMicros, sampleIntervalMicros);
+}
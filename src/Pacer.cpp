@@ -0,0 +1,71 @@
+#include "Pacer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+Pacer::Pacer()
+    : rate(0)
+    , burst(0)
+    , tokens(0)
+    , lastRefill(-1)
+{
+}
+
+void Pacer::setRate(uint64_t bytesPerSecond) {
+    rate = bytesPerSecond;
+}
+
+uint64_t Pacer::getRate() const {
+    return rate;
+}
+
+void Pacer::setBurst(uint64_t bytes) {
+    burst = bytes;
+    tokens = std::min(tokens, static_cast<double>(burst));
+}
+
+uint64_t Pacer::getBurst() const {
+    return burst;
+}
+
+uint64_t Pacer::available(int64_t nowMicros) {
+    if (rate == 0) {
+        return UINT64_MAX;
+    }
+    refill(nowMicros);
+    return tokens > 0 ? static_cast<uint64_t>(tokens) : 0;
+}
+
+void Pacer::consume(uint64_t bytes) {
+    if (rate > 0) {
+        tokens -= static_cast<double>(bytes);
+    }
+}
+
+int64_t Pacer::delayFor(uint64_t bytes, int64_t nowMicros) {
+    if (rate == 0) {
+        return 0;
+    }
+    refill(nowMicros);
+    double needed = static_cast<double>(std::min(bytes, burst)) - tokens;
+    if (needed <= 0) {
+        return 0;
+    }
+    return static_cast<int64_t>(std::ceil(needed * 1e6 / static_cast<double>(rate)));
+}
+
+void Pacer::reset() {
+    tokens = 0;
+    lastRefill = -1;
+}
+
+void Pacer::refill(int64_t nowMicros) {
+    if (lastRefill < 0) {
+        // 第一次使用时给满一个突发量，连接开始时不必等待
+        tokens = static_cast<double>(burst);
+    } else if (nowMicros > lastRefill) {
+        tokens += static_cast<double>(nowMicros - lastRefill) * static_cast<double>(rate) / 1e6;
+        tokens = std::min(tokens, static_cast<double>(burst));
+    }
+    lastRefill = nowMicros;
+}
@@ -1,147 +1,1383 @@
 #include "Protocol.h"
 #include "Utils.h"
 #include "CongestionControl.h"
+#include "RenoController.h"
 #include "LoadBalancer.h"
 #include "TcpChunkOptimization.h"
-#include <winsock2.h>
-#include <ws2tcpip.h>
+#include "SocketBackend.h"
+#include "Framing.h"
+#include "Pacer.h"
+#include "StreamScheduler.h"
+#include "ChunkSizeTuner.h"
+#include "BufferPool.h"
+#include "FifoQueue.h"
+#include "Metrics.h"
+#include "Compression.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
 #include <stdexcept>
+#include <unordered_map>
 #include <vector>
 
-#pragma comment(lib, "ws2_32.lib")
+namespace
+{
+    // 一次 sendmsg 最多拼装的帧数，每帧占用两个缓冲区段（帧头、负载）
+    constexpr size_t MAX_BATCH_FRAMES = TransportSocket::MAX_IOV / 2;
+
+    // 把接收回调转换为 future：连接关闭或出错时 future 抛出异常
+    Protocol::BufferCallback fulfil(std::shared_ptr<std::promise<std::string>> promise)
+    {
+        return [promise](bool ok, Buffer message)
+        {
+            if (ok)
+            {
+                promise->set_value(message.toString());
+            }
+            else
+            {
+                promise->set_exception(std::make_exception_ptr(std::runtime_error("Connection closed")));
+            }
+        };
+    }
+
+    // 以字符串交付消息的回调（交付时拷贝一次）
+    Protocol::BufferCallback deliverString(Protocol::ReceiveCallback callback)
+    {
+        return [callback = std::move(callback)](bool ok, Buffer message)
+        {
+            callback(ok, ok ? message.toString() : std::string());
+        };
+    }
+
+    // 同步接口在调用线程的栈上等待完成；回调只捕获指针，不需要分配 promise 的共享状态。
+    // 在锁内通知，等待方返回（销毁本对象）时回调已经不再访问它
+    struct SyncWait
+    {
+        std::mutex mutex;
+        std::condition_variable cond;
+        bool done = false;
+        bool ok = false;
+        Buffer message;
+
+        void complete(bool result, Buffer received = Buffer())
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ok = result;
+            message = std::move(received);
+            done = true;
+            cond.notify_one();
+        }
+
+        bool wait()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cond.wait(lock, [this]
+                      { return done; });
+            return ok;
+        }
+    };
+
+    // 待发送数据的来源：异步接口交来的字符串或池化缓冲区，或同步调用方的内存（调用方等到写完才返回，不必拷贝）
+    struct SendSource
+    {
+        std::string owned;
+        Buffer buffer;
+        const uint8_t *borrowed = nullptr;
+        size_t length = 0;
+        Buffer packed;  // 启用压缩且至少有一个分块被压缩时的分块表和压缩负载，见 OutgoingMessage
+
+        static SendSource of(std::string data)
+        {
+            SendSource source;
+            source.length = data.size();
+            source.owned = std::move(data);
+            return source;
+        }
+
+        static SendSource of(Buffer data)
+        {
+            SendSource source;
+            source.length = data.size();
+            source.buffer = std::move(data);
+            return source;
+        }
+
+        static SendSource borrow(const uint8_t *data, size_t length)
+        {
+            SendSource source;
+            source.borrowed = data;
+            source.length = length;
+            return source;
+        }
+
+        // 短字符串的内容存放在对象内部，随对象移动，因此每次现取地址
+        const uint8_t *bytes() const
+        {
+            if (borrowed)
+            {
+                return borrowed;
+            }
+            if (buffer)
+            {
+                return buffer.data();
+            }
+            return reinterpret_cast<const uint8_t *>(owned.data());
+        }
+    };
+
+    // 一条待发送的消息：每个分块是一帧，帧头在分块第一次进入批次时生成
+    // 分块按固定大小依次切分，只记录发送进度，可以跨多次 sendmsg 续发；
+    // 批次按帧拼装，不同流的帧可以交错进同一次 sendmsg
+    // packed 非空时是压缩阶段的输出：开头是每个分块一项的 {偏移, 长度}，长度为 0 的分块原样发送，
+    // 其余分块发送 packed 中对应偏移处的压缩负载。池化缓冲区的内容不随句柄移动，指针可以一直保存
+    class OutgoingMessage
+    {
+    public:
+        static constexpr size_t PACKED_ENTRY_SIZE = 2 * sizeof(uint32_t);
+
+        OutgoingMessage() : OutgoingMessage(0, 1, 0) {}
+
+        OutgoingMessage(size_t size, size_t chunkSize, uint16_t streamId, const uint8_t *packed = nullptr)
+            : size(size), chunkSize(std::max<size_t>(chunkSize, 1)), streamId(streamId), packed(packed),
+              headersEncoded(0), nextChunk(0), frameOffset(0), batchChunk(0)
+        {
+            // 空消息也要发送一帧，接收方才能看到消息边界
+            chunkCount = chunkCountFor(size, this->chunkSize);
+            remainingBytes = chunkCount * FrameHeader::SIZE;
+            for (size_t i = 0; i < chunkCount; i++)
+            {
+                remainingBytes += chunkLength(i);
+            }
+        }
+
+        static size_t chunkCountFor(size_t size, size_t chunkSize)
+        {
+            return std::max<size_t>((size + chunkSize - 1) / chunkSize, 1);
+        }
+
+        // 所有帧都已写出
+        bool done() const
+        {
+            return nextChunk == chunkCount;
+        }
+
+        // 剩下的帧都已放进当前批次
+        bool batched() const
+        {
+            return batchChunk == chunkCount;
+        }
+
+        // 上一次写出停在帧中间：下一批次必须先续完这一帧，不同流的帧只能在帧边界交错
+        bool midFrame() const
+        {
+            return frameOffset > 0;
+        }
+
+        uint64_t remaining() const
+        {
+            return remainingBytes;
+        }
+
+        size_t chunks() const
+        {
+            return chunkCount;
+        }
+
+        // 把下一帧（或其剩余部分）追加到批次，最多 budget 字节，占用两个缓冲区段；返回追加的字节数
+        size_t appendFrame(const uint8_t *base, TransportSocket::IoVec *vecs, size_t &count, size_t budget)
+        {
+            size_t i = batchChunk;
+            const uint8_t *payload = chunkPayload(base, i);
+            size_t length = chunkLength(i);
+            uint8_t *header = headers[i % MAX_BATCH_FRAMES].data();
+            if (i == headersEncoded)
+            {
+                uint16_t flags = (i + 1 == chunkCount) ? FrameHeader::FLAG_END_OF_MESSAGE : 0;
+                if (compressedLength(i) > 0)
+                {
+                    flags |= FrameHeader::FLAG_COMPRESSED;
+                }
+                FrameHeader::forPayload(payload, length, flags, streamId).encode(header);
+                headersEncoded++;
+            }
+
+            size_t skip = (i == nextChunk) ? frameOffset : 0;
+            size_t frameLeft = FrameHeader::SIZE + length - skip;
+            size_t appended = 0;
+            if (skip < FrameHeader::SIZE)
+            {
+                size_t headerLength = std::min(FrameHeader::SIZE - skip, budget);
+                vecs[count++] = {header + skip, headerLength};
+                appended += headerLength;
+                skip = FrameHeader::SIZE;
+            }
+
+            size_t payloadSkip = skip - FrameHeader::SIZE;
+            size_t payloadLength = std::min(length - payloadSkip, budget - appended);
+            if (payloadLength > 0)
+            {
+                vecs[count++] = {const_cast<uint8_t *>(payload + payloadSkip), payloadLength};
+                appended += payloadLength;
+            }
+
+            if (appended == frameLeft)
+            {
+                batchChunk++;
+            }
+            return appended;
+        }
+
+        // 按实际写出的字节数推进帧游标（可能只写出了部分批次），返回其中属于本消息的字节数
+        size_t advance(size_t sent)
+        {
+            size_t consumed = 0;
+            while (consumed < sent && nextChunk < chunkCount)
+            {
+                size_t left = FrameHeader::SIZE + chunkLength(nextChunk) - frameOffset;
+                if (sent - consumed < left)
+                {
+                    frameOffset += sent - consumed;
+                    consumed = sent;
+                    break;
+                }
+                consumed += left;
+                nextChunk++;
+                frameOffset = 0;
+            }
+            remainingBytes -= consumed;
+            return consumed;
+        }
+
+        // 批次提交后，没写出的帧回到待发送状态
+        void rewind()
+        {
+            batchChunk = nextChunk;
+        }
+
+    private:
+        size_t size;
+        size_t chunkSize;
+        size_t chunkCount;
+        uint16_t streamId;
+        const uint8_t *packed;
+        // 已生成的帧头按分块序号轮流存放：一个批次最多 MAX_BATCH_FRAMES 帧，且都从 nextChunk 起连续，
+        // 批次中用到的帧头不会被后面的分块覆盖
+        std::array<std::array<uint8_t, FrameHeader::SIZE>, MAX_BATCH_FRAMES> headers;
+        size_t headersEncoded;
+        size_t nextChunk;   // 第一个尚未写完的帧
+        size_t frameOffset; // 该帧（帧头+负载）中已写出的字节数
+        size_t batchChunk;  // 当前批次中下一个要追加的帧
+        uint64_t remainingBytes;
+
+        // 分块的压缩负载长度，0 表示原样发送
+        size_t compressedLength(size_t i) const
+        {
+            if (!packed)
+            {
+                return 0;
+            }
+            uint32_t length;
+            std::memcpy(&length, packed + i * PACKED_ENTRY_SIZE + sizeof(uint32_t), sizeof(length));
+            return length;
+        }
+
+        // 帧负载（压缩后）的起始位置与长度
+        const uint8_t *chunkPayload(const uint8_t *base, size_t i) const
+        {
+            if (compressedLength(i) > 0)
+            {
+                uint32_t offset;
+                std::memcpy(&offset, packed + i * PACKED_ENTRY_SIZE, sizeof(offset));
+                return packed + offset;
+            }
+            return base + i * chunkSize;
+        }
+
+        size_t chunkLength(size_t i) const
+        {
+            size_t compressed = compressedLength(i);
+            return compressed > 0 ? compressed : std::min(chunkSize, size - i * chunkSize);
+        }
+    };
+}
+
+class Protocol::ProtocolImpl
+{
+public:
+    explicit ProtocolImpl(std::shared_ptr<SocketBackend> backend)
+        : backend_(backend ? std::move(backend) : SocketBackend::getDefault()), isConnected_(false),
+          congestionController_(CongestionController::create(CongestionController::Type::RENO)),
+          pathInfoSupported_(false), transportControlsCongestion_(false), lastPathSample_(0), lastBytesAcked_(0), lastRetransmits_(0),
+          smoothedRttMicros_(0), bufferPool_(BufferPool::create()), frameDecoder_(64 * 1024, bufferPool_),
+          compressionEnabled_(false),
+          async_(std::make_shared<AsyncState>()), readyCallbackSupported_(false), counters_(), windowHistory_(),
+          windowSamples_(0)
+    {
+        async_->owner = this;
+    }
+
+    ~ProtocolImpl()
+    {
+        {
+            std::lock_guard<std::mutex> lock(async_->mutex);
+            async_->owner = nullptr;
+            // 销毁不算连接失效，不再通知
+            async_->onClosed = nullptr;
+        }
+        closeConnection();
+    }
+
+    bool initializeConnection(const std::string &host, uint16_t port, int timeoutMs)
+    {
+        closeConnection();
+
+        socket_ = backend_->createSocket();
+        if (!socket_->connect(host, port, timeoutMs))
+        {
+            socket_.reset();
+            return false;
+        }
+        attachSocket();
+        return true;
+    }
+
+    // 接管已经建立的连接（服务端接受的连接）
+    void adoptConnection(std::unique_ptr<TransportSocket> socket)
+    {
+        closeConnection();
+        socket_ = std::move(socket);
+        attachSocket();
+    }
+
+    bool isConnected() const
+    {
+        return isConnected_ && socket_ && socket_->isOpen() && !socket_->isPeerClosed();
+    }
+
+    // 事件循环线程在 async_->mutex 下使用控制器，修改和替换都要持有同一把锁
+    void setCongestionControlAlgorithm(CongestionControl::Algorithm algo)
+    {
+        std::lock_guard<std::mutex> lock(async_->mutex);
+        if (auto *reno = dynamic_cast<RenoController *>(congestionController_.get()))
+        {
+            reno->setAlgorithm(algo);
+        }
+    }
+
+    void setCongestionController(std::unique_ptr<CongestionController> controller)
+    {
+        if (!controller)
+        {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(async_->mutex);
+            congestionController_.swap(controller);
+        }
+        // 旧控制器在解锁后销毁
+    }
+
+    void setStreamPriority(uint16_t streamId, uint8_t priority, uint16_t weight)
+    {
+        std::lock_guard<std::mutex> lock(async_->mutex);
+        async_->scheduler.setPriority(streamId, priority, weight);
+    }
+
+    // 同步发送也进入按流调度的发送队列，大消息不会挡住其他线程在别的流上发送的小消息；
+    // 调用方一直等到发送完成，数据不必拷贝进队列
+    bool sendData(const uint8_t *data, size_t length, uint16_t streamId)
+    {
+        SyncWait wait;
+        submit(streamId, SendSource::borrow(data, length), [&wait](bool ok)
+               { wait.complete(ok); },
+               nullptr);
+        return wait.wait();
+    }
+
+    bool receiveBuffer(Buffer &message, uint16_t streamId)
+    {
+        SyncWait wait;
+        submit(streamId, SendSource(), nullptr, [&wait](bool ok, Buffer received)
+               { wait.complete(ok, std::move(received)); });
+        bool ok = wait.wait();
+        message = std::move(wait.message);
+        return ok;
+    }
+
+    std::shared_ptr<BufferPool> bufferPool() const
+    {
+        return bufferPool_;
+    }
+
+    Metrics::ConnectionSnapshot metrics() const
+    {
+        Metrics::ConnectionSnapshot snapshot;
+        std::lock_guard<std::mutex> lock(async_->mutex);
+        snapshot.counters = counters_;
+        snapshot.congestionWindow = congestionController_->getCongestionWindow();
+        snapshot.slowStartThreshold = congestionController_->getSlowStartThreshold();
+        snapshot.pacingRate = pacer_.getRate();
+        snapshot.smoothedRttMicros = smoothedRttMicros_;
+        snapshot.queuedBytes = async_->queuedBytes;
+        snapshot.chunkSize = tcpChunkOptimizer_.getCurrentOptimalChunkSize();
+        size_t kept = std::min(windowSamples_, WINDOW_HISTORY);
+        snapshot.windowHistory.reserve(kept);
+        for (size_t i = windowSamples_ - kept; i < windowSamples_; i++)
+        {
+            snapshot.windowHistory.push_back(windowHistory_[i % WINDOW_HISTORY]);
+        }
+        return snapshot;
+    }
+
+    // 发送与接收都经过这里：入队后立即尝试推进，剩下的由套接字的就绪回调或节拍定时器在事件循环中继续
+    // onSent 为空表示只接收，onReceived 为空表示只发送；两者都有时请求与响应在同一次加锁中入队，
+    // 多个线程并发提交时同一流上响应的顺序也与请求一致
+    void submit(uint16_t streamId, SendSource source, Protocol::SendCallback onSent,
+                Protocol::BufferCallback onReceived)
+    {
+        Completions done = takeCompletions();
+        std::shared_ptr<std::atomic<int>> outstanding;
+        // 压缩在加锁之前进行，多 MB 的消息压缩期间其他线程的提交和事件循环的推进不受影响
+        PackedMessage packed;
+        if (onSent && compressionEnabled_.load(std::memory_order_relaxed))
+        {
+            packed = compressChunks(source.bytes(), source.length);
+        }
+        {
+            std::unique_lock<std::mutex> lock(async_->mutex);
+            if (!isConnected_)
+            {
+                if (onSent)
+                {
+                    done.push_back({std::move(onSent), nullptr, false, Buffer()});
+                }
+                if (onReceived)
+                {
+                    done.push_back({nullptr, std::move(onReceived), false, Buffer()});
+                }
+            }
+            else
+            {
+                int64_t now = nowMicros();
+                bool request = onSent && onReceived;
+                if (!readyCallbackSupported_)
+                {
+                    // 没有人会在事件循环中继续推进，本次调用推进到自己提交的操作完成为止
+                    outstanding = std::make_shared<std::atomic<int>>(0);
+                    trackCompletion(outstanding, onSent);
+                    trackCompletion(outstanding, onReceived);
+                }
+                if (onSent)
+                {
+                    // 压缩过的消息沿用压缩时的分块大小，分块表与之对应
+                    size_t chunkSize = tcpChunkOptimizer_.getCurrentOptimalChunkSize();
+                    if (packed.data)
+                    {
+                        chunkSize = packed.chunkSize;
+                        source.packed = std::move(packed.data);
+                        addMetric(Metrics::Counter::FRAMES_COMPRESSED, packed.compressedFrames);
+                        addMetric(Metrics::Counter::COMPRESSION_SAVED_BYTES, packed.savedBytes);
+                    }
+                    OutgoingMessage message(source.length, chunkSize, streamId,
+                                            source.packed ? source.packed.data() : nullptr);
+                    async_->queuedBytes += message.remaining();
+                    FifoQueue<AsyncSend> &queue = async_->sends[streamId];
+                    if (queue.empty())
+                    {
+                        async_->scheduler.activate(streamId);
+                    }
+                    bool borrowed = source.borrowed != nullptr;
+                    queue.push_back({std::move(source), message, std::move(onSent), now});
+                    if (borrowed)
+                    {
+                        // 同步发送的调用方在等待写出，合并只会增加它的延迟
+                        async_->flushMicros = now;
+                    }
+                }
+                if (onReceived)
+                {
+                    async_->receives[streamId].push_back({std::move(onReceived), now, request});
+                    async_->pendingReceives++;
+                }
+                pumpUntilComplete(lock, done, outstanding.get());
+            }
+        }
+        runCompletions(done);
+    }
+
+    void flush()
+    {
+        Completions done = takeCompletions();
+        {
+            std::lock_guard<std::mutex> lock(async_->mutex);
+            if (isConnected_)
+            {
+                async_->flushMicros = nowMicros();
+                pumpAsync(done);
+            }
+        }
+        runCompletions(done);
+    }
+
+    void setCoalescingDelay(uint32_t delayMicros)
+    {
+        std::lock_guard<std::mutex> lock(async_->mutex);
+        tcpChunkOptimizer_.setCoalescingDelay(delayMicros);
+    }
+
+    void setCompression(bool enabled, const ChunkCompressor::Config &config)
+    {
+        std::lock_guard<std::mutex> lock(compressionMutex_);
+        compressionEnabled_ = enabled;
+        compressor_.setConfig(config);
+    }
+
+    void setCloseCallback(std::function<void()> callback)
+    {
+        std::lock_guard<std::mutex> lock(async_->mutex);
+        async_->onClosed = std::move(callback);
+    }
+
+    void closeConnection()
+    {
+        Completions done = takeCompletions();
+        {
+            std::lock_guard<std::mutex> lock(async_->mutex);
+            failAsync(done);
+            if (socket_)
+            {
+                socket_->close();
+                socket_.reset();
+                notifyClosed(done);
+            }
+            if (isConnected_)
+            {
+                addMetric(Metrics::Counter::CONNECTIONS_CLOSED);
+            }
+            isConnected_ = false;
+            frameDecoder_.reset();
+        }
+        runCompletions(done);
+    }
+
+private:
+    // 解锁之后要执行的回调：发送完成或交付一条消息
+    struct Completion
+    {
+        Protocol::SendCallback send;
+        Protocol::BufferCallback receive;
+        bool ok;
+        Buffer message;
+    };
+    using Completions = std::vector<Completion>;
+
+    struct AsyncSend
+    {
+        SendSource source;
+        OutgoingMessage message;
+        Protocol::SendCallback callback;
+        int64_t queuedMicros = 0;
+    };
+
+    struct AsyncReceive
+    {
+        Protocol::BufferCallback callback;
+        int64_t queuedMicros = 0;
+        bool request = false;          // requestAsync 的响应，交付时计入往返延迟
+    };
+
+    // 在锁外压缩好的消息：分块表、压缩时使用的分块大小以及要计入的指标
+    struct PackedMessage
+    {
+        Buffer data;
+        size_t chunkSize = 0;
+        uint64_t compressedFrames = 0;
+        uint64_t savedBytes = 0;
+    };
+
+    // 后端没有就绪回调时只能在调用线程中推进，推进途中需要的等待记录下来，由调用方释放锁后进行
+    struct BlockingWait
+    {
+        enum class Kind
+        {
+            NONE,
+            SLEEP,     // 等待节拍令牌
+            WRITABLE,
+            READABLE
+        };
+        Kind kind = Kind::NONE;
+        int64_t micros = 0;
+    };
+
+    // 连接的发送/接收队列；套接字的就绪回调和节拍定时器通过 weak_ptr 持有，连接销毁后自然失效
+    // 流的队列在连接存续期间保留（清空而不删除），稳定状态下入队出队不分配内存
+    struct AsyncState
+    {
+        std::mutex mutex;
+        ProtocolImpl *owner = nullptr;
+        std::unordered_map<uint16_t, FifoQueue<AsyncSend>> sends;
+        StreamScheduler scheduler;
+        uint64_t queuedBytes = 0;      // 所有流中尚未写出的字节数（含帧头）
+        bool hasPartialFrame = false;  // 上一次写出停在 partialStream 的某一帧中间
+        uint16_t partialStream = 0;
+        std::unordered_map<uint16_t, FifoQueue<AsyncReceive>> receives;
+        size_t pendingReceives = 0;
+        bool wakeupPending = false;    // 定时器或让出后的继续推进已经安排
+        int64_t flushMicros = -1;      // 此前入队的消息不再等待合并（flush 或同步发送）
+        std::function<void()> onClosed;
+        bool closeNotified = false;    // 本次连接的 onClosed 已经安排
+        BlockingWait blocking;         // 最近一次推进停下来时需要的等待
+    };
+
+    // 一次 sendmsg 的内容，按顺序记录每一段属于哪个流的哪条消息
+    struct Batch
+    {
+        struct Entry
+        {
+            uint16_t streamId;
+            AsyncSend *send;
+            size_t bytes;
+        };
+        static constexpr size_t MAX_ENTRIES = MAX_BATCH_FRAMES;
+
+        TransportSocket::IoVec vecs[TransportSocket::MAX_IOV];
+        size_t count = 0;
+        Entry entries[MAX_ENTRIES];
+        size_t entryCount = 0;
+        uint16_t parked[MAX_ENTRIES]; // 数据已全部放进批次、暂时退出调度的流
+        size_t parkedCount = 0;
+        size_t bytes = 0;
+    };
+
+    // 路径统计的最小采样间隔，避免每次发送都多一次系统调用
+    static constexpr int64_t PATH_SAMPLE_INTERVAL_MICROS = 1000;
+
+    // 控制器不给出速率时按 窗口/平滑RTT 乘以增益限速，增益大于1使窗口仍是主要约束
+    static constexpr double PACING_GAIN = 1.25;
+    // 一次连续发送的上限：速率下该时长的数据量，且不少于若干个报文段
+    static constexpr int64_t PACING_BURST_MICROS = 250;
+    static constexpr uint64_t MIN_PACING_BURST = 4 * CongestionController::DEFAULT_MSS;
+
+    // 一次推进最多写出/读入的字节数，用完后剩下的工作交给事件循环继续；
+    // 锁因此会定期释放，其他线程在别的流上提交的小消息不会被一个大消息长时间挡在外面
+    static constexpr size_t MAX_PUMP_BYTES = 256 * 1024;
+
+    // 调用线程中等待套接字就绪的单次超时，到期后重新加锁推进，也借此发现等待期间被关闭的连接
+    static constexpr int BLOCKING_WAIT_MILLIS = 10;
+
+    // 事件循环线程中的入口：套接字出现新的就绪边缘，或定时器到期
+    static void onAsyncEvent(const std::weak_ptr<AsyncState> &weakAsync, bool timerFired)
+    {
+        auto async = weakAsync.lock();
+        if (!async)
+        {
+            return;
+        }
+        Completions done = takeCompletions();
+        {
+            std::lock_guard<std::mutex> lock(async->mutex);
+            if (timerFired)
+            {
+                async->wakeupPending = false;
+            }
+            if (async->owner && async->owner->isConnected_)
+            {
+                async->owner->pumpAsync(done);
+            }
+        }
+        runCompletions(done);
+    }
+
+    // 每个线程留一个回调列表反复使用；回调中再提交操作时嵌套的那一层另外分配
+    static Completions &spareCompletions()
+    {
+        static thread_local Completions spare;
+        return spare;
+    }
+
+    static Completions takeCompletions()
+    {
+        Completions done;
+        done.swap(spareCompletions());
+        return done;
+    }
+
+    // 回调在解锁之后执行，回调中可以继续提交异步操作
+    static void runCompletions(Completions &done)
+    {
+        for (auto &completion : done)
+        {
+            if (completion.send)
+            {
+                completion.send(completion.ok);
+            }
+            else
+            {
+                completion.receive(completion.ok, std::move(completion.message));
+            }
+        }
+        done.clear();
+        Completions &spare = spareCompletions();
+        if (spare.capacity() < done.capacity())
+        {
+            spare.swap(done);
+        }
+    }
+
+    // 推进排队的发送与接收（需持有 async_->mutex），完成的回调放入 done
+    void pumpAsync(Completions &done)
+    {
+        async_->blocking = BlockingWait();
+        size_t budget = MAX_PUMP_BYTES;
+        if (!pumpAsyncSends(done, budget) || !pumpAsyncReceives(done, budget))
+        {
+            // 连接已不可用，之后的操作直接失败
+            addMetric(Metrics::Counter::CONNECTIONS_CLOSED);
+            isConnected_ = false;
+            async_->blocking = BlockingWait();
+            failAsync(done);
+            notifyClosed(done);
+        }
+    }
+
+    // 推进到 outstanding 归零（需持有 lock，即 async_->mutex）。有就绪回调的后端推进从不等待，推进一次即返回；
+    // 否则在调用线程中等待套接字或节拍令牌，等待期间释放锁，其他线程仍可提交和推进，已完成的回调先行执行。
+    // 等待期间连接可能被关闭或销毁，重新加锁后先确认 owner 与套接字都没有变化
+    void pumpUntilComplete(std::unique_lock<std::mutex> &lock, Completions &done, const std::atomic<int> *outstanding)
+    {
+        std::shared_ptr<AsyncState> async = async_;
+        pumpAsync(done);
+        while (outstanding && async->blocking.kind != BlockingWait::Kind::NONE)
+        {
+            BlockingWait wait = async->blocking;
+            std::shared_ptr<TransportSocket> socket = socket_;
+            lock.unlock();
+            runCompletions(done);
+            if (outstanding->load() == 0)
+            {
+                // 自己的操作已经完成（可能由其他线程推进完成），剩下的等待留给各自的提交者
+                lock.lock();
+                return;
+            }
+            switch (wait.kind)
+            {
+            case BlockingWait::Kind::SLEEP:
+                std::this_thread::sleep_for(std::chrono::microseconds(wait.micros));
+                break;
+            case BlockingWait::Kind::WRITABLE:
+                socket->waitWritable(BLOCKING_WAIT_MILLIS);
+                break;
+            case BlockingWait::Kind::READABLE:
+                socket->waitReadable(BLOCKING_WAIT_MILLIS);
+                break;
+            case BlockingWait::Kind::NONE:
+                break;
+            }
+            lock.lock();
+            if (async->owner != this || !isConnected_ || socket_ != socket)
+            {
+                return;
+            }
+            pumpAsync(done);
+        }
+    }
 
-class Protocol::ProtocolImpl
-{
-public:
-    ProtocolImpl()
-        : socket_(INVALID_SOCKET), isConnected_(false)
+    // 回调执行时把 outstanding 减一，用于判断提交的操作是否已经完成
+    template <typename Callback>
+    static void trackCompletion(const std::shared_ptr<std::atomic<int>> &outstanding, Callback &callback)
     {
-        WSADATA wsaData;
-        if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+        if (!callback)
         {
-            throw std::runtime_error("WSAStartup failed");
+            return;
         }
+        outstanding->fetch_add(1);
+        callback = [outstanding, inner = std::move(callback)](auto &&...args)
+        {
+            inner(std::forward<decltype(args)>(args)...);
+            outstanding->fetch_sub(1);
+        };
     }
 
-    ~ProtocolImpl()
+    // 连接变为不可用，安排一次 onClosed（需持有 async_->mutex），与其他回调一样在解锁后执行
+    void notifyClosed(Completions &done)
     {
-        closeConnection();
-        WSACleanup();
+        if (async_->closeNotified || !async_->onClosed)
+        {
+            return;
+        }
+        async_->closeNotified = true;
+        std::function<void()> onClosed = async_->onClosed;
+        done.push_back({[onClosed](bool)
+                        { onClosed(); },
+                        nullptr, true, Buffer()});
+    }
+
+    // 新的套接字已连接：重置路径状态并注册就绪回调
+    void attachSocket()
+    {
+        resetPathState();
+        std::weak_ptr<AsyncState> weakAsync = async_;
+        readyCallbackSupported_ = socket_->setReadyCallback([weakAsync]
+                                                            { onAsyncEvent(weakAsync, false); });
+
+        std::lock_guard<std::mutex> lock(async_->mutex);
+        isConnected_ = true;
+        async_->closeNotified = false;
+        counters_.fill(0);
+        windowSamples_ = 0;
+        addMetric(Metrics::Counter::CONNECTIONS_OPENED);
+        sampleWindow(nowMicros());
     }
 
-    bool initializeConnection(const std::string &host, uint16_t port)
+    // 压缩阶段：按发送时的分块大小切分并逐块压缩，输出见 OutgoingMessage；
+    // 没有一个分块值得压缩时返回空结果，消息照常直接从来源发送。
+    // 在 async_->mutex 之外调用，压缩器由 compressionMutex_ 保护；分块大小在这里取一次，随结果带回
+    PackedMessage compressChunks(const uint8_t *data, size_t length)
     {
-        socket_ = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-        if (socket_ == INVALID_SOCKET)
+        std::lock_guard<std::mutex> compressionLock(compressionMutex_);
+        if (!compressionEnabled_ || length < compressor_.getConfig().minChunkSize)
         {
-            return false;
+            return PackedMessage();
+        }
+        size_t chunkSize;
+        {
+            std::lock_guard<std::mutex> lock(async_->mutex);
+            chunkSize = tcpChunkOptimizer_.getCurrentOptimalChunkSize();
+        }
+
+        size_t chunkCount = OutgoingMessage::chunkCountFor(length, chunkSize);
+        size_t tableSize = chunkCount * OutgoingMessage::PACKED_ENTRY_SIZE;
+        // 每个被采用的压缩负载都比原分块小，分块表加原消息长度一定放得下
+        Buffer packed = bufferPool_->acquire(tableSize + length);
+        uint8_t *out = packed.data();
+        size_t used = tableSize;
+        uint64_t compressedFrames = 0;
+        uint64_t saved = 0;
+        for (size_t i = 0; i < chunkCount; i++)
+        {
+            size_t offset = i * chunkSize;
+            size_t chunkLength = std::min(chunkSize, length - offset);
+            uint32_t entry[2] = {static_cast<uint32_t>(used), 0};
+            size_t written = compressor_.compress(data + offset, chunkLength, out + used,
+                                                  ChunkCompressor::outputCapacity(chunkLength));
+            if (written > 0)
+            {
+                entry[1] = static_cast<uint32_t>(written);
+                used += written;
+                compressedFrames++;
+                saved += chunkLength - written;
+            }
+            std::memcpy(out + i * OutgoingMessage::PACKED_ENTRY_SIZE, entry, sizeof(entry));
+        }
+        if (compressedFrames == 0)
+        {
+            return PackedMessage();
         }
+        packed.resize(used);
+        return {std::move(packed), chunkSize, compressedFrames, saved};
+    }
+
+    // 计入本连接和当前线程的指标分片（需持有 async_->mutex）
 
-        sockaddr_in serverAddr;
-        serverAddr.sin_family = AF_INET;
-        serverAddr.sin_port = htons(port);
-        inet_pton(AF_INET, host.c_str(), &(serverAddr.sin_addr));
+    void addMetric(Metrics::Counter counter, uint64_t value = 1)
+    {
+        counters_[static_cast<size_t>(counter)] += value;
+        Metrics::add(counter, value);
+    }
 
-        if (connect(socket_, (sockaddr *)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR)
+    // 拥塞窗口或慢启动阈值变化时在轨迹上记一个点（需持有 async_->mutex）
+    void sampleWindow(int64_t now)
+    {
+        uint64_t window = congestionController_->getCongestionWindow();
+        uint64_t threshold = congestionController_->getSlowStartThreshold();
+        if (windowSamples_ > 0)
         {
-            closesocket(socket_);
-            socket_ = INVALID_SOCKET;
-            return false;
+            const Metrics::WindowSample &last = windowHistory_[(windowSamples_ - 1) % WINDOW_HISTORY];
+            if (last.congestionWindow == window && last.slowStartThreshold == threshold)
+            {
+                return;
+            }
         }
+        windowHistory_[windowSamples_++ % WINDOW_HISTORY] = {now, window, threshold};
+    }
 
-        isConnected_ = true;
+    // 安排事件循环在 delayMicros 后继续推进，已经安排过时不重复安排；返回 false 表示后端没有定时器
+    bool scheduleWakeup(int64_t delayMicros)
+    {
+        if (async_->wakeupPending)
+        {
+            return true;
+        }
+        std::weak_ptr<AsyncState> weakAsync = async_;
+        if (!backend_->runAfter(delayMicros, [weakAsync]
+                                { onAsyncEvent(weakAsync, true); }))
+        {
+            return false;
+        }
+        async_->wakeupPending = true;
         return true;
     }
 
-    void setCongestionControlAlgorithm(CongestionControl::Algorithm algo)
+    // 发送要等待节拍令牌或合并期限：安排定时器，新安排的等待计入指标
+    bool waitFor(int64_t delayMicros)
     {
-        congestionControl_.setAlgorithm(algo);
+        bool scheduled = async_->wakeupPending;
+        if (!scheduleWakeup(delayMicros))
+        {
+            return false;
+        }
+        if (!scheduled)
+        {
+            addMetric(Metrics::Counter::PACING_WAITS);
+        }
+        return true;
     }
 
-    bool sendData(const std::string &data)
+    // 本次推进的额度已用完：交给事件循环继续推进，返回 false 表示后端做不到，只能在当前线程继续
+    bool deferToLoop()
     {
-        if (!isConnected_)
-            return false;
+        return readyCallbackSupported_ && scheduleWakeup(0);
+    }
 
-        std::vector<uint8_t> dataBytes(data.begin(), data.end());
-        auto chunks = tcpChunkOptimizer_.chunkData(dataBytes);
-        uint32_t windowSize = congestionControl_.getCurrentWindow();
+    // 小消息合并还要等待的微秒数，0 表示立即写出。以所有流中最早入队、尚未写完的消息为准；
+    // 在 flushMicros 之前入队的消息不再等待
+    int64_t coalescingWait(int64_t now) const
+    {
+        int64_t delay = tcpChunkOptimizer_.getCoalescingDelay();
+        if (delay == 0)
+        {
+            return 0;
+        }
+        int64_t oldest = now;
+        for (const auto &entry : async_->sends)
+        {
+            if (!entry.second.empty())
+            {
+                oldest = std::min(oldest, entry.second.front().queuedMicros);
+            }
+        }
+        if (oldest <= async_->flushMicros || tcpChunkOptimizer_.shouldFlush(async_->queuedBytes, now - oldest))
+        {
+            return 0;
+        }
+        return delay - (now - oldest);
+    }
 
-        for (const auto &chunk : chunks)
+    // 受拥塞窗口和发送节拍约束，但从不阻塞：发送缓冲区满时等待可写边缘，令牌不足时交给共享时间轮。
+    // 每一帧由调度器按流的优先级和权重选出，多个流的帧拼进同一次 sendmsg。出错时返回 false
+    bool pumpAsyncSends(Completions &done, size_t &budget)
+    {
+        AsyncState &async = *async_;
+        while (!async.scheduler.empty())
         {
-            size_t totalSent = 0;
-            while (totalSent < chunk.size())
+            if (budget == 0 && deferToLoop())
+            {
+                return true;
+            }
+
+            // 小消息凑不满一个分块时先攒着，到期或凑满后一次写出；后端没有定时器时不合并
+            int64_t now = nowMicros();
+            int64_t wait = coalescingWait(now);
+            if (wait > 0 && waitFor(wait))
+            {
+                return true;
+            }
+
+            Batch batch;
+            if (transportControlsCongestion_)
+            {
+                // 传输层的发送缓冲区写满时返回 WOULD_BLOCK，窗口与节拍都由它负责
+                fillBatch(batch, MAX_PUMP_BYTES);
+            }
+            else
             {
-                int sent = send(socket_,
-                                (char *)&chunk[totalSent],
-                                (windowSize < (uint32_t)(chunk.size() - totalSent) ? windowSize : (uint32_t)(chunk.size() - totalSent)),
-                                0);
+                uint64_t window = congestionController_->getCongestionWindow();
 
-                if (sent == SOCKET_ERROR)
+                // 攒够半个突发量就发送，定时器的唤醒延迟期间继续累积的令牌不会因达到上限而浪费
+                updatePacing(window);
+                int64_t delay = pacer_.delayFor(std::min<uint64_t>(async.queuedBytes, pacer_.getBurst() / 2), now);
+                size_t windowSize = static_cast<size_t>(std::min(window, pacer_.available(now)));
+                if (delay > 0)
                 {
-                    congestionControl_.updateWindow(false, true);
-                    return false;
+                    if (waitFor(delay))
+                    {
+                        return true;
+                    }
+                    if (!readyCallbackSupported_)
+                    {
+                        // 后端既没有定时器也没有就绪回调时本来就在调用线程中推进，解锁后由调用方等待
+                        async.blocking = {BlockingWait::Kind::SLEEP, delay};
+                        return true;
+                    }
+                    windowSize = static_cast<size_t>(window);
                 }
 
-                totalSent += sent;
-                congestionControl_.updateWindow(true, false);
+                fillBatch(batch, windowSize);
+            }
+            auto result = socket_->sendv(batch.vecs, batch.count);
+            addMetric(Metrics::Counter::SEND_CALLS);
+            commitBatch(batch, result.status == TransportSocket::IoStatus::OK ? result.bytes : 0, now, done);
+
+            if (result.status == TransportSocket::IoStatus::WOULD_BLOCK)
+            {
+                addMetric(Metrics::Counter::SEND_BLOCKED);
+                chunkSizeTuner_.onBlocked(now);
+                if (!readyCallbackSupported_)
+                {
+                    async.blocking = {BlockingWait::Kind::WRITABLE, 0};
+                }
+                return true;
+            }
+            if (result.status != TransportSocket::IoStatus::OK)
+            {
+                congestionController_->onLoss({0, 0, true, nowMicros()});
+                return false;
             }
-        }
 
+            addMetric(Metrics::Counter::BYTES_SENT, result.bytes);
+            pacer_.consume(result.bytes);
+            async.queuedBytes -= result.bytes;
+            budget -= std::min(budget, result.bytes);
+            reportSent(result.bytes);
+        }
         return true;
     }
 
-    std::string receiveData()
+    // 按调度器的选择逐帧拼装批次，上一次停在帧中间的流先续完那一帧
+    void fillBatch(Batch &batch, size_t budget)
     {
-        if (!isConnected_)
-            return "";
+        AsyncState &async = *async_;
+        while (batch.bytes < budget && batch.entryCount < Batch::MAX_ENTRIES)
+        {
+            uint16_t streamId;
+            if (batch.entryCount == 0 && async.hasPartialFrame)
+            {
+                streamId = async.partialStream;
+            }
+            else if (!async.scheduler.next(streamId))
+            {
+                break;
+            }
+
+            FifoQueue<AsyncSend> &queue = async.sends.find(streamId)->second;
+            size_t index = 0;
+            while (queue[index].message.batched())
+            {
+                index++;
+            }
+            AsyncSend &send = queue[index];
+            size_t bytes = send.message.appendFrame(send.source.bytes(), batch.vecs, batch.count,
+                                                    budget - batch.bytes);
+            async.scheduler.charge(streamId, bytes);
+            batch.entries[batch.entryCount++] = {streamId, &send, bytes};
+            batch.bytes += bytes;
 
-        std::vector<uint8_t> receivedData;
-        char buffer[4096];
-        int bytesReceived;
+            // 该流的数据已全部放进批次，提交前不再参与调度
+            if (index + 1 == queue.size() && send.message.batched())
+            {
+                async.scheduler.deactivate(streamId);
+                batch.parked[batch.parkedCount++] = streamId;
+            }
+        }
+    }
 
-        do
+    // 按实际写出的字节数推进各条消息，没写出的部分退还给调度器；写完的消息完成回调
+    void commitBatch(Batch &batch, size_t sent, int64_t now, Completions &done)
+    {
+        AsyncState &async = *async_;
+        async.hasPartialFrame = false;
+        for (size_t i = 0; i < batch.entryCount; i++)
         {
-            bytesReceived = recv(socket_, buffer, sizeof(buffer), 0);
-            if (bytesReceived > 0)
+            Batch::Entry &entry = batch.entries[i];
+            size_t written = std::min(entry.bytes, sent);
+            sent -= written;
+            entry.send->message.advance(written);
+            entry.send->message.rewind();
+            if (written < entry.bytes)
+            {
+                async.scheduler.refund(entry.streamId, entry.bytes - written);
+            }
+            if (entry.send->message.midFrame())
             {
-                receivedData.insert(receivedData.end(), buffer, buffer + bytesReceived);
+                async.hasPartialFrame = true;
+                async.partialStream = entry.streamId;
             }
-        } while (bytesReceived == sizeof(buffer));
+        }
 
-        if (bytesReceived == SOCKET_ERROR)
+        for (size_t i = 0; i < batch.entryCount; i++)
         {
-            return "";
+            uint16_t streamId = batch.entries[i].streamId;
+            FifoQueue<AsyncSend> &queue = async.sends.find(streamId)->second;
+            while (!queue.empty() && queue.front().message.done())
+            {
+                addMetric(Metrics::Counter::MESSAGES_SENT);
+                addMetric(Metrics::Counter::FRAMES_SENT, queue.front().message.chunks());
+                Metrics::record(Metrics::Latency::SEND, static_cast<uint64_t>(now - queue.front().queuedMicros));
+                done.push_back({std::move(queue.front().callback), nullptr, true, Buffer()});
+                queue.pop_front();
+            }
+            if (queue.empty())
+            {
+                async.scheduler.deactivate(streamId);
+            }
         }
 
-        return std::string(receivedData.begin(), receivedData.end());
+        for (size_t i = 0; i < batch.parkedCount; i++)
+        {
+            if (!async.sends.find(batch.parked[i])->second.empty())
+            {
+                async.scheduler.activate(batch.parked[i]);
+            }
+        }
     }
 
-    void closeConnection()
+    // 只在有等待中的接收时读取套接字，没有人接收时数据留在内核缓冲区里形成背压；
+    // 读到的消息按流交付，暂时没有人接收的流上的消息留在解析器中
+    bool pumpAsyncReceives(Completions &done, size_t &budget)
     {
-        if (socket_ != INVALID_SOCKET)
+        AsyncState &async = *async_;
+        while (true)
         {
-            closesocket(socket_);
-            socket_ = INVALID_SOCKET;
+            deliverReceives(done);
+            if (async.pendingReceives == 0 || (budget == 0 && deferToLoop()))
+            {
+                return true;
+            }
+
+            TransportSocket::IoVec vecs[3];
+            size_t count = frameDecoder_.prepareRead(vecs, 3);
+            auto result = socket_->receivev(vecs, count);
+            addMetric(Metrics::Counter::RECEIVE_CALLS);
+            if (result.status == TransportSocket::IoStatus::OK)
+            {
+                addMetric(Metrics::Counter::BYTES_RECEIVED, result.bytes);
+                if (!frameDecoder_.commitRead(result.bytes))
+                {
+                    // 帧校验失败，数据流已无法恢复
+                    return false;
+                }
+                budget -= std::min(budget, result.bytes);
+                continue;
+            }
+            if (result.status == TransportSocket::IoStatus::WOULD_BLOCK)
+            {
+                if (!readyCallbackSupported_ && async.blocking.kind == BlockingWait::Kind::NONE)
+                {
+                    // 发送已经在等待时以发送为准，等待有超时，之后两个方向都会重新推进
+                    async.blocking = {BlockingWait::Kind::READABLE, 0};
+                }
+                return true;
+            }
+            // 对端关闭或出错
+            return false;
         }
-        isConnected_ = false;
     }
 
-private:
-    SOCKET socket_;
+    void deliverReceives(Completions &done)
+    {
+        AsyncState &async = *async_;
+        if (async.pendingReceives == 0)
+        {
+            return;
+        }
+        int64_t now = 0;
+        for (auto &entry : async.receives)
+        {
+            FifoQueue<AsyncReceive> &queue = entry.second;
+            while (!queue.empty() && frameDecoder_.hasMessage(entry.first))
+            {
+                AsyncReceive &receive = queue.front();
+                if (now == 0)
+                {
+                    now = nowMicros();
+                }
+                addMetric(Metrics::Counter::MESSAGES_RECEIVED);
+                Metrics::record(receive.request ? Metrics::Latency::ROUND_TRIP : Metrics::Latency::RECEIVE,
+                                static_cast<uint64_t>(now - receive.queuedMicros));
+                done.push_back({nullptr, std::move(receive.callback), true, frameDecoder_.popMessage(entry.first)});
+                queue.pop_front();
+                async.pendingReceives--;
+            }
+        }
+    }
+
+    // 所有排队的操作以失败结束（需持有 async_->mutex），流的优先级设置保留
+    void failAsync(Completions &done)
+    {
+        for (auto &entry : async_->sends)
+        {
+            FifoQueue<AsyncSend> &queue = entry.second;
+            while (!queue.empty())
+            {
+                done.push_back({std::move(queue.front().callback), nullptr, false, Buffer()});
+                queue.pop_front();
+            }
+        }
+        for (auto &entry : async_->receives)
+        {
+            FifoQueue<AsyncReceive> &queue = entry.second;
+            while (!queue.empty())
+            {
+                done.push_back({nullptr, std::move(queue.front().callback), false, Buffer()});
+                queue.pop_front();
+            }
+        }
+        async_->scheduler.reset();
+        async_->queuedBytes = 0;
+        async_->hasPartialFrame = false;
+        async_->pendingReceives = 0;
+    }
+
+    static int64_t nowMicros()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    void resetPathState()
+    {
+        congestionController_->reset();
+        pacer_.reset();
+        lastPathSample_ = 0;
+        lastBytesAcked_ = 0;
+        lastRetransmits_ = 0;
+        smoothedRttMicros_ = 0;
+        chunkSizeTuner_.reset();
+
+        transportControlsCongestion_ = socket_->controlsCongestion();
+        TransportSocket::PathInfo info;
+        pathInfoSupported_ = socket_->getPathInfo(info);
+        if (pathInfoSupported_)
+        {
+            lastBytesAcked_ = info.bytesAcked;
+            lastRetransmits_ = info.totalRetransmits;
+            smoothedRttMicros_ = info.rttMicros;
+            chunkSizeTuner_.onRtt(info.rttMicros);
+        }
+    }
+
+    void updatePacing(uint64_t window)
+    {
+        uint64_t rate = congestionController_->getPacingRate();
+        if (rate == 0 && smoothedRttMicros_ > 0)
+        {
+            rate = static_cast<uint64_t>(window * PACING_GAIN * 1e6 / smoothedRttMicros_);
+        }
+        pacer_.setRate(rate);
+        pacer_.setBurst(std::max<uint64_t>(rate * PACING_BURST_MICROS / 1000000, MIN_PACING_BURST));
+    }
+
+    // 把内核的确认与重传统计转换为控制器的 ACK/丢包事件，同时为分块大小的在线调整提供样本；
+    // 后端不提供统计时按已写出的字节数视为确认
+    void reportSent(size_t sent)
+    {
+        int64_t now = nowMicros();
+        chunkSizeTuner_.onSent(sent, now);
+        chunkSizeTuner_.update(tcpChunkOptimizer_, now);
+        if (!pathInfoSupported_)
+        {
+            congestionController_->onAck({sent, 0, 0, 0, now});
+            sampleWindow(now);
+            return;
+        }
+        if (now - lastPathSample_ < PATH_SAMPLE_INTERVAL_MICROS)
+        {
+            return;
+        }
+        lastPathSample_ = now;
+
+        TransportSocket::PathInfo info;
+        if (!socket_->getPathInfo(info))
+        {
+            return;
+        }
+        if (info.rttMicros > 0)
+        {
+            smoothedRttMicros_ = info.rttMicros;
+            chunkSizeTuner_.onRtt(info.rttMicros);
+        }
+
+        if (info.totalRetransmits > lastRetransmits_)
+        {
+            uint64_t lost = static_cast<uint64_t>(info.totalRetransmits - lastRetransmits_) * info.mss;
+            congestionController_->onLoss({lost, info.bytesInFlight, false, now});
+            addMetric(Metrics::Counter::LOSS_EVENTS);
+        }
+        lastRetransmits_ = info.totalRetransmits;
+
+        if (info.bytesAcked > lastBytesAcked_)
+        {
+            congestionController_->onAck({info.bytesAcked - lastBytesAcked_, info.bytesInFlight, info.rttMicros,
+                                          info.deliveryRate, now});
+            lastBytesAcked_ = info.bytesAcked;
+        }
+        sampleWindow(now);
+    }
+
+    std::shared_ptr<SocketBackend> backend_;
+    // 调用线程在锁外等待套接字就绪时持有一份引用，关闭连接不会在等待途中销毁它
+    std::shared_ptr<TransportSocket> socket_;
     bool isConnected_;
-    CongestionControl congestionControl_;
+    std::unique_ptr<CongestionController> congestionController_;
+    bool pathInfoSupported_;
+    // 传输层自己按确认与丢包控制发送（可靠 UDP），本连接的控制器只跟踪统计，不再限制写出
+    bool transportControlsCongestion_;
+    int64_t lastPathSample_;
+    uint64_t lastBytesAcked_;
+    uint32_t lastRetransmits_;
+    uint32_t smoothedRttMicros_;
+    Pacer pacer_;
     TcpChunkOptimization tcpChunkOptimizer_;
+    ChunkSizeTuner chunkSizeTuner_;
+    std::shared_ptr<BufferPool> bufferPool_;
+    FrameDecoder frameDecoder_;
+    // 压缩开关与压缩器（有旁路状态）由 compressionMutex_ 保护，发送线程在 async_->mutex 之外压缩；
+    // 需要同时持有时先取 compressionMutex_
+    std::mutex compressionMutex_;
+    std::atomic<bool> compressionEnabled_;
+    ChunkCompressor compressor_;
     LoadBalancer loadBalancer_;
+    std::shared_ptr<AsyncState> async_;
+    bool readyCallbackSupported_;
+    Metrics::Counters counters_;
+    // 拥塞窗口轨迹，环形保存最近的 WINDOW_HISTORY 个点
+    static constexpr size_t WINDOW_HISTORY = 64;
+    std::array<Metrics::WindowSample, WINDOW_HISTORY> windowHistory_;
+    size_t windowSamples_;
 };
 
 // Protocol类的公共方法实现
-Protocol::Protocol() : impl(new ProtocolImpl()) {}
+Protocol::Protocol() : impl(new ProtocolImpl(nullptr)) {}
+Protocol::Protocol(std::shared_ptr<SocketBackend> backend) : impl(new ProtocolImpl(std::move(backend))) {}
+Protocol::Protocol(std::shared_ptr<SocketBackend> backend, std::unique_ptr<TransportSocket> socket)
+    : impl(new ProtocolImpl(std::move(backend)))
+{
+    impl->adoptConnection(std::move(socket));
+}
 Protocol::~Protocol() = default;
 
 bool Protocol::initializeConnection(const std::string &host, uint16_t port)
 {
-    return impl->initializeConnection(host, port);
+    return impl->initializeConnection(host, port, -1);
+}
+
+bool Protocol::initializeConnection(const std::string &host, uint16_t port, int timeoutMs)
+{
+    return impl->initializeConnection(host, port, timeoutMs);
+}
+
+bool Protocol::isConnected() const
+{
+    return impl->isConnected();
 }
 
 void Protocol::setCongestionControlAlgorithm(CongestionControl::Algorithm algo)
@@ -149,17 +1385,152 @@ void Protocol::setCongestionControlAlgorithm(CongestionControl::Algorithm algo)
     impl->setCongestionControlAlgorithm(algo);
 }
 
-bool Protocol::sendData(const std::string &data)
+void Protocol::setCongestionController(CongestionController::Type type)
+{
+    impl->setCongestionController(CongestionController::create(type));
+}
+
+void Protocol::setCongestionController(std::unique_ptr<CongestionController> controller)
+{
+    impl->setCongestionController(std::move(controller));
+}
+
+void Protocol::setStreamPriority(uint16_t streamId, uint8_t priority, uint16_t weight)
+{
+    impl->setStreamPriority(streamId, priority, weight);
+}
+
+bool Protocol::sendData(const std::string &data, uint16_t streamId)
+{
+    return impl->sendData(reinterpret_cast<const uint8_t *>(data.data()), data.size(), streamId);
+}
+
+bool Protocol::sendData(const uint8_t *data, size_t length, uint16_t streamId)
+{
+    return impl->sendData(data, length, streamId);
+}
+
+std::string Protocol::receiveData(uint16_t streamId)
+{
+    Buffer message;
+    return impl->receiveBuffer(message, streamId) ? message.toString() : std::string();
+}
+
+bool Protocol::receiveBuffer(Buffer &message, uint16_t streamId)
+{
+    return impl->receiveBuffer(message, streamId);
+}
+
+bool Protocol::receiveInto(uint8_t *buffer, size_t capacity, size_t &length, uint16_t streamId)
+{
+    Buffer message;
+    if (!impl->receiveBuffer(message, streamId))
+    {
+        length = 0;
+        return false;
+    }
+    length = message.size();
+    std::memcpy(buffer, message.data(), std::min(capacity, length));
+    return length <= capacity;
+}
+
+std::future<bool> Protocol::sendAsync(std::string data, uint16_t streamId)
+{
+    auto promise = std::make_shared<std::promise<bool>>();
+    std::future<bool> future = promise->get_future();
+    impl->submit(streamId, SendSource::of(std::move(data)), [promise](bool ok)
+                 { promise->set_value(ok); },
+                 nullptr);
+    return future;
+}
+
+void Protocol::sendAsync(std::string data, SendCallback callback, uint16_t streamId)
+{
+    impl->submit(streamId, SendSource::of(std::move(data)), std::move(callback), nullptr);
+}
+
+std::future<bool> Protocol::sendAsync(Buffer data, uint16_t streamId)
+{
+    auto promise = std::make_shared<std::promise<bool>>();
+    std::future<bool> future = promise->get_future();
+    impl->submit(streamId, SendSource::of(std::move(data)), [promise](bool ok)
+                 { promise->set_value(ok); },
+                 nullptr);
+    return future;
+}
+
+void Protocol::sendAsync(Buffer data, SendCallback callback, uint16_t streamId)
+{
+    impl->submit(streamId, SendSource::of(std::move(data)), std::move(callback), nullptr);
+}
+
+std::future<std::string> Protocol::receiveAsync(uint16_t streamId)
+{
+    auto promise = std::make_shared<std::promise<std::string>>();
+    std::future<std::string> future = promise->get_future();
+    impl->submit(streamId, SendSource(), nullptr, fulfil(promise));
+    return future;
+}
+
+void Protocol::receiveAsync(ReceiveCallback callback, uint16_t streamId)
+{
+    impl->submit(streamId, SendSource(), nullptr, deliverString(std::move(callback)));
+}
+
+void Protocol::receiveBufferAsync(BufferCallback callback, uint16_t streamId)
+{
+    impl->submit(streamId, SendSource(), nullptr, std::move(callback));
+}
+
+std::future<std::string> Protocol::requestAsync(std::string request, uint16_t streamId)
+{
+    auto promise = std::make_shared<std::promise<std::string>>();
+    std::future<std::string> future = promise->get_future();
+    impl->submit(streamId, SendSource::of(std::move(request)), [](bool) {}, fulfil(promise));
+    return future;
+}
+
+void Protocol::requestAsync(std::string request, ReceiveCallback callback, uint16_t streamId)
+{
+    impl->submit(streamId, SendSource::of(std::move(request)), [](bool) {}, deliverString(std::move(callback)));
+}
+
+std::shared_ptr<BufferPool> Protocol::bufferPool() const
 {
-    return impl->sendData(data);
+    return impl->bufferPool();
 }
 
-std::string Protocol::receiveData()
+void Protocol::setCoalescingDelay(uint32_t delayMicros)
 {
-    return impl->receiveData();
+    impl->setCoalescingDelay(delayMicros);
+}
+
+void Protocol::flush()
+{
+    impl->flush();
+}
+
+Metrics::ConnectionSnapshot Protocol::metrics() const
+{
+    return impl->metrics();
+}
+
+void Protocol::setCompression(bool enabled)
+{
+    impl->setCompression(enabled, ChunkCompressor::Config());
+}
+
+void Protocol::setCompression(bool enabled, const ChunkCompressor::Config &config)
+{
+    impl->setCompression(enabled, config);
+}
+
+void Protocol::setCloseCallback(std::function<void()> callback)
+{
+    impl->setCloseCallback(std::move(callback));
 }
 
 void Protocol::closeConnection()
 {
     impl->closeConnection();
-}
\ No newline at end of file
+}
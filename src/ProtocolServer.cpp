@@ -0,0 +1,304 @@
+#include "ProtocolServer.h"
+#include "EpollBackend.h"
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+// 进程允许运行的 CPU 编号（受 taskset、cgroup 等限制）
+std::vector<int> allowedCpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    if (cpus.empty()) {
+        unsigned count = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned cpu = 0; cpu < count; cpu++) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+    return cpus;
+}
+
+int openListener(const sockaddr_in& address, int backlog) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (fd < 0) {
+        return -1;
+    }
+    int one = 1;
+    if (::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0 ||
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0 ||
+        ::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0 ||
+        ::listen(fd, backlog) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+} // namespace
+
+// 一个核心上的全部状态：事件循环、后端、监听套接字和连接表，只由本循环线程访问
+struct ProtocolServer::Shard : std::enable_shared_from_this<Shard> {
+    std::shared_ptr<EventLoop> loop;
+    std::shared_ptr<SocketBackend> backend;
+    std::shared_ptr<UdpBackend> udp;    // 可靠 UDP 模式下与 backend 是同一个对象
+    ConnectionHandler handler;
+    int listenFd = -1;
+    int cpu = -1;
+    std::thread thread;
+    std::atomic<size_t> connectionCount{0};
+
+    // 只在循环线程中访问
+    std::unordered_map<Protocol*, std::shared_ptr<Protocol>> connections;
+
+    ~Shard() {
+        if (listenFd >= 0) {
+            ::close(listenFd);
+        }
+    }
+
+    void run() {
+        if (cpu >= 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            // 绑定失败（例如容器限制了可用的 CPU）时照常运行
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        }
+        loop->run();
+    }
+
+    // 监听套接字是边缘触发的：每次就绪都把已完成握手的连接全部取走
+    void acceptAll() {
+        while (listenFd >= 0) {
+            int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) {
+                    continue;
+                }
+                // EAGAIN 表示已经取完；描述符耗尽等错误时连接留在队列中，下一个连接到来时再试
+                return;
+            }
+
+            std::unique_ptr<TransportSocket> socket = backend->createSocket();
+            if (!socket->adopt(fd)) {
+                ::close(fd);
+                continue;
+            }
+            addConnection(std::move(socket));
+        }
+    }
+
+    // 为已经建立的传输连接创建 Protocol，持有它直到变为不可用，再交给处理函数
+    void addConnection(std::unique_ptr<TransportSocket> socket) {
+        auto connection = std::make_shared<Protocol>(backend, std::move(socket));
+        std::weak_ptr<Shard> weakShard = shared_from_this();
+        std::weak_ptr<Protocol> weakConnection = connection;
+        connection->setCloseCallback([weakShard, weakConnection] {
+            // 回调可能在连接自身的调用中执行，总是投递到循环中再释放连接
+            if (auto shard = weakShard.lock()) {
+                shard->loop->queueInLoop([weakShard, weakConnection] {
+                    auto shard = weakShard.lock();
+                    auto connection = weakConnection.lock();
+                    if (shard && connection) {
+                        shard->remove(connection.get());
+                    }
+                });
+            }
+        });
+        connections.emplace(connection.get(), connection);
+        connectionCount++;
+        handler(connection);
+    }
+
+    void remove(Protocol* connection) {
+        if (connections.erase(connection) > 0) {
+            connectionCount--;
+        }
+    }
+
+    // 在循环线程中执行：停止接受新连接，关闭所有连接，然后结束循环
+    void shutdown() {
+        if (listenFd >= 0) {
+            loop->removeFd(listenFd);
+            ::close(listenFd);
+            listenFd = -1;
+        }
+        if (udp) {
+            udp->stopListening();
+        }
+        std::unordered_map<Protocol*, std::shared_ptr<Protocol>> closing;
+        closing.swap(connections);
+        connectionCount = 0;
+        for (auto& entry : closing) {
+            entry.second->closeConnection();
+        }
+        if (udp) {
+            // 可靠 UDP 的连接关闭后还要在循环中发完剩余数据并等待对端确认，循环即将停止，就地结束它们
+            udp->closeAccepted();
+        }
+        loop->stop();
+    }
+};
+
+ProtocolServer::ProtocolServer(ConnectionHandler handler)
+    : ProtocolServer(Config(), std::move(handler))
+{
+}
+
+ProtocolServer::ProtocolServer(const Config& config, ConnectionHandler handler)
+    : config(config)
+    , handler(std::move(handler))
+    , boundPort(0)
+{
+}
+
+ProtocolServer::~ProtocolServer() {
+    stop();
+}
+
+bool ProtocolServer::start(const std::string& host, uint16_t port) {
+    stop();
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+        return false;
+    }
+
+    std::vector<int> cpus = allowedCpus();
+    size_t count = config.threads > 0 ? config.threads : cpus.size();
+    std::vector<std::shared_ptr<Shard>> created;
+    try {
+        for (size_t i = 0; i < count; i++) {
+            auto shard = std::make_shared<Shard>();
+            if (config.reliableUdp) {
+                shard->loop = std::make_shared<EventLoop>();
+                shard->udp = std::make_shared<UdpBackend>(config.udp, shard->loop);
+                shard->backend = shard->udp;
+                shard->handler = handler;
+                shard->cpu = config.pinThreads ? cpus[i % cpus.size()] : -1;
+
+                // 接受的连接在本循环线程中交付
+                std::weak_ptr<Shard> weakShard = shard;
+                uint16_t bound = shard->udp->listen(host, ntohs(address.sin_port),
+                    [weakShard](std::unique_ptr<TransportSocket> socket) {
+                        if (auto shard = weakShard.lock()) {
+                            shard->addConnection(std::move(socket));
+                        }
+                    });
+                if (bound == 0) {
+                    return false;
+                }
+                // 第一个循环的端口由内核选定时，其余的绑定同一个端口
+                address.sin_port = htons(bound);
+                created.push_back(std::move(shard));
+                continue;
+            }
+            shard->listenFd = openListener(address, config.backlog);
+            if (shard->listenFd < 0) {
+                return false;
+            }
+            if (address.sin_port == 0) {
+                // 内核为第一个监听套接字选定端口，其余的绑定同一个端口
+                socklen_t length = sizeof(address);
+                if (::getsockname(shard->listenFd, reinterpret_cast<sockaddr*>(&address), &length) < 0) {
+                    return false;
+                }
+            }
+
+            shard->loop = std::make_shared<EventLoop>();
+            if (config.backendFactory) {
+                shard->backend = config.backendFactory(shard->loop);
+            }
+            if (!shard->backend) {
+                shard->backend = std::make_shared<EpollBackend>(shard->loop);
+            }
+            shard->handler = handler;
+            shard->cpu = config.pinThreads ? cpus[i % cpus.size()] : -1;
+
+            std::weak_ptr<Shard> weakShard = shard;
+            if (!shard->loop->addFd(shard->listenFd, EPOLLIN | EPOLLET, [weakShard](uint32_t) {
+                    if (auto shard = weakShard.lock()) {
+                        shard->acceptAll();
+                    }
+                })) {
+                return false;
+            }
+            created.push_back(std::move(shard));
+        }
+    } catch (const std::runtime_error&) {
+        // 事件循环创建失败（描述符耗尽等）
+        return false;
+    }
+
+    // 所有监听套接字都建好之后才启动线程，前面失败时没有需要停止的循环
+    shards = std::move(created);
+    for (auto& shard : shards) {
+        Shard* raw = shard.get();
+        shard->thread = std::thread([raw] {
+            raw->run();
+        });
+    }
+    boundPort = ntohs(address.sin_port);
+    return true;
+}
+
+void ProtocolServer::stop() {
+    for (auto& shard : shards) {
+        Shard* raw = shard.get();
+        shard->loop->queueInLoop([raw] {
+            raw->shutdown();
+        });
+    }
+    for (auto& shard : shards) {
+        if (shard->thread.joinable()) {
+            shard->thread.join();
+        }
+    }
+    shards.clear();
+    boundPort = 0;
+}
+
+bool ProtocolServer::isRunning() const {
+    return !shards.empty();
+}
+
+uint16_t ProtocolServer::port() const {
+    return boundPort;
+}
+
+size_t ProtocolServer::threadCount() const {
+    return shards.size();
+}
+
+size_t ProtocolServer::connectionCount() const {
+    size_t total = 0;
+    for (auto& shard : shards) {
+        total += shard->connectionCount.load();
+    }
+    return total;
+}
+
+size_t ProtocolServer::connectionCount(size_t thread) const {
+    return thread < shards.size() ? shards[thread]->connectionCount.load() : 0;
+}
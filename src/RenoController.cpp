@@ -0,0 +1,45 @@
+#include "RenoController.h"
+#include <algorithm>
+
+RenoController::RenoController(uint32_t mss)
+    : state()
+    , mss(mss)
+    , ackedInRound(0)
+{
+}
+
+void RenoController::onAck(const AckEvent& event) {
+    ackedInRound += event.bytesAcked;
+    // 一个窗口的数据全部确认后推进一轮
+    while (ackedInRound >= getCongestionWindow()) {
+        ackedInRound -= getCongestionWindow();
+        state.updateWindow(true, false);
+    }
+}
+
+void RenoController::onLoss(const LossEvent& event) {
+    // 超时回到慢启动，否则按三个重复 ACK 进入快速恢复
+    state.updateWindow(false, event.timeout);
+    ackedInRound = 0;
+}
+
+uint64_t RenoController::getCongestionWindow() const {
+    return static_cast<uint64_t>(std::max<uint32_t>(state.getCurrentWindow(), 1)) * mss;
+}
+
+uint64_t RenoController::getSlowStartThreshold() const {
+    return static_cast<uint64_t>(state.getStateInfo().ssthresh) * mss;
+}
+
+void RenoController::reset() {
+    state.reset();
+    ackedInRound = 0;
+}
+
+void RenoController::setAlgorithm(CongestionControl::Algorithm algo) {
+    state.setAlgorithm(algo);
+}
+
+CongestionControl::StateInfo RenoController::getStateInfo() const {
+    return state.getStateInfo();
+}
@@ -0,0 +1,85 @@
+#include "RingBuffer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    size_t roundUpToPowerOfTwo(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+}
+
+RingBuffer::RingBuffer(size_t capacity)
+    : buffer(roundUpToPowerOfTwo(std::max<size_t>(capacity, 16)))
+    , mask(buffer.size() - 1)
+    , readPos(0)
+    , writePos(0)
+{
+}
+
+size_t RingBuffer::size() const {
+    return writePos - readPos;
+}
+
+size_t RingBuffer::capacity() const {
+    return buffer.size();
+}
+
+size_t RingBuffer::available() const {
+    return buffer.size() - size();
+}
+
+bool RingBuffer::empty() const {
+    return readPos == writePos;
+}
+
+size_t RingBuffer::writableSpans(Span spans[2]) {
+    size_t free = available();
+    if (free == 0) {
+        return 0;
+    }
+
+    size_t start = writePos & mask;
+    size_t first = std::min(free, buffer.size() - start);
+    spans[0] = {buffer.data() + start, first};
+    if (first == free) {
+        return 1;
+    }
+    spans[1] = {buffer.data(), free - first};
+    return 2;
+}
+
+void RingBuffer::commitWrite(size_t length) {
+    writePos += std::min(length, available());
+}
+
+bool RingBuffer::peek(uint8_t* destination, size_t length) const {
+    if (length > size()) {
+        return false;
+    }
+
+    size_t start = readPos & mask;
+    size_t first = std::min(length, buffer.size() - start);
+    std::memcpy(destination, buffer.data() + start, first);
+    std::memcpy(destination + first, buffer.data(), length - first);
+    return true;
+}
+
+size_t RingBuffer::read(uint8_t* destination, size_t length) {
+    length = std::min(length, size());
+    peek(destination, length);
+    readPos += length;
+    return length;
+}
+
+void RingBuffer::consume(size_t length) {
+    readPos += std::min(length, size());
+}
+
+void RingBuffer::clear() {
+    readPos = 0;
+    writePos = 0;
+}
@@ -0,0 +1,86 @@
+#include "SocketBackend.h"
+
+#if defined(_WIN32)
+#include "WinsockBackend.h"
+#elif defined(__linux__)
+#include "EpollBackend.h"
+#include "IoUringBackend.h"
+#else
+#error "Unsupported platform: no socket backend available"
+#endif
+
+TransportSocket::IoResult TransportSocket::sendv(const IoVec* vecs, size_t count) {
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        IoResult result = send(vecs[i].base, vecs[i].length);
+        if (result.status != IoStatus::OK) {
+            return total > 0 ? IoResult{IoStatus::OK, total} : result;
+        }
+        total += result.bytes;
+        if (result.bytes < vecs[i].length) {
+            break;
+        }
+    }
+    return {IoStatus::OK, total};
+}
+
+TransportSocket::IoResult TransportSocket::receivev(const IoVec* vecs, size_t count) {
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        IoResult result = receive(vecs[i].base, vecs[i].length);
+        if (result.status != IoStatus::OK) {
+            return total > 0 ? IoResult{IoStatus::OK, total} : result;
+        }
+        total += result.bytes;
+        if (result.bytes < vecs[i].length) {
+            break;
+        }
+    }
+    return {IoStatus::OK, total};
+}
+
+bool TransportSocket::adopt(intptr_t) {
+    return false;
+}
+
+bool TransportSocket::getPathInfo(PathInfo&) const {
+    return false;
+}
+
+bool TransportSocket::isPeerClosed() const {
+    return false;
+}
+
+bool TransportSocket::setReadyCallback(std::function<void()>) {
+    return false;
+}
+
+bool TransportSocket::controlsCongestion() const {
+    return false;
+}
+
+bool SocketBackend::runAfter(int64_t, std::function<void()>) {
+    return false;
+}
+
+std::shared_ptr<SocketBackend> SocketBackend::getDefault() {
+#if defined(_WIN32)
+    static std::shared_ptr<SocketBackend> backend = std::make_shared<WinsockBackend>();
+#else
+    // io_uring 后端的连接数受固定槽位限制，默认仍用没有上限的 epoll，需要时显式创建 IoUringBackend
+    static std::shared_ptr<SocketBackend> backend = std::make_shared<EpollBackend>();
+#endif
+    return backend;
+}
+
+std::shared_ptr<SocketBackend> SocketBackend::createPreferred(std::shared_ptr<EventLoop> loop) {
+#if defined(_WIN32)
+    (void)loop;
+    return std::make_shared<WinsockBackend>();
+#else
+    if (auto uring = IoUringBackend::create(loop)) {
+        return uring;
+    }
+    return std::make_shared<EpollBackend>(std::move(loop));
+#endif
+}
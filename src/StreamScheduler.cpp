@@ -0,0 +1,94 @@
+#include "StreamScheduler.h"
+#include <algorithm>
+
+StreamScheduler::StreamScheduler()
+    : virtualTime(0)
+{
+}
+
+void StreamScheduler::setPriority(uint16_t streamId, uint8_t priority, uint16_t weight) {
+    Stream& stream = streams[streamId];
+    stream.weight = std::max<uint16_t>(weight, 1);
+    update(streamId, stream, priority, stream.pass);
+}
+
+void StreamScheduler::activate(uint16_t streamId) {
+    Stream& stream = streams[streamId];
+    if (stream.active) {
+        return;
+    }
+    stream.active = true;
+    stream.pass = std::max(stream.pass, virtualTime);
+    Key key(stream.priority, stream.pass, streamId);
+    if (stream.node) {
+        stream.node.value() = key;
+        order.insert(std::move(stream.node));
+    } else {
+        order.insert(key);
+    }
+}
+
+void StreamScheduler::deactivate(uint16_t streamId) {
+    auto it = streams.find(streamId);
+    if (it == streams.end() || !it->second.active) {
+        return;
+    }
+    Stream& stream = it->second;
+    stream.node = order.extract(Key(stream.priority, stream.pass, streamId));
+    stream.active = false;
+}
+
+bool StreamScheduler::next(uint16_t& streamId) const {
+    if (order.empty()) {
+        return false;
+    }
+    streamId = std::get<2>(*order.begin());
+    return true;
+}
+
+void StreamScheduler::charge(uint16_t streamId, uint64_t bytes) {
+    auto it = streams.find(streamId);
+    if (it == streams.end()) {
+        return;
+    }
+    Stream& stream = it->second;
+    virtualTime = std::max(virtualTime, stream.pass);
+    update(streamId, stream, stream.priority, stream.pass + bytes * STRIDE_SCALE / stream.weight);
+}
+
+void StreamScheduler::refund(uint16_t streamId, uint64_t bytes) {
+    auto it = streams.find(streamId);
+    if (it == streams.end()) {
+        return;
+    }
+    Stream& stream = it->second;
+    uint64_t stride = bytes * STRIDE_SCALE / stream.weight;
+    update(streamId, stream, stream.priority, stream.pass > stride ? stream.pass - stride : 0);
+}
+
+bool StreamScheduler::empty() const {
+    return order.empty();
+}
+
+void StreamScheduler::reset() {
+    while (!order.empty()) {
+        auto node = order.extract(order.begin());
+        streams[std::get<2>(node.value())].node = std::move(node);
+    }
+    virtualTime = 0;
+    for (auto& entry : streams) {
+        entry.second.pass = 0;
+        entry.second.active = false;
+    }
+}
+
+void StreamScheduler::update(uint16_t streamId, Stream& stream, uint8_t priority, uint64_t pass) {
+    if (stream.active) {
+        // 摘下节点改键后放回，不重新分配
+        auto node = order.extract(Key(stream.priority, stream.pass, streamId));
+        node.value() = Key(priority, pass, streamId);
+        order.insert(std::move(node));
+    }
+    stream.priority = priority;
+    stream.pass = pass;
+}
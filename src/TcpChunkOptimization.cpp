@@ -6,6 +6,7 @@ TcpChunkOptimization::TcpChunkOptimization()
     : maxChunkSize(64 * 1024)  // 默认最大分块大小为64KB
     , minChunkSize(1024)       // 默认最小分块大小为1KB
     , currentChunkSize(8 * 1024) // 默认当前分块大小为8KB
+    , coalescingDelay(0)         // 默认不合并小消息
 {
 }
 
@@ -72,6 +73,20 @@ uint32_t TcpChunkOptimization::getCurrentOptimalChunkSize() const {
     return currentChunkSize;
 }
 
+void TcpChunkOptimization::setCoalescingDelay(uint32_t delayMicros) {
+    coalescingDelay = delayMicros;
+}
+
+uint32_t TcpChunkOptimization::getCoalescingDelay() const {
+    return coalescingDelay;
+}
+
+bool TcpChunkOptimization::shouldFlush(size_t pendingBytes, int64_t waitedMicros) const {
+    return coalescingDelay == 0
+        || pendingBytes >= currentChunkSize
+        || waitedMicros >= static_cast<int64_t>(coalescingDelay);
+}
+
 uint32_t TcpChunkOptimization::calculateOptimalChunkSize(double networkQuality) {
     // 根据网络质量动态调整分块大小
     // networkQuality 范围：0-1，1表示最佳网络状况
@@ -0,0 +1,102 @@
+#include "TimerWheel.h"
+#include <algorithm>
+
+TimerWheel::TimerWheel(int64_t tickMicros, size_t slotCount)
+    : tickMicros(std::max<int64_t>(tickMicros, 1))
+    , currentTick(0)
+    , started(false)
+    , slots(std::max<size_t>(slotCount, 1))
+{
+}
+
+int64_t TimerWheel::add(TimerId id, int64_t nowMicros, int64_t delayMicros, Task task) {
+    if (!started) {
+        currentTick = static_cast<uint64_t>(nowMicros / tickMicros);
+        started = true;
+    }
+
+    // 向上取整到刻度，且至少是下一个刻度，保证不会早于要求的时间执行
+    int64_t expireMicros = nowMicros + std::max<int64_t>(delayMicros, 0);
+    uint64_t expireTick = static_cast<uint64_t>((expireMicros + tickMicros - 1) / tickMicros);
+    expireTick = std::max(expireTick, currentTick + 1);
+
+    timers[id] = {expireTick, std::move(task)};
+    slots[expireTick % slots.size()].push_back(id);
+    return static_cast<int64_t>(expireTick) * tickMicros;
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    return timers.erase(id) > 0;
+}
+
+size_t TimerWheel::advance(int64_t nowMicros) {
+    uint64_t targetTick = static_cast<uint64_t>(nowMicros / tickMicros);
+    if (!started || targetTick <= currentTick) {
+        return 0;
+    }
+
+    // 一次最多扫描一整圈：落后很多刻度时每个槽位只需检查一次
+    uint64_t steps = std::min<uint64_t>(targetTick - currentTick, slots.size());
+    std::vector<Task> due;
+    for (uint64_t step = 1; step <= steps; step++) {
+        std::vector<TimerId>& slot = slots[(currentTick + step) % slots.size()];
+        size_t kept = 0;
+        for (TimerId id : slot) {
+            auto it = timers.find(id);
+            if (it == timers.end()) {
+                continue;
+            }
+            if (it->second.expireTick > targetTick) {
+                // 属于之后的轮次
+                slot[kept++] = id;
+                continue;
+            }
+            due.push_back(std::move(it->second.task));
+            timers.erase(it);
+        }
+        slot.resize(kept);
+    }
+    currentTick = targetTick;
+
+    // 全部摘下后再执行，任务中可以安全地添加或取消定时器
+    for (auto& task : due) {
+        task();
+    }
+    return due.size();
+}
+
+int64_t TimerWheel::nextExpiry() const {
+    if (timers.empty()) {
+        return -1;
+    }
+
+    // 先沿槽位向后找本轮内到期的定时器，通常很快就能找到
+    for (uint64_t step = 1; step <= slots.size(); step++) {
+        uint64_t tick = currentTick + step;
+        for (TimerId id : slots[tick % slots.size()]) {
+            auto it = timers.find(id);
+            if (it != timers.end() && it->second.expireTick == tick) {
+                return static_cast<int64_t>(tick) * tickMicros;
+            }
+        }
+    }
+
+    // 一整圈内都没有，说明全部定时器都在之后的轮次
+    uint64_t earliest = UINT64_MAX;
+    for (const auto& entry : timers) {
+        earliest = std::min(earliest, entry.second.expireTick);
+    }
+    return static_cast<int64_t>(earliest) * tickMicros;
+}
+
+bool TimerWheel::empty() const {
+    return timers.empty();
+}
+
+size_t TimerWheel::size() const {
+    return timers.size();
+}
+
+int64_t TimerWheel::getTickMicros() const {
+    return tickMicros;
+}
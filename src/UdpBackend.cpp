@@ -0,0 +1,1971 @@
+#include "UdpBackend.h"
+#include "Pacer.h"
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
+namespace {
+
+// 数据包格式（网络字节序），公共包头 | 类型(1) | 保留(3) | 连接编号(4) | 之后按类型追加：
+// SYN、SYN_ACK  | 接收窗口上限(8) |
+// DATA          | 包序号(8) | 流偏移(8) | 包序号减去最小未确认包序号(4) | 数据 |
+// ACK           | 接收窗口上限(8) | 确认延迟(4，微秒) | 区间数(2) | 区间(首个包序号8 + 最后一个包序号8)... |
+// CLOSE         无；收到对端的 CLOSE 时回复一个 CLOSE，主动关闭的一方据此确认对端已经释放连接
+// 接收窗口上限是对端可以发送到的流偏移（不含）；ACK 的区间按包序号从大到小排列
+enum PacketType : uint8_t {
+    PACKET_SYN = 1,
+    PACKET_SYN_ACK = 2,
+    PACKET_DATA = 3,
+    PACKET_ACK = 4,
+    PACKET_CLOSE = 5
+};
+
+constexpr size_t COMMON_HEADER_SIZE = 8;
+constexpr size_t HANDSHAKE_SIZE = COMMON_HEADER_SIZE + 8;
+constexpr size_t DATA_HEADER_SIZE = COMMON_HEADER_SIZE + 20;
+constexpr size_t ACK_HEADER_SIZE = COMMON_HEADER_SIZE + 14;
+constexpr size_t ACK_RANGE_SIZE = 16;
+// 接收方只保留最近的若干个区间；更早的空洞对应的包发送方早已判定丢失并重传
+constexpr size_t MAX_ACK_RANGES = 32;
+constexpr size_t MAX_ACK_SIZE = ACK_HEADER_SIZE + MAX_ACK_RANGES * ACK_RANGE_SIZE;
+
+// 数据报至少要容得下一个最大的确认包
+constexpr size_t MIN_DATAGRAM_SIZE = 576;
+constexpr size_t MAX_DATAGRAM_SIZE = 65507;
+
+// 丢包判定（RFC 9002）：比已确认的最大包序号小 3 以上，或发出后超过 9/8 个 RTT 仍未确认
+constexpr uint64_t PACKET_THRESHOLD = 3;
+constexpr int64_t TIMER_GRANULARITY_MICROS = 1000;
+// 尾部丢包探测：约一个 RTT 没有新确认时重发最后一个在途包，让它的确认暴露出之前的丢包，
+// 而不必等到下限较高的重传超时；连续探测几次仍无确认时才交给重传超时
+constexpr unsigned MAX_TAIL_PROBES = 2;
+
+// 一次 recvmmsg/sendmmsg 的数据包个数
+constexpr size_t RECEIVE_BATCH = 32;
+constexpr size_t SEND_BATCH = 64;
+// 一次 GSO 发送的段数与总长度上限
+constexpr size_t MAX_GSO_SEGMENTS = 64;
+constexpr size_t MAX_GSO_BYTES = 65000;
+
+// 控制器不给出速率时按 窗口/平滑RTT 乘以增益限速；突发量足够凑成一次 GSO 发送，也能跨过时间轮的刻度
+constexpr double PACING_GAIN = 1.25;
+constexpr int64_t PACING_BURST_MICROS = 1000;
+constexpr uint64_t MIN_PACING_BURST_PACKETS = 10;
+
+// 本地套接字缓冲区写满时多久后重试
+constexpr int64_t SEND_RETRY_MICROS = 1000;
+// SYN 与 CLOSE 的最多发送次数，超时间隔每次加倍
+constexpr unsigned MAX_HANDSHAKE_ATTEMPTS = 6;
+
+void writeUint16(uint8_t* out, uint16_t value) {
+    out[0] = static_cast<uint8_t>(value >> 8);
+    out[1] = static_cast<uint8_t>(value);
+}
+
+void writeUint32(uint8_t* out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value >> 24);
+    out[1] = static_cast<uint8_t>(value >> 16);
+    out[2] = static_cast<uint8_t>(value >> 8);
+    out[3] = static_cast<uint8_t>(value);
+}
+
+void writeUint64(uint8_t* out, uint64_t value) {
+    writeUint32(out, static_cast<uint32_t>(value >> 32));
+    writeUint32(out + 4, static_cast<uint32_t>(value));
+}
+
+uint16_t readUint16(const uint8_t* in) {
+    return static_cast<uint16_t>((in[0] << 8) | in[1]);
+}
+
+uint32_t readUint32(const uint8_t* in) {
+    return (static_cast<uint32_t>(in[0]) << 24) | (static_cast<uint32_t>(in[1]) << 16) |
+           (static_cast<uint32_t>(in[2]) << 8) | static_cast<uint32_t>(in[3]);
+}
+
+uint64_t readUint64(const uint8_t* in) {
+    return (static_cast<uint64_t>(readUint32(in)) << 32) | readUint32(in + 4);
+}
+
+void writeHeader(uint8_t* out, PacketType type, uint32_t id) {
+    out[0] = type;
+    out[1] = out[2] = out[3] = 0;
+    writeUint32(out + 4, id);
+}
+
+int64_t nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+size_t roundUpPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+uint64_t peerKey(const sockaddr_in& address) {
+    return (static_cast<uint64_t>(address.sin_addr.s_addr) << 16) | address.sin_port;
+}
+
+uint32_t randomConnectionId() {
+    static thread_local std::mt19937 generator(std::random_device{}());
+    uint32_t id;
+    do {
+        id = generator();
+    } while (id == 0);
+    return id;
+}
+
+// 在区间集合（起点 -> 终点，左闭右开）中加入 [start, end)，与相交或相邻的区间合并
+void insertRange(std::map<uint64_t, uint64_t>& ranges, uint64_t start, uint64_t end) {
+    auto it = ranges.upper_bound(start);
+    if (it != ranges.begin()) {
+        auto previous = std::prev(it);
+        if (previous->second >= start) {
+            start = previous->first;
+            end = std::max(end, previous->second);
+            it = ranges.erase(previous);
+        }
+    }
+    while (it != ranges.end() && it->first <= end) {
+        end = std::max(end, it->second);
+        it = ranges.erase(it);
+    }
+    ranges.emplace(start, end);
+}
+
+// 按流偏移读写环形缓冲区，容量为 2 的幂
+void copyToRing(uint8_t* ring, size_t mask, uint64_t offset, const uint8_t* data, size_t length) {
+    size_t position = static_cast<size_t>(offset) & mask;
+    size_t first = std::min(length, mask + 1 - position);
+    std::memcpy(ring + position, data, first);
+    std::memcpy(ring, data + first, length - first);
+}
+
+void copyFromRing(const uint8_t* ring, size_t mask, uint64_t offset, uint8_t* data, size_t length) {
+    size_t position = static_cast<size_t>(offset) & mask;
+    size_t first = std::min(length, mask + 1 - position);
+    std::memcpy(data, ring + position, first);
+    std::memcpy(data + first, ring, length - first);
+}
+
+// 就绪状态：连接在状态变化后递增读写计数，等待方比较计数判断是否有新的边缘（与 epoll 后端相同）
+struct Readiness {
+    std::atomic<uint64_t> readEpoch{0};
+    std::atomic<uint64_t> writeEpoch{0};
+    std::atomic<bool> closed{false};
+    std::atomic<bool> peerClosed{false};
+    std::atomic<int> waiters{0};
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::mutex callbackMutex;
+    std::shared_ptr<std::function<void()>> onReady;
+
+    void notify() {
+        if (waiters.load() > 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            cond.notify_all();
+        }
+    }
+
+    bool waitChange(const std::atomic<uint64_t>& epoch, uint64_t seen, int timeoutMs) {
+        auto changed = [&] {
+            return epoch.load() != seen || closed.load();
+        };
+
+        waiters.fetch_add(1);
+        std::unique_lock<std::mutex> lock(mutex);
+        bool ok;
+        if (timeoutMs < 0) {
+            cond.wait(lock, changed);
+            ok = true;
+        } else {
+            ok = cond.wait_for(lock, std::chrono::milliseconds(timeoutMs), changed);
+        }
+        lock.unlock();
+        waiters.fetch_sub(1);
+        return ok && !closed.load();
+    }
+};
+
+class Connection;
+
+// 服务端接受的连接交给应用的套接字
+std::unique_ptr<TransportSocket> createAcceptedSocket(const std::shared_ptr<EventLoop>& loop,
+                                                      const UdpBackend::Config& config,
+                                                      std::shared_ptr<Connection> connection);
+
+// 一批收包处理完后各连接的确认，合并为一次 sendmmsg（只在循环线程中使用）
+struct AckBatch {
+    uint8_t bytes[RECEIVE_BATCH][MAX_ACK_SIZE];
+    size_t lengths[RECEIVE_BATCH];
+    sockaddr_in peers[RECEIVE_BATCH];
+    size_t count = 0;
+};
+
+// 一个 UDP 套接字及其上的连接：客户端每个连接一个已 connect 的套接字，服务端所有对端共用监听套接字，
+// 按对端地址分派数据包
+struct Endpoint : std::enable_shared_from_this<Endpoint> {
+    std::shared_ptr<EventLoop> loop;
+    UdpBackend::Config config;
+    int fd = -1;
+    bool server = false;
+    sockaddr_in peer{};                 // 客户端套接字的对端
+    std::atomic<bool> gso{false};
+
+    std::mutex mutex;
+    std::unordered_map<uint64_t, std::shared_ptr<Connection>> connections;
+    UdpBackend::AcceptHandler acceptHandler;
+
+    // 只在循环线程中访问
+    std::vector<uint8_t> receiveBuffers;
+    std::vector<std::shared_ptr<Connection>> batch;    // 本批收到过数据包的连接
+    AckBatch acks;
+
+    ~Endpoint();
+
+    static std::shared_ptr<Endpoint> open(const std::shared_ptr<EventLoop>& loop, const UdpBackend::Config& config,
+                                          const sockaddr_in& address, bool server);
+
+    void onReadable();
+    void dispatch(const uint8_t* data, size_t length, const sockaddr_in& from, int64_t now);
+    void flushAcks();
+
+    // 发出 count 个数据包（第 i 个位于 packets + i * stride），返回从头开始成功交给内核的个数
+    size_t sendPackets(const uint8_t* packets, const size_t* lengths, size_t count, size_t stride,
+                       const sockaddr_in& to);
+    void sendPacket(const uint8_t* data, size_t length, const sockaddr_in& to);
+
+    void add(const std::shared_ptr<Connection>& connection, const sockaddr_in& address);
+    void remove(const sockaddr_in& address, const Connection* connection);
+
+    // 不再接受新连接，并立即结束所有连接。连接表与连接互相持有，只靠连接各自结束时移除，
+    // 事件循环停止后仍在关闭中的连接就永远不会释放
+    void abortAll();
+};
+
+// 一个连接的全部协议状态，受 mutex 保护：收包和定时器在循环线程中处理，send/receive 在调用线程中处理。
+// 持锁时只修改状态并记下要发出的就绪边缘，解锁后再唤醒等待方、调用就绪回调（回调会重新进入 send/receive）
+class Connection : public std::enable_shared_from_this<Connection> {
+public:
+    enum class ConnectResult {
+        PENDING,
+        CONNECTED,
+        FAILED
+    };
+
+    Connection(std::shared_ptr<Endpoint> endpoint, const sockaddr_in& peer, uint32_t id)
+        : inBatch(false)
+        , endpoint_(std::move(endpoint))
+        , peer_(peer)
+        , id_(id)
+        , config_(endpoint_->config)
+        , payloadSize_(config_.maxDatagramSize - DATA_HEADER_SIZE)
+        , ready_(std::make_shared<Readiness>())
+        , phase_(Phase::CONNECTING)
+        , peerClosed_(false)
+        , failed_(false)
+        , readEvent_(false)
+        , writeEvent_(false)
+        , detach_(false)
+        , detached_(false)
+        , sendCapacity_(roundUpPowerOfTwo(config_.sendBufferSize))
+        , sendRing_(new uint8_t[sendCapacity_])
+        , sendBase_(0)
+        , sendNext_(0)
+        , sendEnd_(0)
+        , peerMaxData_(0)
+        , sentBasePn_(0)
+        , nextPn_(0)
+        , hasLargestAcked_(false)
+        , largestAcked_(0)
+        , bytesInFlight_(0)
+        , packetsInFlight_(0)
+        , delivered_(0)
+        , deliveredTime_(0)
+        , firstSentTime_(0)
+        , deliveryRate_(0)
+        , retransmitCount_(0)
+        , controller_(CongestionController::create(config_.congestionControl, static_cast<uint32_t>(payloadSize_)))
+        , recoveryStart_(0)
+        , srtt_(0)
+        , rttvar_(0)
+        , latestRtt_(0)
+        , minRtt_(0)
+        , rto_(config_.initialRtoMicros)
+        , timeouts_(0)
+        , probes_(0)
+        , lastProgress_(0)
+        , lossTime_(0)
+        , pacingDeadline_(0)
+        , retryDeadline_(0)
+        , lastReceived_(nowMicros())
+        , lastKeepalive_(0)
+        , receiveCapacity_(roundUpPowerOfTwo(config_.receiveBufferSize))
+        , receiveRing_(new uint8_t[receiveCapacity_])
+        , readOffset_(0)
+        , receivedEnd_(0)
+        , advertisedMaxData_(receiveCapacity_)
+        , ackPending_(false)
+        , ackPendingSince_(0)
+        , synAckPending_(false)
+        , handshakeAttempts_(0)
+        , handshakeSentTime_(0)
+        , timerId_(0)
+        , timerDeadline_(0)
+        , timerGeneration_(0)
+    {
+    }
+
+    uint32_t id() const { return id_; }
+    const std::shared_ptr<Readiness>& readiness() const { return ready_; }
+
+    // 客户端：发出 SYN，之后由定时器重传
+    void startConnect() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        int64_t now = nowMicros();
+        handshakeAttempts_ = 1;
+        handshakeSentTime_ = now;
+        sendHandshake(PACKET_SYN);
+        updateTimer(now);
+        finish(lock, false);
+    }
+
+    // 服务端：收到新对端的 SYN，连接立即建立
+    void accept(const uint8_t* data) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        phase_ = Phase::ESTABLISHED;
+        peerMaxData_ = readUint64(data + COMMON_HEADER_SIZE);
+        sendHandshake(PACKET_SYN_ACK);
+        finish(lock, true);
+    }
+
+    ConnectResult connectResult() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (failed_ || peerClosed_ || phase_ == Phase::CLOSED) {
+            return ConnectResult::FAILED;
+        }
+        return phase_ == Phase::CONNECTING ? ConnectResult::PENDING : ConnectResult::CONNECTED;
+    }
+
+    // 循环线程：处理一个数据包，就绪边缘和确认留到本批结束时的 afterBatch
+    void onPacket(const uint8_t* data, size_t length, int64_t now) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (failed_ || peerClosed_ || phase_ == Phase::CLOSED) {
+            return;
+        }
+        lastReceived_ = now;
+        switch (data[0]) {
+        case PACKET_SYN:
+            // 对端没有收到 SYN_ACK
+            if (phase_ != Phase::CONNECTING) {
+                synAckPending_ = true;
+            }
+            break;
+        case PACKET_SYN_ACK:
+            if (phase_ == Phase::CONNECTING && length >= HANDSHAKE_SIZE) {
+                phase_ = Phase::ESTABLISHED;
+                peerMaxData_ = readUint64(data + COMMON_HEADER_SIZE);
+                // 重传过的 SYN 不知道对应哪一次发送，不作为 RTT 样本
+                if (handshakeAttempts_ == 1) {
+                    updateRtt(static_cast<uint64_t>(now - handshakeSentTime_), 0);
+                }
+                handshakeAttempts_ = 0;
+                lastProgress_ = now;
+                writeEvent_ = true;
+            }
+            break;
+        case PACKET_DATA:
+            if (phase_ != Phase::CONNECTING && length >= DATA_HEADER_SIZE) {
+                onData(data, length, now);
+            }
+            break;
+        case PACKET_ACK:
+            if (phase_ != Phase::CONNECTING && length >= ACK_HEADER_SIZE) {
+                onAck(data, length, now);
+            }
+            break;
+        case PACKET_CLOSE:
+            onPeerClose();
+            break;
+        default:
+            break;
+        }
+    }
+
+    // 循环线程：本批数据包处理完，回复确认并继续发送（确认可能打开了拥塞窗口）
+    void afterBatch(int64_t now, AckBatch& acks) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        inBatch = false;
+        if (isActive()) {
+            if (ackPending_ && acks.count < RECEIVE_BATCH) {
+                acks.lengths[acks.count] = buildAck(acks.bytes[acks.count], now);
+                acks.peers[acks.count] = peer_;
+                acks.count++;
+            }
+            if (synAckPending_) {
+                synAckPending_ = false;
+                sendHandshake(PACKET_SYN_ACK);
+            }
+            transmit(now);
+            updateTimer(now);
+        }
+        finish(lock, true);
+    }
+
+    // 连接已失败或已关闭，同一地址上的新 SYN 可以取代它
+    bool isFinished() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return !isActive();
+    }
+
+    // 循环线程：同一地址上收到了另一个编号的 SYN。不能凭它断开仍然存活的连接（地址可以伪造），
+    // 改为向对端发一个确认：对端确实已经重启时会以 CLOSE 回应旧编号，旧连接随之结束，对端重传的 SYN 再建立新连接
+    void probePeer() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (isActive() && phase_ != Phase::CONNECTING) {
+            ackPending_ = true;
+        }
+    }
+
+    // 同一地址上出现了新的连接（对端重启后复用了端口），旧连接按对端关闭处理
+    void onReplaced() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        onPeerClose();
+        finish(lock, true);
+    }
+
+    TransportSocket::IoResult send(const TransportSocket::IoVec* vecs, size_t count) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (failed_) {
+            return {TransportSocket::IoStatus::FAILED, 0};
+        }
+        if (peerClosed_ || phase_ != Phase::ESTABLISHED) {
+            return {TransportSocket::IoStatus::CLOSED, 0};
+        }
+        size_t space = sendCapacity_ - static_cast<size_t>(sendEnd_ - sendBase_);
+        if (space == 0) {
+            return {TransportSocket::IoStatus::WOULD_BLOCK, 0};
+        }
+
+        size_t total = 0;
+        for (size_t i = 0; i < count && total < space; i++) {
+            size_t length = std::min(vecs[i].length, space - total);
+            copyToRing(sendRing_.get(), sendCapacity_ - 1, sendEnd_ + total, static_cast<const uint8_t*>(vecs[i].base),
+                       length);
+            total += length;
+        }
+        sendEnd_ += total;
+
+        int64_t now = nowMicros();
+        transmit(now);
+        updateTimer(now);
+        finish(lock, false);
+        return {TransportSocket::IoStatus::OK, total};
+    }
+
+    TransportSocket::IoResult receive(const TransportSocket::IoVec* vecs, size_t count) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        size_t available = static_cast<size_t>(receivedEnd_ - readOffset_);
+        if (available == 0) {
+            if (failed_) {
+                return {TransportSocket::IoStatus::FAILED, 0};
+            }
+            if (peerClosed_) {
+                return {TransportSocket::IoStatus::CLOSED, 0};
+            }
+            return {TransportSocket::IoStatus::WOULD_BLOCK, 0};
+        }
+
+        size_t total = 0;
+        for (size_t i = 0; i < count && total < available; i++) {
+            size_t length = std::min(vecs[i].length, available - total);
+            copyFromRing(receiveRing_.get(), receiveCapacity_ - 1, readOffset_ + total,
+                         static_cast<uint8_t*>(vecs[i].base), length);
+            total += length;
+        }
+        readOffset_ += total;
+
+        // 窗口打开超过四分之一时立即通告，发送方不必等到下一次确认
+        if (isActive() && readOffset_ + receiveCapacity_ - advertisedMaxData_ >= receiveCapacity_ / 4) {
+            uint8_t ack[MAX_ACK_SIZE];
+            endpoint_->sendPacket(ack, buildAck(ack, nowMicros()), peer_);
+        }
+        finish(lock, false);
+        return {TransportSocket::IoStatus::OK, total};
+    }
+
+    void fillPathInfo(TransportSocket::PathInfo& info) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        info.rttMicros = static_cast<uint32_t>(srtt_);
+        info.mss = static_cast<uint32_t>(payloadSize_);
+        info.bytesAcked = sendBase_;
+        info.bytesInFlight = bytesInFlight_;
+        info.deliveryRate = deliveryRate_;
+        info.totalRetransmits = retransmitCount_;
+    }
+
+    // 应用关闭连接：还有未确认的数据时继续留在端点中发送（与 TCP 的 close 相同），全部确认或失败后再通知对端
+    void close() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (phase_ == Phase::ESTABLISHED && isActive()) {
+            phase_ = Phase::CLOSING;
+            checkDrained();
+            updateTimer(nowMicros());
+        } else if (phase_ != Phase::CLOSED) {
+            phase_ = Phase::CLOSED;
+            detach_ = true;
+        }
+        finish(lock, false);
+    }
+
+    // 端点关闭：立即结束连接并通知对端，不再等待未确认的数据；应用随后读写得到 FAILED
+    void abort() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (phase_ != Phase::CLOSED) {
+            if (isActive()) {
+                fail();
+            }
+            phase_ = Phase::CLOSED;
+            detach_ = true;
+        }
+        finish(lock, endpoint_->loop->isInLoopThread());
+    }
+
+    // 只在循环线程中访问，表示连接已在端点本批的待处理列表中
+    bool inBatch;
+
+private:
+    enum class Phase {
+        CONNECTING,
+        ESTABLISHED,
+        CLOSING,    // 应用已关闭，剩余数据仍在发送，全部确认后等待对端回应 CLOSE
+        CLOSED
+    };
+
+    enum PacketState : uint8_t {
+        IN_FLIGHT,
+        ACKED,
+        LOST
+    };
+
+    // 已发出的数据包，按包序号连续存放
+    struct SentPacket {
+        uint64_t offset;
+        uint32_t length;
+        PacketState state;
+        int64_t sentTime;
+        uint64_t delivered;         // 发出时已确认的总字节数，用于投递速率采样
+        int64_t deliveredTime;
+        int64_t firstSentTime;
+    };
+
+    bool isActive() const {
+        return !failed_ && !peerClosed_ && phase_ != Phase::CLOSED;
+    }
+
+    // 解锁并发出持锁期间记下的就绪边缘；连接已结束时从端点移除。
+    // 与 epoll 后端一样，边缘只在循环线程中发出：应用线程的 send/receive 可能持有上层的锁，
+    // 在其中调用就绪回调会重入（inLoop 为 false 时边缘留给循环线程的下一次 finish）
+    void finish(std::unique_lock<std::mutex>& lock, bool inLoop) {
+        bool readable = inLoop && readEvent_;
+        bool writable = inLoop && writeEvent_;
+        bool detach = detach_ && !detached_;
+        bool gone = failed_ || peerClosed_;
+        if (inLoop) {
+            readEvent_ = false;
+            writeEvent_ = false;
+        }
+        detached_ = detached_ || detach;
+        if (detach && timerDeadline_ != 0) {
+            endpoint_->loop->cancelTimer(timerId_);
+            timerDeadline_ = 0;
+            timerGeneration_++;
+        }
+        lock.unlock();
+
+        if (gone) {
+            ready_->peerClosed.store(true);
+        }
+        if (readable) {
+            ready_->readEpoch.fetch_add(1);
+        }
+        if (writable) {
+            ready_->writeEpoch.fetch_add(1);
+        }
+        if (readable || writable) {
+            ready_->notify();
+            std::shared_ptr<std::function<void()>> callback;
+            {
+                std::lock_guard<std::mutex> callbackLock(ready_->callbackMutex);
+                callback = ready_->onReady;
+            }
+            if (callback) {
+                (*callback)();
+            }
+        }
+        if (detach) {
+            // 端点的连接表可能持有最后一个引用
+            auto self = shared_from_this();
+            endpoint_->remove(peer_, this);
+        }
+    }
+
+    void sendControl(PacketType type) {
+        uint8_t packet[COMMON_HEADER_SIZE];
+        writeHeader(packet, type, id_);
+        endpoint_->sendPacket(packet, sizeof(packet), peer_);
+    }
+
+    void sendHandshake(PacketType type) {
+        uint8_t packet[HANDSHAKE_SIZE];
+        writeHeader(packet, type, id_);
+        advertisedMaxData_ = readOffset_ + receiveCapacity_;
+        writeUint64(packet + COMMON_HEADER_SIZE, advertisedMaxData_);
+        endpoint_->sendPacket(packet, sizeof(packet), peer_);
+    }
+
+    void onPeerClose() {
+        peerClosed_ = true;
+        if (phase_ == Phase::CLOSING) {
+            phase_ = Phase::CLOSED;
+        } else if (phase_ == Phase::ESTABLISHED) {
+            sendControl(PACKET_CLOSE);
+        }
+        readEvent_ = true;
+        writeEvent_ = true;
+        detach_ = true;
+    }
+
+    void fail() {
+        if (phase_ != Phase::CONNECTING) {
+            sendControl(PACKET_CLOSE);
+        }
+        failed_ = true;
+        if (phase_ == Phase::CLOSING) {
+            phase_ = Phase::CLOSED;
+        }
+        readEvent_ = true;
+        writeEvent_ = true;
+        detach_ = true;
+    }
+
+    // 数据全部确认后发出 CLOSE，由定时器重发，直到收到对端的 CLOSE 或次数用完
+    void checkDrained() {
+        if (phase_ == Phase::CLOSING && sendBase_ == sendEnd_ && handshakeAttempts_ == 0) {
+            handshakeAttempts_ = 1;
+            handshakeSentTime_ = nowMicros();
+            sendControl(PACKET_CLOSE);
+        }
+    }
+
+    // ---- 接收 ----
+
+    void onData(const uint8_t* data, size_t length, int64_t now) {
+        uint64_t packetNumber = readUint64(data + COMMON_HEADER_SIZE);
+        uint64_t offset = readUint64(data + COMMON_HEADER_SIZE + 8);
+        uint32_t leastDelta = readUint32(data + COMMON_HEADER_SIZE + 16);
+        const uint8_t* payload = data + DATA_HEADER_SIZE;
+        size_t payloadLength = length - DATA_HEADER_SIZE;
+        uint64_t end = offset + payloadLength;
+
+        // 超出通告的窗口：不确认，由发送方重传
+        if (end < offset || end > readOffset_ + receiveCapacity_) {
+            return;
+        }
+
+        if (leastDelta <= packetNumber) {
+            forgetBelow(packetNumber - leastDelta);
+        }
+        recordPacket(packetNumber);
+        if (!ackPending_) {
+            ackPending_ = true;
+            ackPendingSince_ = now;
+        }
+
+        if (end <= receivedEnd_) {
+            return;
+        }
+        uint64_t start = std::max(offset, receivedEnd_);
+        copyToRing(receiveRing_.get(), receiveCapacity_ - 1, start, payload + (start - offset),
+                   static_cast<size_t>(end - start));
+        if (offset > receivedEnd_) {
+            insertRange(outOfOrder_, start, end);
+            return;
+        }
+
+        receivedEnd_ = end;
+        while (!outOfOrder_.empty() && outOfOrder_.begin()->first <= receivedEnd_) {
+            receivedEnd_ = std::max(receivedEnd_, outOfOrder_.begin()->second);
+            outOfOrder_.erase(outOfOrder_.begin());
+        }
+        if (phase_ == Phase::CLOSING) {
+            // 应用已关闭，之后到达的数据直接丢弃
+            readOffset_ = receivedEnd_;
+        } else {
+            readEvent_ = true;
+        }
+    }
+
+    // 收到的包序号按区间升序保存，绝大多数包正好接在最后一个区间之后
+    void recordPacket(uint64_t packetNumber) {
+        auto& ranges = receivedPackets_;
+        if (!ranges.empty() && packetNumber == ranges.back().second + 1) {
+            ranges.back().second = packetNumber;
+            return;
+        }
+        if (ranges.empty() || packetNumber > ranges.back().second + 1) {
+            ranges.emplace_back(packetNumber, packetNumber);
+        } else {
+            // 乱序或重复到达：找到第一个末尾不早于 packetNumber - 1 的区间，插入或合并
+            auto it = std::lower_bound(ranges.begin(), ranges.end(), packetNumber,
+                [](const std::pair<uint64_t, uint64_t>& range, uint64_t value) {
+                    return range.second + 1 < value;
+                });
+            if (packetNumber + 1 < it->first) {
+                ranges.insert(it, std::make_pair(packetNumber, packetNumber));
+            } else {
+                it->first = std::min(it->first, packetNumber);
+                it->second = std::max(it->second, packetNumber);
+                auto next = std::next(it);
+                if (next != ranges.end() && next->first <= it->second + 1) {
+                    it->second = std::max(it->second, next->second);
+                    ranges.erase(next);
+                }
+            }
+        }
+        if (ranges.size() > MAX_ACK_RANGES) {
+            ranges.erase(ranges.begin());
+        }
+    }
+
+    // 发送方已不再等待 least 之前的包（已确认或已判定丢失），这些区间不必再确认
+    void forgetBelow(uint64_t least) {
+        auto& ranges = receivedPackets_;
+        size_t drop = 0;
+        while (drop < ranges.size() && ranges[drop].second < least) {
+            drop++;
+        }
+        ranges.erase(ranges.begin(), ranges.begin() + drop);
+        if (!ranges.empty() && ranges.front().first < least) {
+            ranges.front().first = least;
+        }
+    }
+
+    size_t buildAck(uint8_t* out, int64_t now) {
+        writeHeader(out, PACKET_ACK, id_);
+        advertisedMaxData_ = readOffset_ + receiveCapacity_;
+        writeUint64(out + COMMON_HEADER_SIZE, advertisedMaxData_);
+        int64_t delay = ackPending_ ? now - ackPendingSince_ : 0;
+        writeUint32(out + COMMON_HEADER_SIZE + 8, static_cast<uint32_t>(std::min<int64_t>(delay, UINT32_MAX)));
+
+        size_t count = receivedPackets_.size();
+        writeUint16(out + COMMON_HEADER_SIZE + 12, static_cast<uint16_t>(count));
+        uint8_t* range = out + ACK_HEADER_SIZE;
+        for (size_t i = 0; i < count; i++) {
+            const auto& received = receivedPackets_[count - 1 - i];
+            writeUint64(range, received.first);
+            writeUint64(range + 8, received.second);
+            range += ACK_RANGE_SIZE;
+        }
+        ackPending_ = false;
+        return ACK_HEADER_SIZE + count * ACK_RANGE_SIZE;
+    }
+
+    // ---- 确认与丢包 ----
+
+    void onAck(const uint8_t* data, size_t length, int64_t now) {
+        uint64_t maxData = readUint64(data + COMMON_HEADER_SIZE);
+        uint32_t ackDelay = readUint32(data + COMMON_HEADER_SIZE + 8);
+        size_t count = readUint16(data + COMMON_HEADER_SIZE + 12);
+        if (length < ACK_HEADER_SIZE + count * ACK_RANGE_SIZE) {
+            return;
+        }
+        const uint8_t* ranges = data + ACK_HEADER_SIZE;
+        uint64_t largest = count > 0 ? readUint64(ranges + 8) : 0;
+        if (count > 0 && largest >= nextPn_) {
+            return;
+        }
+        peerMaxData_ = std::max(peerMaxData_, maxData);
+
+        uint64_t newlyAcked = 0;
+        bool ackedAny = false;
+        int64_t largestSentTime = -1;
+        const SentPacket* rateSample = nullptr;
+        for (size_t i = 0; i < count; i++) {
+            uint64_t first = std::max(readUint64(ranges + i * ACK_RANGE_SIZE), sentBasePn_);
+            uint64_t last = readUint64(ranges + i * ACK_RANGE_SIZE + 8);
+            if (last >= nextPn_) {
+                continue;
+            }
+            for (uint64_t packetNumber = first; packetNumber <= last; packetNumber++) {
+                SentPacket& packet = sent_[static_cast<size_t>(packetNumber - sentBasePn_)];
+                if (packet.state == ACKED) {
+                    continue;
+                }
+                // 已判定丢失却又被确认的包（误判）：数据已经送达，不必再重传
+                if (packet.state == IN_FLIGHT) {
+                    bytesInFlight_ -= packet.length;
+                    packetsInFlight_--;
+                    newlyAcked += packet.length;
+                }
+                packet.state = ACKED;
+                ackedAny = true;
+                markAcked(packet.offset, packet.length);
+                delivered_ += packet.length;
+                deliveredTime_ = now;
+                if (!rateSample || packet.sentTime >= rateSample->sentTime) {
+                    rateSample = &packet;
+                }
+                if (packetNumber == largest) {
+                    largestSentTime = packet.sentTime;
+                }
+            }
+        }
+
+        if (ackedAny) {
+            timeouts_ = 0;
+            probes_ = 0;
+            lastProgress_ = now;
+        }
+        if (count > 0 && (!hasLargestAcked_ || largest > largestAcked_)) {
+            hasLargestAcked_ = true;
+            largestAcked_ = largest;
+        }
+        uint32_t rttSample = 0;
+        if (largestSentTime >= 0) {
+            rttSample = updateRtt(static_cast<uint64_t>(now - largestSentTime), ackDelay);
+        }
+        if (rateSample) {
+            // 投递速率：这段时间内确认的字节数除以 max(确认间隔, 发送间隔)，发送方自身的空闲不会拉低估计
+            int64_t interval = std::max(now - rateSample->deliveredTime,
+                                        rateSample->sentTime - rateSample->firstSentTime);
+            if (interval > 0) {
+                deliveryRate_ = (delivered_ - rateSample->delivered) * 1000000 / static_cast<uint64_t>(interval);
+            }
+        }
+
+        detectLosses(now);
+        popSent();
+        if (newlyAcked > 0) {
+            controller_->onAck({newlyAcked, bytesInFlight_, rttSample, deliveryRate_, now});
+        }
+        checkDrained();
+    }
+
+    // 确认推进了发送缓冲区的起点时释放空间
+    void markAcked(uint64_t offset, uint32_t length) {
+        uint64_t end = offset + length;
+        if (length == 0 || end <= sendBase_) {
+            return;
+        }
+        if (offset > sendBase_) {
+            insertRange(ackedOffsets_, offset, end);
+            return;
+        }
+        sendBase_ = end;
+        while (!ackedOffsets_.empty() && ackedOffsets_.begin()->first <= sendBase_) {
+            sendBase_ = std::max(sendBase_, ackedOffsets_.begin()->second);
+            ackedOffsets_.erase(ackedOffsets_.begin());
+        }
+        writeEvent_ = true;
+    }
+
+    bool isAcked(uint64_t start, uint64_t end) const {
+        if (end <= sendBase_) {
+            return true;
+        }
+        auto it = ackedOffsets_.upper_bound(start);
+        if (it == ackedOffsets_.begin()) {
+            return false;
+        }
+        return std::prev(it)->second >= end;
+    }
+
+    // Jacobson/Karels：SRTT 与 RTTVAR 按 1/8、1/4 平滑，RTO = SRTT + 4 * RTTVAR
+    uint32_t updateRtt(uint64_t sample, uint32_t ackDelay) {
+        latestRtt_ = sample;
+        if (minRtt_ == 0 || sample < minRtt_) {
+            minRtt_ = sample;
+        }
+        // 扣除对端的确认延迟，但不低于最小 RTT
+        if (sample > minRtt_ + ackDelay) {
+            sample -= ackDelay;
+        }
+        if (srtt_ == 0) {
+            srtt_ = sample;
+            rttvar_ = sample / 2;
+        } else {
+            uint64_t deviation = srtt_ > sample ? srtt_ - sample : sample - srtt_;
+            rttvar_ = (3 * rttvar_ + deviation) / 4;
+            srtt_ = (7 * srtt_ + sample) / 8;
+        }
+        uint64_t rto = srtt_ + std::max<uint64_t>(TIMER_GRANULARITY_MICROS, 4 * rttvar_);
+        rto_ = std::min<uint64_t>(std::max<uint64_t>(rto, config_.minRtoMicros), config_.maxRtoMicros);
+        return static_cast<uint32_t>(std::min<uint64_t>(sample, UINT32_MAX));
+    }
+
+    // 探测间隔 = SRTT + 4 * RTTVAR（不设 RTO 那样的下限），每次探测后加倍
+    int64_t probeTimeout() const {
+        if (srtt_ == 0) {
+            return currentRto();
+        }
+        uint64_t timeout = srtt_ + std::max<uint64_t>(TIMER_GRANULARITY_MICROS, 4 * rttvar_);
+        return static_cast<int64_t>(std::min<uint64_t>(timeout << probes_, config_.maxRtoMicros));
+    }
+
+    int64_t currentRto() const {
+        return static_cast<int64_t>(std::min<uint64_t>(rto_ << std::min(timeouts_, 30u), config_.maxRtoMicros));
+    }
+
+    void detectLosses(int64_t now) {
+        lossTime_ = 0;
+        if (!hasLargestAcked_) {
+            return;
+        }
+        uint64_t rtt = std::max(srtt_, latestRtt_);
+        int64_t lossDelay = std::max<int64_t>(static_cast<int64_t>(rtt * 9 / 8), TIMER_GRANULARITY_MICROS);
+
+        uint64_t lost = 0;
+        bool congestion = false;
+        for (uint64_t packetNumber = sentBasePn_; packetNumber < largestAcked_; packetNumber++) {
+            SentPacket& packet = sent_[static_cast<size_t>(packetNumber - sentBasePn_)];
+            if (packet.state != IN_FLIGHT) {
+                continue;
+            }
+            if (largestAcked_ - packetNumber >= PACKET_THRESHOLD || packet.sentTime + lossDelay <= now) {
+                markLost(packet);
+                lost += packet.length;
+                // 同一个恢复期内（在上一次拥塞事件之前发出的包）的丢失只让控制器响应一次
+                congestion = congestion || packet.sentTime > recoveryStart_;
+            } else if (lossTime_ == 0 || packet.sentTime + lossDelay < lossTime_) {
+                lossTime_ = packet.sentTime + lossDelay;
+            }
+        }
+        if (lost > 0 && congestion) {
+            recoveryStart_ = now;
+            controller_->onLoss({lost, bytesInFlight_, false, now});
+        }
+    }
+
+    void markLost(SentPacket& packet) {
+        packet.state = LOST;
+        bytesInFlight_ -= packet.length;
+        packetsInFlight_--;
+        if (packet.length > 0) {
+            retransmits_.emplace_back(packet.offset, packet.length);
+            retransmitCount_++;
+        }
+    }
+
+    void popSent() {
+        while (!sent_.empty() && sent_.front().state != IN_FLIGHT) {
+            sent_.pop_front();
+            sentBasePn_++;
+        }
+    }
+
+    // 重传超时：所有在途的包都视为丢失，超时间隔指数退避，连续超时过多时连接失败
+    void onTimeout(int64_t now) {
+        if (++timeouts_ > config_.maxTimeouts) {
+            fail();
+            return;
+        }
+        uint64_t lost = 0;
+        for (SentPacket& packet : sent_) {
+            if (packet.state == IN_FLIGHT) {
+                markLost(packet);
+                lost += packet.length;
+            }
+        }
+        popSent();
+        if (lost > 0) {
+            recoveryStart_ = now;
+            controller_->onLoss({lost, 0, true, now});
+        }
+        probes_ = 0;
+        lastProgress_ = now;
+    }
+
+    // 把最后一个在途包当作丢失重发（不算拥塞信号），原来的包之后被确认时照常处理
+    void sendTailProbe() {
+        for (auto it = sent_.rbegin(); it != sent_.rend(); ++it) {
+            if (it->state == IN_FLIGHT) {
+                markLost(*it);
+                break;
+            }
+        }
+        probes_++;
+        popSent();
+    }
+
+    // ---- 发送 ----
+
+    bool flowBlocked() const {
+        return retransmits_.empty() && sendNext_ < sendEnd_ && sendNext_ >= peerMaxData_;
+    }
+
+    // 下一段要发送的数据：先重传丢失的部分，再发送新数据（受对端窗口限制）
+    bool nextSegment(uint64_t& offset, size_t& length, bool& retransmission) {
+        while (!retransmits_.empty()) {
+            uint64_t start = std::max(retransmits_.front().first, sendBase_);
+            uint64_t end = retransmits_.front().first + retransmits_.front().second;
+            if (start >= end || isAcked(start, end)) {
+                retransmits_.pop_front();
+                continue;
+            }
+            offset = start;
+            length = static_cast<size_t>(end - start);
+            retransmission = true;
+            return true;
+        }
+        uint64_t limit = std::min(sendEnd_, peerMaxData_);
+        if (sendNext_ < limit) {
+            offset = sendNext_;
+            length = static_cast<size_t>(std::min<uint64_t>(limit - sendNext_, payloadSize_));
+            retransmission = false;
+            return true;
+        }
+        return false;
+    }
+
+    void updatePacing() {
+        uint64_t rate = controller_->getPacingRate();
+        if (rate == 0 && srtt_ > 0) {
+            rate = static_cast<uint64_t>(controller_->getCongestionWindow() * PACING_GAIN * 1e6 / srtt_);
+        }
+        pacer_.setRate(rate);
+        pacer_.setBurst(std::max<uint64_t>(rate * PACING_BURST_MICROS / 1000000,
+                                           MIN_PACING_BURST_PACKETS * config_.maxDatagramSize));
+    }
+
+    static std::vector<uint8_t>& scratch() {
+        static thread_local std::vector<uint8_t> buffer;
+        return buffer;
+    }
+
+    // 写出一个数据包并记入发送历史
+    size_t writeData(uint8_t* out, uint64_t offset, size_t length, int64_t now) {
+        uint64_t packetNumber = nextPn_++;
+        if (packetsInFlight_ == 0) {
+            // 从空闲开始发送：重新计算投递速率的区间，重传计时也从现在开始
+            firstSentTime_ = now;
+            deliveredTime_ = now;
+            lastProgress_ = now;
+        }
+        writeHeader(out, PACKET_DATA, id_);
+        writeUint64(out + COMMON_HEADER_SIZE, packetNumber);
+        writeUint64(out + COMMON_HEADER_SIZE + 8, offset);
+        writeUint32(out + COMMON_HEADER_SIZE + 16,
+                    static_cast<uint32_t>(std::min<uint64_t>(packetNumber - sentBasePn_, UINT32_MAX)));
+        copyFromRing(sendRing_.get(), sendCapacity_ - 1, offset, out + DATA_HEADER_SIZE, length);
+
+        sent_.push_back({offset, static_cast<uint32_t>(length), IN_FLIGHT, now, delivered_, deliveredTime_,
+                         firstSentTime_});
+        bytesInFlight_ += length;
+        packetsInFlight_++;
+        return DATA_HEADER_SIZE + length;
+    }
+
+    // 在拥塞窗口、发送节拍和对端窗口允许的范围内发送，每批最多 SEND_BATCH 个包
+    void transmit(int64_t now) {
+        if (!isActive() || phase_ == Phase::CONNECTING) {
+            return;
+        }
+        updatePacing();
+        size_t stride = config_.maxDatagramSize;
+        std::vector<uint8_t>& buffer = scratch();
+        if (buffer.size() < SEND_BATCH * stride) {
+            buffer.resize(SEND_BATCH * stride);
+        }
+
+        while (true) {
+            size_t lengths[SEND_BATCH];
+            size_t count = 0;
+            uint64_t window = controller_->getCongestionWindow();
+            uint64_t offset;
+            size_t length;
+            bool retransmission;
+            while (count < SEND_BATCH && nextSegment(offset, length, retransmission)) {
+                if (bytesInFlight_ > 0 && bytesInFlight_ + length > window) {
+                    break;
+                }
+                if (pacer_.available(now) < DATA_HEADER_SIZE + length) {
+                    pacingDeadline_ = now + std::max<int64_t>(pacer_.delayFor(DATA_HEADER_SIZE + length, now), 1);
+                    break;
+                }
+                if (retransmission) {
+                    retransmits_.pop_front();
+                } else {
+                    sendNext_ += length;
+                }
+                lengths[count] = writeData(buffer.data() + count * stride, offset, length, now);
+                pacer_.consume(lengths[count]);
+                count++;
+            }
+            if (count == 0) {
+                return;
+            }
+
+            size_t sent = endpoint_->sendPackets(buffer.data(), lengths, count, stride, peer_);
+            if (sent < count) {
+                requeueUnsent(count - sent);
+                retryDeadline_ = now + SEND_RETRY_MICROS;
+                return;
+            }
+            if (count < SEND_BATCH) {
+                return;
+            }
+        }
+    }
+
+    // 内核没有接收的包（本地缓冲区已满）：不算作网络丢包，放回重传队列稍后再发
+    void requeueUnsent(size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            SentPacket& packet = sent_[sent_.size() - 1 - i];
+            packet.state = LOST;
+            bytesInFlight_ -= packet.length;
+            packetsInFlight_--;
+            if (packet.length > 0) {
+                retransmits_.emplace_front(packet.offset, packet.length);
+            }
+        }
+        popSent();
+    }
+
+    // 对端窗口已满且没有在途包时发一个零长度的探测包，对端的确认带回最新的窗口，窗口更新丢失也不会停滞
+    void sendProbe(int64_t now) {
+        std::vector<uint8_t>& buffer = scratch();
+        if (buffer.size() < DATA_HEADER_SIZE) {
+            buffer.resize(DATA_HEADER_SIZE);
+        }
+        size_t length = writeData(buffer.data(), sendNext_, 0, now);
+        if (endpoint_->sendPackets(buffer.data(), &length, 1, length, peer_) == 0) {
+            requeueUnsent(1);
+        }
+    }
+
+    // ---- 定时器 ----
+
+    // 握手时还没有 RTT 样本，关闭时按当前的 RTO
+    int64_t handshakeTimeout() const {
+        uint64_t base = phase_ == Phase::CONNECTING ? config_.initialRtoMicros : rto_;
+        return static_cast<int64_t>(std::min<uint64_t>(base << (handshakeAttempts_ - 1), config_.maxRtoMicros));
+    }
+
+    // 对端已有三分之一个空闲超时没有消息时发一个确认作为保活，双方各自如此，空闲但存活的连接不会超时
+    int64_t keepaliveDeadline() const {
+        return std::max(lastReceived_, lastKeepalive_) + config_.idleTimeoutMicros / 3;
+    }
+
+    // 取握手重传、丢包判定、重传超时、窗口探测、发送节拍、保活与空闲超时中最早的时刻；已有的定时器更早时沿用它
+    void updateTimer(int64_t now) {
+        if (!isActive()) {
+            return;
+        }
+        int64_t deadline = 0;
+        auto consider = [&deadline](int64_t time) {
+            if (time > 0 && (deadline == 0 || time < deadline)) {
+                deadline = time;
+            }
+        };
+        if (phase_ == Phase::CONNECTING || (phase_ == Phase::CLOSING && handshakeAttempts_ > 0)) {
+            consider(handshakeSentTime_ + handshakeTimeout());
+        } else {
+            consider(lossTime_);
+            if (packetsInFlight_ > 0 || flowBlocked()) {
+                consider(lastProgress_ + currentRto());
+            }
+            if (packetsInFlight_ > 0 && probes_ < MAX_TAIL_PROBES) {
+                consider(lastProgress_ + probeTimeout());
+            }
+            consider(pacingDeadline_);
+            consider(retryDeadline_);
+            if (config_.idleTimeoutMicros > 0) {
+                consider(lastReceived_ + config_.idleTimeoutMicros);
+                consider(keepaliveDeadline());
+            }
+        }
+        if (deadline == 0 || (timerDeadline_ != 0 && timerDeadline_ <= deadline)) {
+            return;
+        }
+
+        if (timerDeadline_ != 0) {
+            endpoint_->loop->cancelTimer(timerId_);
+        }
+        timerDeadline_ = deadline;
+        uint64_t generation = ++timerGeneration_;
+        std::weak_ptr<Connection> weakSelf = shared_from_this();
+        timerId_ = endpoint_->loop->runAfter(std::max<int64_t>(deadline - now, 0), [weakSelf, generation] {
+            if (auto self = weakSelf.lock()) {
+                self->onTimer(generation);
+            }
+        });
+    }
+
+    void onTimer(uint64_t generation) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        // 已被取消或替换的定时器仍可能执行
+        if (generation != timerGeneration_) {
+            return;
+        }
+        timerDeadline_ = 0;
+        int64_t now = nowMicros();
+
+        if (isActive() && phase_ == Phase::CONNECTING) {
+            if (now >= handshakeSentTime_ + handshakeTimeout()) {
+                if (handshakeAttempts_ >= MAX_HANDSHAKE_ATTEMPTS) {
+                    fail();
+                } else {
+                    handshakeAttempts_++;
+                    handshakeSentTime_ = now;
+                    sendHandshake(PACKET_SYN);
+                }
+            }
+        } else if (isActive() && phase_ == Phase::CLOSING && handshakeAttempts_ > 0) {
+            if (now >= handshakeSentTime_ + handshakeTimeout()) {
+                if (handshakeAttempts_ >= MAX_HANDSHAKE_ATTEMPTS) {
+                    // 对端没有回应（可能早已释放连接，只是回复丢了），不再等待
+                    phase_ = Phase::CLOSED;
+                    detach_ = true;
+                } else {
+                    handshakeAttempts_++;
+                    handshakeSentTime_ = now;
+                    sendControl(PACKET_CLOSE);
+                }
+            }
+        } else if (isActive()) {
+            if (config_.idleTimeoutMicros > 0) {
+                if (now >= lastReceived_ + config_.idleTimeoutMicros) {
+                    // 对端消失（崩溃、断网）且没有数据在途时，没有别的机制能发现并回收连接
+                    fail();
+                    finish(lock, true);
+                    return;
+                }
+                if (now >= keepaliveDeadline()) {
+                    uint8_t ack[MAX_ACK_SIZE];
+                    endpoint_->sendPacket(ack, buildAck(ack, now), peer_);
+                    lastKeepalive_ = now;
+                }
+            }
+            if (lossTime_ > 0 && now >= lossTime_) {
+                detectLosses(now);
+                popSent();
+            }
+            if (packetsInFlight_ > 0 && now >= lastProgress_ + currentRto()) {
+                onTimeout(now);
+            } else if (packetsInFlight_ > 0 && probes_ < MAX_TAIL_PROBES && now >= lastProgress_ + probeTimeout()) {
+                sendTailProbe();
+            }
+            if (isActive()) {
+                pacingDeadline_ = 0;
+                retryDeadline_ = 0;
+                transmit(now);
+                if (packetsInFlight_ == 0 && flowBlocked() && now >= lastProgress_ + currentRto()) {
+                    sendProbe(now);
+                }
+            }
+        }
+        updateTimer(now);
+        finish(lock, true);
+    }
+
+    const std::shared_ptr<Endpoint> endpoint_;
+    const sockaddr_in peer_;
+    const uint32_t id_;
+    const UdpBackend::Config config_;
+    const size_t payloadSize_;
+    const std::shared_ptr<Readiness> ready_;
+
+    std::mutex mutex_;
+    Phase phase_;
+    bool peerClosed_;
+    bool failed_;
+    bool readEvent_;            // 解锁后要发出的可读/可写边缘
+    bool writeEvent_;
+    bool detach_;               // 连接已结束，解锁后从端点移除
+    bool detached_;
+
+    // 发送：[sendBase_, sendEnd_) 是尚未全部确认的数据，sendNext_ 之前的数据至少发送过一次
+    const size_t sendCapacity_;
+    std::unique_ptr<uint8_t[]> sendRing_;
+    uint64_t sendBase_;
+    uint64_t sendNext_;
+    uint64_t sendEnd_;
+    uint64_t peerMaxData_;
+    std::map<uint64_t, uint64_t> ackedOffsets_;             // sendBase_ 之后已确认的流区间
+    std::deque<std::pair<uint64_t, uint32_t>> retransmits_; // 待重传的 (流偏移, 长度)
+    std::deque<SentPacket> sent_;                           // 下标为 包序号 - sentBasePn_
+    uint64_t sentBasePn_;
+    uint64_t nextPn_;
+    bool hasLargestAcked_;
+    uint64_t largestAcked_;
+    uint64_t bytesInFlight_;
+    uint64_t packetsInFlight_;
+    uint64_t delivered_;
+    int64_t deliveredTime_;
+    int64_t firstSentTime_;
+    uint64_t deliveryRate_;
+    uint32_t retransmitCount_;
+    std::unique_ptr<CongestionController> controller_;
+    Pacer pacer_;
+    int64_t recoveryStart_;
+
+    // RTT 与超时（微秒）
+    uint64_t srtt_;
+    uint64_t rttvar_;
+    uint64_t latestRtt_;
+    uint64_t minRtt_;
+    uint64_t rto_;
+    unsigned timeouts_;
+    unsigned probes_;           // 本轮已发出的尾部探测数，收到新确认时清零
+    int64_t lastProgress_;      // 最近一次收到新确认（或从空闲开始发送）的时刻，重传超时由此计时
+    int64_t lossTime_;          // 按时间阈值判定丢包的时刻
+    int64_t pacingDeadline_;
+    int64_t retryDeadline_;
+    int64_t lastReceived_;      // 最近一次收到对端任何数据包的时刻，空闲超时由此计时
+    int64_t lastKeepalive_;
+
+    // 接收：[readOffset_, receivedEnd_) 是按序到达、尚未被应用读取的数据
+    const size_t receiveCapacity_;
+    std::unique_ptr<uint8_t[]> receiveRing_;
+    uint64_t readOffset_;
+    uint64_t receivedEnd_;
+    std::map<uint64_t, uint64_t> outOfOrder_;               // receivedEnd_ 之后已到达的流区间
+    std::vector<std::pair<uint64_t, uint64_t>> receivedPackets_;  // 收到的包序号区间（闭区间，升序）
+    uint64_t advertisedMaxData_;
+    bool ackPending_;
+    int64_t ackPendingSince_;
+    bool synAckPending_;
+
+    unsigned handshakeAttempts_;
+    int64_t handshakeSentTime_;
+    EventLoop::TimerId timerId_;
+    int64_t timerDeadline_;
+    uint64_t timerGeneration_;
+};
+
+Endpoint::~Endpoint() {
+    if (fd >= 0) {
+        loop->removeFd(fd);
+        ::close(fd);
+    }
+}
+
+std::shared_ptr<Endpoint> Endpoint::open(const std::shared_ptr<EventLoop>& loop, const UdpBackend::Config& config,
+                                         const sockaddr_in& address, bool server) {
+    int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+    if (fd < 0) {
+        return nullptr;
+    }
+    auto endpoint = std::make_shared<Endpoint>();
+    endpoint->loop = loop;
+    endpoint->config = config;
+    endpoint->fd = fd;
+    endpoint->server = server;
+    endpoint->gso = config.gso;
+
+    // 突发的确认和数据包不至于在本地缓冲区溢出；超过系统上限时内核自动截断
+    int bufferSize = static_cast<int>(std::min<size_t>(config.socketBufferSize, INT_MAX / 2));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &bufferSize, sizeof(bufferSize));
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+
+    const sockaddr* raw = reinterpret_cast<const sockaddr*>(&address);
+    if (server) {
+        int one = 1;
+        if (::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0 ||
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0 ||
+            ::bind(fd, raw, sizeof(address)) < 0) {
+            return nullptr;
+        }
+    } else {
+        // 已连接的 UDP 套接字只接收该对端的数据包，发送时也不必再给出地址
+        if (::connect(fd, raw, sizeof(address)) < 0) {
+            return nullptr;
+        }
+        endpoint->peer = address;
+    }
+
+    std::weak_ptr<Endpoint> weakEndpoint = endpoint;
+    if (!loop->addFd(fd, EPOLLIN | EPOLLET, [weakEndpoint](uint32_t) {
+            if (auto endpoint = weakEndpoint.lock()) {
+                endpoint->onReadable();
+            }
+        })) {
+        return nullptr;
+    }
+    return endpoint;
+}
+
+// 边缘触发：每次就绪都用 recvmmsg 把数据包全部取走，每批处理完再统一确认和发送
+void Endpoint::onReadable() {
+    size_t slot = config.maxDatagramSize;
+    if (receiveBuffers.size() < RECEIVE_BATCH * slot) {
+        receiveBuffers.resize(RECEIVE_BATCH * slot);
+    }
+
+    mmsghdr messages[RECEIVE_BATCH];
+    iovec iov[RECEIVE_BATCH];
+    sockaddr_in from[RECEIVE_BATCH];
+    while (true) {
+        for (size_t i = 0; i < RECEIVE_BATCH; i++) {
+            iov[i].iov_base = receiveBuffers.data() + i * slot;
+            iov[i].iov_len = slot;
+            std::memset(&messages[i].msg_hdr, 0, sizeof(msghdr));
+            messages[i].msg_hdr.msg_iov = &iov[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+            if (server) {
+                messages[i].msg_hdr.msg_name = &from[i];
+                messages[i].msg_hdr.msg_namelen = sizeof(from[i]);
+            }
+        }
+
+        int received = ::recvmmsg(fd, messages, RECEIVE_BATCH, MSG_DONTWAIT, nullptr);
+        if (received < 0) {
+            // 已连接的套接字会在这里报告之前发送引起的 ICMP 错误（对端端口未打开等），由重传超时处理
+            if (errno == EINTR || errno == ECONNREFUSED) {
+                continue;
+            }
+            break;
+        }
+        if (received == 0) {
+            break;
+        }
+
+        int64_t now = nowMicros();
+        for (int i = 0; i < received; i++) {
+            // 超过最大数据报的包被截断，不可能是本协议的包
+            if (messages[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                continue;
+            }
+            dispatch(receiveBuffers.data() + i * slot, messages[i].msg_len, server ? from[i] : peer, now);
+        }
+        for (auto& connection : batch) {
+            connection->afterBatch(now, acks);
+        }
+        batch.clear();
+        flushAcks();
+    }
+}
+
+void Endpoint::dispatch(const uint8_t* data, size_t length, const sockaddr_in& from, int64_t now) {
+    if (length < COMMON_HEADER_SIZE) {
+        return;
+    }
+    uint8_t type = data[0];
+    uint32_t id = readUint32(data + 4);
+
+    std::shared_ptr<Connection> connection;
+    std::shared_ptr<Connection> replaced;
+    std::shared_ptr<Connection> probed;
+    UdpBackend::AcceptHandler handler;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = connections.find(peerKey(from));
+        if (it != connections.end() && it->second->id() == id) {
+            connection = it->second;
+        } else if (type == PACKET_SYN && length >= HANDSHAKE_SIZE && acceptHandler) {
+            if (it != connections.end() && !it->second->isFinished()) {
+                // 现有连接仍然存活，只探测对端，由对端用旧编号的 CLOSE 证明它已重启
+                probed = it->second;
+            } else {
+                if (it != connections.end()) {
+                    replaced = std::move(it->second);
+                    connections.erase(it);
+                }
+                connection = std::make_shared<Connection>(shared_from_this(), from, id);
+                connections.emplace(peerKey(from), connection);
+                handler = acceptHandler;
+            }
+        }
+    }
+
+    if (probed) {
+        probed->probePeer();
+        if (!probed->inBatch) {
+            probed->inBatch = true;
+            batch.push_back(std::move(probed));
+        }
+        return;
+    }
+    if (replaced) {
+        replaced->onReplaced();
+    }
+    if (!connection) {
+        // 不认识的连接（已关闭、对端重启或服务端不再接受连接），让对端尽快放弃
+        if (type != PACKET_CLOSE) {
+            uint8_t packet[COMMON_HEADER_SIZE];
+            writeHeader(packet, PACKET_CLOSE, id);
+            sendPacket(packet, sizeof(packet), from);
+        }
+        return;
+    }
+    if (handler) {
+        connection->accept(data);
+        handler(createAcceptedSocket(loop, config, connection));
+        return;
+    }
+
+    connection->onPacket(data, length, now);
+    if (!connection->inBatch) {
+        connection->inBatch = true;
+        batch.push_back(std::move(connection));
+    }
+}
+
+void Endpoint::flushAcks() {
+    if (acks.count == 0) {
+        return;
+    }
+    mmsghdr messages[RECEIVE_BATCH];
+    iovec iov[RECEIVE_BATCH];
+    for (size_t i = 0; i < acks.count; i++) {
+        iov[i].iov_base = acks.bytes[i];
+        iov[i].iov_len = acks.lengths[i];
+        std::memset(&messages[i].msg_hdr, 0, sizeof(msghdr));
+        messages[i].msg_hdr.msg_iov = &iov[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+        if (server) {
+            messages[i].msg_hdr.msg_name = &acks.peers[i];
+            messages[i].msg_hdr.msg_namelen = sizeof(acks.peers[i]);
+        }
+    }
+    size_t sent = 0;
+    while (sent < acks.count) {
+        int result = ::sendmmsg(fd, messages + sent, static_cast<unsigned>(acks.count - sent), 0);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        // 确认丢了由下一次确认或对端的超时补上
+        if (result <= 0) {
+            break;
+        }
+        sent += static_cast<size_t>(result);
+    }
+    acks.count = 0;
+}
+
+// 连续的满长包（最后一个可以更短）合并为一条带 UDP_SEGMENT 的消息，内核按段长切分，一次穿过协议栈；
+// 所有消息再用一次 sendmmsg 发出
+size_t Endpoint::sendPackets(const uint8_t* packets, const size_t* lengths, size_t count, size_t stride,
+                             const sockaddr_in& to) {
+    mmsghdr messages[SEND_BATCH];
+    iovec iov[SEND_BATCH];
+    alignas(cmsghdr) uint8_t control[SEND_BATCH][CMSG_SPACE(sizeof(uint16_t))];
+    size_t segments[SEND_BATCH];
+    bool useGso = gso.load();
+
+    size_t groups = 0;
+    size_t i = 0;
+    while (i < count) {
+        size_t start = i;
+        size_t bytes = lengths[i++];
+        if (useGso && bytes == stride) {
+            while (i < count && i - start < MAX_GSO_SEGMENTS && bytes + lengths[i] <= MAX_GSO_BYTES) {
+                bytes += lengths[i++];
+                if (lengths[i - 1] < stride) {
+                    break;
+                }
+            }
+        }
+
+        msghdr& header = messages[groups].msg_hdr;
+        std::memset(&header, 0, sizeof(header));
+        iov[groups].iov_base = const_cast<uint8_t*>(packets + start * stride);
+        iov[groups].iov_len = bytes;
+        header.msg_iov = &iov[groups];
+        header.msg_iovlen = 1;
+        if (server) {
+            header.msg_name = const_cast<sockaddr_in*>(&to);
+            header.msg_namelen = sizeof(to);
+        }
+        if (i - start > 1) {
+            header.msg_control = control[groups];
+            header.msg_controllen = sizeof(control[groups]);
+            cmsghdr* cmsg = CMSG_FIRSTHDR(&header);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            uint16_t segmentSize = static_cast<uint16_t>(stride);
+            std::memcpy(CMSG_DATA(cmsg), &segmentSize, sizeof(segmentSize));
+        }
+        segments[groups++] = i - start;
+    }
+
+    size_t sentGroups = 0;
+    size_t sentPackets = 0;
+    while (sentGroups < groups) {
+        int result = ::sendmmsg(fd, messages + sentGroups, static_cast<unsigned>(groups - sentGroups), 0);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (useGso && (errno == EIO || errno == EINVAL || errno == EOPNOTSUPP || errno == ENOPROTOOPT)) {
+                // 内核或网卡不支持 GSO（例如没有校验和卸载），以后逐包发送
+                gso = false;
+                return sentPackets + sendPackets(packets + sentPackets * stride, lengths + sentPackets,
+                                                 count - sentPackets, stride, to);
+            }
+            break;
+        }
+        for (int g = 0; g < result; g++) {
+            sentPackets += segments[sentGroups + g];
+        }
+        sentGroups += static_cast<size_t>(result);
+    }
+    return sentPackets;
+}
+
+void Endpoint::sendPacket(const uint8_t* data, size_t length, const sockaddr_in& to) {
+    if (server) {
+        ::sendto(fd, data, length, 0, reinterpret_cast<const sockaddr*>(&to), sizeof(to));
+    } else {
+        ::send(fd, data, length, 0);
+    }
+}
+
+void Endpoint::add(const std::shared_ptr<Connection>& connection, const sockaddr_in& address) {
+    std::lock_guard<std::mutex> lock(mutex);
+    connections[peerKey(address)] = connection;
+}
+
+void Endpoint::remove(const sockaddr_in& address, const Connection* connection) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = connections.find(peerKey(address));
+    if (it != connections.end() && it->second.get() == connection) {
+        connections.erase(it);
+    }
+}
+
+void Endpoint::abortAll() {
+    std::unordered_map<uint64_t, std::shared_ptr<Connection>> closing;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        acceptHandler = nullptr;
+        closing.swap(connections);
+    }
+    for (auto& entry : closing) {
+        entry.second->abort();
+    }
+}
+
+class UdpSocket : public TransportSocket {
+public:
+    UdpSocket(std::shared_ptr<EventLoop> loop, const UdpBackend::Config& config,
+              std::shared_ptr<Connection> connection = nullptr)
+        : loop_(std::move(loop))
+        , config_(config)
+        , connection_(std::move(connection))
+        , state_(connection_ ? connection_->readiness() : std::make_shared<Readiness>())
+        , blockedReadEpoch_(0)
+        , blockedWriteEpoch_(0)
+    {
+    }
+
+    ~UdpSocket() override {
+        close();
+    }
+
+    bool connect(const std::string& host, uint16_t port, int timeoutMs) override {
+        close();
+
+        sockaddr_in serverAddr{};
+        serverAddr.sin_family = AF_INET;
+        serverAddr.sin_port = htons(port);
+        if (inet_pton(AF_INET, host.c_str(), &serverAddr.sin_addr) != 1) {
+            return false;
+        }
+        auto endpoint = Endpoint::open(loop_, config_, serverAddr, false);
+        if (!endpoint) {
+            return false;
+        }
+
+        auto connection = std::make_shared<Connection>(endpoint, serverAddr, randomConnectionId());
+        endpoint->add(connection, serverAddr);
+        attach(connection);
+        connection->startConnect();
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (true) {
+            uint64_t epoch = state_->writeEpoch.load();
+            Connection::ConnectResult result = connection_->connectResult();
+            if (result == Connection::ConnectResult::CONNECTED) {
+                return true;
+            }
+            int wait = -1;
+            if (timeoutMs >= 0) {
+                auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - std::chrono::steady_clock::now());
+                wait = static_cast<int>(std::max<int64_t>(remaining.count(), 0));
+            }
+            if (result == Connection::ConnectResult::FAILED || wait == 0 ||
+                !state_->waitChange(state_->writeEpoch, epoch, wait)) {
+                close();
+                return false;
+            }
+        }
+    }
+
+    IoResult send(const void* data, size_t length) override {
+        IoVec vec{const_cast<void*>(data), length};
+        return sendv(&vec, 1);
+    }
+
+    IoResult receive(void* buffer, size_t length) override {
+        IoVec vec{buffer, length};
+        return receivev(&vec, 1);
+    }
+
+    // 先记录计数再检查缓冲区，避免错过检查之后到来的边缘
+    IoResult sendv(const IoVec* vecs, size_t count) override {
+        if (!connection_) {
+            return {IoStatus::CLOSED, 0};
+        }
+        uint64_t epoch = state_->writeEpoch.load();
+        IoResult result = connection_->send(vecs, count);
+        if (result.status == IoStatus::WOULD_BLOCK) {
+            blockedWriteEpoch_ = epoch;
+        }
+        return result;
+    }
+
+    IoResult receivev(const IoVec* vecs, size_t count) override {
+        if (!connection_) {
+            return {IoStatus::CLOSED, 0};
+        }
+        uint64_t epoch = state_->readEpoch.load();
+        IoResult result = connection_->receive(vecs, count);
+        if (result.status == IoStatus::WOULD_BLOCK) {
+            blockedReadEpoch_ = epoch;
+        }
+        return result;
+    }
+
+    bool waitReadable(int timeoutMs) override {
+        return connection_ && state_->waitChange(state_->readEpoch, blockedReadEpoch_, timeoutMs);
+    }
+
+    bool waitWritable(int timeoutMs) override {
+        return connection_ && state_->waitChange(state_->writeEpoch, blockedWriteEpoch_, timeoutMs);
+    }
+
+    bool getPathInfo(PathInfo& info) const override {
+        if (!connection_) {
+            return false;
+        }
+        connection_->fillPathInfo(info);
+        return true;
+    }
+
+    bool isPeerClosed() const override {
+        return connection_ && state_->peerClosed.load();
+    }
+
+    bool setReadyCallback(std::function<void()> callback) override {
+        readyCallback_ = callback ? std::make_shared<std::function<void()>>(std::move(callback)) : nullptr;
+        std::lock_guard<std::mutex> lock(state_->callbackMutex);
+        state_->onReady = readyCallback_;
+        return true;
+    }
+
+    bool controlsCongestion() const override {
+        return true;
+    }
+
+    void close() override {
+        if (!connection_) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(state_->callbackMutex);
+            state_->onReady = nullptr;
+        }
+        connection_->close();
+        connection_.reset();
+
+        state_->closed = true;
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->cond.notify_all();
+    }
+
+    bool isOpen() const override {
+        return connection_ != nullptr;
+    }
+
+private:
+    // 换用新连接的就绪状态，已注册的就绪回调随之转交
+    void attach(std::shared_ptr<Connection> connection) {
+        connection_ = std::move(connection);
+        state_ = connection_->readiness();
+        blockedReadEpoch_ = 0;
+        blockedWriteEpoch_ = 0;
+        std::lock_guard<std::mutex> lock(state_->callbackMutex);
+        state_->onReady = readyCallback_;
+    }
+
+    std::shared_ptr<EventLoop> loop_;
+    UdpBackend::Config config_;
+    std::shared_ptr<Connection> connection_;
+    std::shared_ptr<Readiness> state_;
+    uint64_t blockedReadEpoch_;
+    uint64_t blockedWriteEpoch_;
+    std::shared_ptr<std::function<void()>> readyCallback_;
+};
+
+std::unique_ptr<TransportSocket> createAcceptedSocket(const std::shared_ptr<EventLoop>& loop,
+                                                      const UdpBackend::Config& config,
+                                                      std::shared_ptr<Connection> connection) {
+    return std::unique_ptr<TransportSocket>(new UdpSocket(loop, config, std::move(connection)));
+}
+
+} // namespace
+
+struct UdpBackend::State {
+    std::shared_ptr<EventLoop> loop;
+    Config config;
+    std::mutex mutex;
+    std::shared_ptr<Endpoint> listener;
+    // 停止监听后仍被已接受的连接使用的监听端点，closeAccepted 时一并结束
+    std::vector<std::weak_ptr<Endpoint>> retired;
+};
+
+UdpBackend::UdpBackend(std::shared_ptr<EventLoop> loop)
+    : UdpBackend(Config(), std::move(loop))
+{
+}
+
+UdpBackend::UdpBackend(const Config& config, std::shared_ptr<EventLoop> loop)
+    : state(std::make_shared<State>())
+{
+    state->loop = loop ? std::move(loop) : EventLoop::getShared();
+    state->config = config;
+    Config& checked = state->config;
+    checked.maxDatagramSize = std::min(std::max(checked.maxDatagramSize, MIN_DATAGRAM_SIZE), MAX_DATAGRAM_SIZE);
+    // 缓冲区至少容纳若干个满长包，否则窗口连一个批次都装不下
+    size_t minBuffer = 16 * checked.maxDatagramSize;
+    checked.sendBufferSize = std::max(checked.sendBufferSize, minBuffer);
+    checked.receiveBufferSize = std::max(checked.receiveBufferSize, minBuffer);
+    checked.minRtoMicros = std::max<uint32_t>(checked.minRtoMicros, TIMER_GRANULARITY_MICROS);
+    checked.maxRtoMicros = std::max(checked.maxRtoMicros, checked.minRtoMicros);
+    checked.initialRtoMicros = std::min(std::max(checked.initialRtoMicros, checked.minRtoMicros),
+                                        checked.maxRtoMicros);
+}
+
+UdpBackend::~UdpBackend() {
+    stopListening();
+}
+
+std::unique_ptr<TransportSocket> UdpBackend::createSocket() {
+    return std::unique_ptr<TransportSocket>(new UdpSocket(state->loop, state->config));
+}
+
+const char* UdpBackend::name() const {
+    return "udp";
+}
+
+bool UdpBackend::runAfter(int64_t delayMicros, std::function<void()> task) {
+    if (delayMicros <= 0) {
+        state->loop->queueInLoop(std::move(task));
+        return true;
+    }
+    state->loop->runAfter(delayMicros, std::move(task));
+    return true;
+}
+
+std::shared_ptr<EventLoop> UdpBackend::getLoop() const {
+    return state->loop;
+}
+
+const UdpBackend::Config& UdpBackend::getConfig() const {
+    return state->config;
+}
+
+uint16_t UdpBackend::listen(const std::string& host, uint16_t port, AcceptHandler handler) {
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+        return 0;
+    }
+    auto endpoint = Endpoint::open(state->loop, state->config, address, true);
+    if (!endpoint) {
+        return 0;
+    }
+    socklen_t length = sizeof(address);
+    if (::getsockname(endpoint->fd, reinterpret_cast<sockaddr*>(&address), &length) < 0) {
+        return 0;
+    }
+    {
+        std::lock_guard<std::mutex> lock(endpoint->mutex);
+        endpoint->acceptHandler = std::move(handler);
+    }
+
+    stopListening();
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->listener = std::move(endpoint);
+    return ntohs(address.sin_port);
+}
+
+void UdpBackend::stopListening() {
+    std::shared_ptr<Endpoint> listener;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        listener = std::move(state->listener);
+    }
+    if (listener) {
+        // 套接字由已经接受的连接继续使用，最后一个连接结束后关闭
+        {
+            std::lock_guard<std::mutex> lock(listener->mutex);
+            listener->acceptHandler = nullptr;
+        }
+        std::lock_guard<std::mutex> lock(state->mutex);
+        auto expired = [](const std::weak_ptr<Endpoint>& endpoint) { return endpoint.expired(); };
+        state->retired.erase(std::remove_if(state->retired.begin(), state->retired.end(), expired),
+                             state->retired.end());
+        state->retired.push_back(listener);
+    }
+}
+
+void UdpBackend::closeAccepted() {
+    std::vector<std::shared_ptr<Endpoint>> endpoints;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->listener) {
+            endpoints.push_back(std::move(state->listener));
+        }
+        for (auto& weak : state->retired) {
+            if (auto endpoint = weak.lock()) {
+                endpoints.push_back(std::move(endpoint));
+            }
+        }
+        state->retired.clear();
+    }
+    for (auto& endpoint : endpoints) {
+        endpoint->abortAll();
+    }
+}
@@ -0,0 +1,212 @@
+#include "WinsockBackend.h"
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <stdexcept>
+
+#pragma comment(lib, "ws2_32.lib")
+
+namespace {
+
+// 使用 select 等待套接字就绪
+bool waitSocket(SOCKET sock, bool forWrite, int timeoutMs) {
+    fd_set fdset;
+    FD_ZERO(&fdset);
+    FD_SET(sock, &fdset);
+
+    timeval tv;
+    timeval* tvp = nullptr;
+    if (timeoutMs >= 0) {
+        tv.tv_sec = timeoutMs / 1000;
+        tv.tv_usec = (timeoutMs % 1000) * 1000;
+        tvp = &tv;
+    }
+
+    int result = forWrite ? select(0, nullptr, &fdset, nullptr, tvp)
+                          : select(0, &fdset, nullptr, nullptr, tvp);
+    return result == 1;
+}
+
+class WinsockSocket : public TransportSocket {
+public:
+    WinsockSocket()
+        : socket_(INVALID_SOCKET)
+    {
+    }
+
+    ~WinsockSocket() override {
+        close();
+    }
+
+    bool connect(const std::string& host, uint16_t port, int timeoutMs) override {
+        close();
+
+        sockaddr_in serverAddr;
+        serverAddr.sin_family = AF_INET;
+        serverAddr.sin_port = htons(port);
+        if (inet_pton(AF_INET, host.c_str(), &(serverAddr.sin_addr)) != 1) {
+            return false;
+        }
+
+        socket_ = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (socket_ == INVALID_SOCKET) {
+            return false;
+        }
+
+        // 设置非阻塞模式
+        u_long mode = 1;
+        ioctlsocket(socket_, FIONBIO, &mode);
+
+        if (::connect(socket_, (sockaddr*)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR) {
+            if (WSAGetLastError() != WSAEWOULDBLOCK || !waitSocket(socket_, true, timeoutMs)) {
+                close();
+                return false;
+            }
+
+            int error = 0;
+            int len = sizeof(error);
+            getsockopt(socket_, SOL_SOCKET, SO_ERROR, (char*)&error, &len);
+            if (error != 0) {
+                close();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    IoResult send(const void* data, size_t length) override {
+        if (socket_ == INVALID_SOCKET) {
+            return {IoStatus::CLOSED, 0};
+        }
+
+        int sent = ::send(socket_, (const char*)data, (int)length, 0);
+        if (sent != SOCKET_ERROR) {
+            return {IoStatus::OK, static_cast<size_t>(sent)};
+        }
+        int error = WSAGetLastError();
+        if (error == WSAEWOULDBLOCK) {
+            return {IoStatus::WOULD_BLOCK, 0};
+        }
+        return {error == WSAECONNRESET ? IoStatus::CLOSED : IoStatus::FAILED, 0};
+    }
+
+    IoResult receive(void* buffer, size_t length) override {
+        if (socket_ == INVALID_SOCKET) {
+            return {IoStatus::CLOSED, 0};
+        }
+
+        int received = recv(socket_, (char*)buffer, (int)length, 0);
+        if (received > 0) {
+            return {IoStatus::OK, static_cast<size_t>(received)};
+        }
+        if (received == 0) {
+            return {IoStatus::CLOSED, 0};
+        }
+        int error = WSAGetLastError();
+        if (error == WSAEWOULDBLOCK) {
+            return {IoStatus::WOULD_BLOCK, 0};
+        }
+        return {error == WSAECONNRESET ? IoStatus::CLOSED : IoStatus::FAILED, 0};
+    }
+
+    IoResult sendv(const IoVec* vecs, size_t count) override {
+        if (socket_ == INVALID_SOCKET) {
+            return {IoStatus::CLOSED, 0};
+        }
+
+        WSABUF buffers[MAX_IOV];
+        DWORD bufferCount = toWsaBuf(vecs, count, buffers);
+        DWORD sent = 0;
+        if (WSASend(socket_, buffers, bufferCount, &sent, 0, nullptr, nullptr) == 0) {
+            return {IoStatus::OK, static_cast<size_t>(sent)};
+        }
+        int error = WSAGetLastError();
+        if (error == WSAEWOULDBLOCK) {
+            return {IoStatus::WOULD_BLOCK, 0};
+        }
+        return {error == WSAECONNRESET ? IoStatus::CLOSED : IoStatus::FAILED, 0};
+    }
+
+    IoResult receivev(const IoVec* vecs, size_t count) override {
+        if (socket_ == INVALID_SOCKET) {
+            return {IoStatus::CLOSED, 0};
+        }
+
+        WSABUF buffers[MAX_IOV];
+        DWORD bufferCount = toWsaBuf(vecs, count, buffers);
+        DWORD received = 0;
+        DWORD flags = 0;
+        if (WSARecv(socket_, buffers, bufferCount, &received, &flags, nullptr, nullptr) == 0) {
+            if (received == 0) {
+                return {IoStatus::CLOSED, 0};
+            }
+            return {IoStatus::OK, static_cast<size_t>(received)};
+        }
+        int error = WSAGetLastError();
+        if (error == WSAEWOULDBLOCK) {
+            return {IoStatus::WOULD_BLOCK, 0};
+        }
+        return {error == WSAECONNRESET ? IoStatus::CLOSED : IoStatus::FAILED, 0};
+    }
+
+    bool waitReadable(int timeoutMs) override {
+        return socket_ != INVALID_SOCKET && waitSocket(socket_, false, timeoutMs);
+    }
+
+    bool waitWritable(int timeoutMs) override {
+        return socket_ != INVALID_SOCKET && waitSocket(socket_, true, timeoutMs);
+    }
+
+    // 没有 EPOLLRDHUP 的对应物：可读时窥探一个字节，读到 0 或出错说明对端已关闭
+    bool isPeerClosed() const override {
+        if (socket_ == INVALID_SOCKET || !waitSocket(socket_, false, 0)) {
+            return false;
+        }
+        char byte;
+        int peeked = recv(socket_, &byte, 1, MSG_PEEK);
+        return peeked == 0 || (peeked == SOCKET_ERROR && WSAGetLastError() != WSAEWOULDBLOCK);
+    }
+
+    void close() override {
+        if (socket_ != INVALID_SOCKET) {
+            closesocket(socket_);
+            socket_ = INVALID_SOCKET;
+        }
+    }
+
+    bool isOpen() const override {
+        return socket_ != INVALID_SOCKET;
+    }
+
+private:
+    static DWORD toWsaBuf(const IoVec* vecs, size_t count, WSABUF* buffers) {
+        count = count < MAX_IOV ? count : MAX_IOV;
+        for (size_t i = 0; i < count; i++) {
+            buffers[i].buf = (char*)vecs[i].base;
+            buffers[i].len = (ULONG)vecs[i].length;
+        }
+        return (DWORD)count;
+    }
+
+    SOCKET socket_;
+};
+
+} // namespace
+
+WinsockBackend::WinsockBackend() {
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        throw std::runtime_error("WSAStartup failed");
+    }
+}
+
+WinsockBackend::~WinsockBackend() {
+    WSACleanup();
+}
+
+std::unique_ptr<TransportSocket> WinsockBackend::createSocket() {
+    return std::unique_ptr<TransportSocket>(new WinsockSocket());
+}
+
+const char* WinsockBackend::name() const {
+    return "winsock";
+}
@@ -0,0 +1,123 @@
+// FrameDecoder 的解析与重组上限测试
+#include "Framing.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition)                                                          \
+    do {                                                                          \
+        if (!(condition)) {                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, \
+                         #condition);                                             \
+            failures++;                                                           \
+        }                                                                         \
+    } while (0)
+
+void appendFrame(std::vector<uint8_t>& out, const std::vector<uint8_t>& payload, uint16_t flags,
+                 uint16_t streamId = 0) {
+    FrameHeader header = FrameHeader::forPayload(payload.data(), payload.size(), flags, streamId);
+    size_t offset = out.size();
+    out.resize(offset + FrameHeader::SIZE);
+    header.encode(out.data() + offset);
+    out.insert(out.end(), payload.begin(), payload.end());
+}
+
+// 按 recv 的方式把字节交给解析器，任一次 commitRead 失败即返回 false
+bool feed(FrameDecoder& decoder, const std::vector<uint8_t>& bytes) {
+    size_t offset = 0;
+    while (offset < bytes.size()) {
+        TransportSocket::IoVec vecs[3];
+        size_t count = decoder.prepareRead(vecs, 3);
+        size_t copied = 0;
+        for (size_t i = 0; i < count && offset < bytes.size(); i++) {
+            size_t length = std::min(vecs[i].length, bytes.size() - offset);
+            std::memcpy(vecs[i].base, bytes.data() + offset, length);
+            offset += length;
+            copied += length;
+            if (length < vecs[i].length) {
+                break;
+            }
+        }
+        if (!decoder.commitRead(copied)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void testReassembly() {
+    FrameDecoder decoder;
+    std::vector<uint8_t> bytes;
+    appendFrame(bytes, std::vector<uint8_t>(1000, 'a'), 0);
+    appendFrame(bytes, std::vector<uint8_t>(40000, 'b'), 0);
+    appendFrame(bytes, std::vector<uint8_t>(10, 'c'), FrameHeader::FLAG_END_OF_MESSAGE);
+    appendFrame(bytes, std::vector<uint8_t>(5, 'd'), FrameHeader::FLAG_END_OF_MESSAGE, 7);
+    CHECK(feed(decoder, bytes));
+
+    Buffer message = decoder.popMessage(0);
+    CHECK(message.size() == 41010);
+    CHECK(message.data()[0] == 'a' && message.data()[1000] == 'b' && message.data()[41009] == 'c');
+    CHECK(decoder.popMessage(7).size() == 5);
+    CHECK(!decoder.hasMessage(0));
+}
+
+void testOversizedMessage() {
+    FrameDecoder decoder;
+    decoder.setLimits(64 * 1024, FrameDecoder::DEFAULT_MAX_PARTIAL_STREAMS);
+
+    // 每帧都在 MAX_PAYLOAD 之内，但不带结束标志的帧一直续接，累计超过消息上限
+    std::vector<uint8_t> bytes;
+    for (int i = 0; i < 8; i++) {
+        appendFrame(bytes, std::vector<uint8_t>(16 * 1024, 'x'), 0);
+    }
+    CHECK(!feed(decoder, bytes));
+
+    // 恰好等于上限的消息可以收下
+    decoder.reset();
+    bytes.clear();
+    for (int i = 0; i < 3; i++) {
+        appendFrame(bytes, std::vector<uint8_t>(16 * 1024, 'x'), 0);
+    }
+    appendFrame(bytes, std::vector<uint8_t>(16 * 1024, 'x'), FrameHeader::FLAG_END_OF_MESSAGE);
+    CHECK(feed(decoder, bytes));
+    CHECK(decoder.popMessage(0).size() == 64 * 1024);
+}
+
+void testPartialStreams() {
+    FrameDecoder decoder;
+    decoder.setLimits(FrameDecoder::DEFAULT_MAX_MESSAGE_SIZE, 4);
+
+    std::vector<uint8_t> bytes;
+    for (uint16_t stream = 0; stream < 4; stream++) {
+        appendFrame(bytes, std::vector<uint8_t>(100, 'p'), 0, stream);
+    }
+    // 已在重组中的流继续收帧、完成后释放名额
+    appendFrame(bytes, std::vector<uint8_t>(100, 'p'), FrameHeader::FLAG_END_OF_MESSAGE, 0);
+    appendFrame(bytes, std::vector<uint8_t>(100, 'p'), 0, 4);
+    CHECK(feed(decoder, bytes));
+    CHECK(decoder.popMessage(0).size() == 200);
+
+    // 第 5 个同时重组的流超出上限
+    bytes.clear();
+    appendFrame(bytes, std::vector<uint8_t>(100, 'p'), 0, 5);
+    CHECK(!feed(decoder, bytes));
+}
+
+} // namespace
+
+int main() {
+    testReassembly();
+    testOversizedMessage();
+    testPartialStreams();
+    if (failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("all framing tests passed\n");
+    return 0;
+}
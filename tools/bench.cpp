@@ -0,0 +1,692 @@
+// 基准测试：分块、校验和、压缩与负载均衡的微基准，以及回环上 Protocol 收发的宏基准，结果以 JSON 输出，
+// 便于比较不同版本之间的回归。进度信息写到 stderr
+// 用法示例：
+//   bench --output results.json
+//   bench --filter load_balancer --max-threads 8
+//   bench --quick
+#include "Compression.h"
+#include "LoadBalancer.h"
+#include "Metrics.h"
+#include "Protocol.h"
+#include "SocketBackend.h"
+#include "TcpChunkOptimization.h"
+#include "Utils.h"
+#if defined(__linux__)
+#include "ProtocolServer.h"
+#include "UdpBackend.h"
+#endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::string filter;
+    double minSeconds = 0.2;
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    size_t maxNodes = 100000;
+    uint64_t messages = 200000;
+    std::string output;
+};
+
+// 一项结果：名称、参数与测得的数值，按添加顺序输出
+struct Result {
+    std::string name;
+    std::vector<std::pair<std::string, std::string>> params;
+    std::vector<std::pair<std::string, double>> values;
+};
+
+void usage(const char* program) {
+    std::printf(
+        "Usage: %s [options]\n"
+        "  --filter TEXT         run only benchmarks whose name contains TEXT\n"
+        "  --min-time MS         minimum measuring time per micro benchmark (default 200)\n"
+        "  --max-threads N       largest thread count for load balancer runs (default: CPUs)\n"
+        "  --max-nodes N         largest node count for load balancer runs (default 100000)\n"
+        "  --messages N          messages per loopback run (default 200000)\n"
+        "  --quick               shorter runs: --min-time 20 --max-nodes 10000 --messages 20000\n"
+        "  --output FILE         write JSON to FILE instead of stdout\n",
+        program);
+}
+
+double now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// 阻止编译器把被测代码当作无用代码删除
+template <typename T>
+void keep(const T& value) {
+#if defined(_MSC_VER)
+    static volatile const void* sink;
+    sink = &value;
+#else
+    asm volatile("" : : "g"(&value) : "memory");
+#endif
+}
+
+bool selected(const Options& options, const std::string& name) {
+    return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+// threads 个线程同时循环执行 op(thread)，至少持续 minSeconds；返回总操作数与实际耗时
+template <typename Op>
+std::pair<uint64_t, double> runTimed(unsigned threads, double minSeconds, Op op) {
+    std::atomic<bool> start{false};
+    std::atomic<bool> stop{false};
+    std::atomic<unsigned> ready{0};
+    std::vector<uint64_t> counts(threads, 0);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            ready++;
+            while (!start.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            uint64_t count = 0;
+            // 每 64 次检查一次是否结束，检查本身不影响短操作的计时
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (int i = 0; i < 64; i++) {
+                    op(t);
+                }
+                count += 64;
+            }
+            counts[t] = count;
+        });
+    }
+    while (ready.load() < threads) {
+        std::this_thread::yield();
+    }
+    double begin = now();
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::duration<double>(minSeconds));
+    stop.store(true);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double elapsed = now() - begin;
+    uint64_t total = 0;
+    for (uint64_t count : counts) {
+        total += count;
+    }
+    return {total, elapsed};
+}
+
+// 单线程微基准：ns/op、ops/s，给出 bytesPerOp 时还有吞吐
+template <typename Op>
+Result micro(const Options& options, const std::string& name, size_t bytesPerOp, Op op) {
+    op(0);  // 预热，同时构建惰性初始化的结构
+    auto measured = runTimed(1, options.minSeconds, op);
+    Result result;
+    result.name = name;
+    double seconds = measured.second;
+    double ops = static_cast<double>(measured.first);
+    result.values.push_back({"iterations", ops});
+    result.values.push_back({"ns_per_op", seconds * 1e9 / ops});
+    result.values.push_back({"ops_per_sec", ops / seconds});
+    if (bytesPerOp > 0) {
+        result.values.push_back({"gb_per_sec", ops * bytesPerOp / seconds / 1e9});
+    }
+    return result;
+}
+
+void report(std::vector<Result>& results, Result result) {
+    std::fprintf(stderr, "%-60s", result.name.c_str());
+    for (const auto& value : result.values) {
+        if (value.first != "iterations") {
+            std::fprintf(stderr, " %s=%.4g", value.first.c_str(), value.second);
+        }
+    }
+    std::fprintf(stderr, "\n");
+    results.push_back(std::move(result));
+}
+
+std::vector<uint8_t> randomBytes(size_t size) {
+    std::vector<uint8_t> data(size);
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+    for (auto& byte : data) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        byte = static_cast<uint8_t>(state >> 56);
+    }
+    return data;
+}
+
+void benchChunking(const Options& options, std::vector<Result>& results) {
+    for (size_t size : {4096u, 65536u, 1048576u}) {
+        std::vector<uint8_t> data = randomBytes(size);
+        TcpChunkOptimization optimizer;
+        std::string suffix = "/size=" + std::to_string(size);
+
+        std::string name = "chunking/chunk_data" + suffix;
+        if (selected(options, name)) {
+            report(results, micro(options, name, size, [&](unsigned) { keep(optimizer.chunkData(data)); }));
+        }
+
+        std::vector<std::vector<uint8_t>> chunks = optimizer.chunkData(data);
+        name = "chunking/merge_chunks" + suffix;
+        if (selected(options, name)) {
+            report(results, micro(options, name, size, [&](unsigned) { keep(optimizer.mergeChunks(chunks)); }));
+        }
+    }
+}
+
+void benchChecksum(const Options& options, std::vector<Result>& results) {
+    for (size_t size : {64u, 1024u, 16384u, 1048576u}) {
+        std::string name = "checksum/size=" + std::to_string(size);
+        if (!selected(options, name)) {
+            continue;
+        }
+        std::vector<uint8_t> data = randomBytes(size);
+        report(results, micro(options, name, size, [&](unsigned) {
+            keep(NetworkUtils::calculateChecksum(data.data(), data.size()));
+        }));
+    }
+}
+
+// 类似日志的 JSON 行，压缩率与实际负载相近
+std::vector<uint8_t> jsonBytes(size_t size) {
+    std::string text;
+    uint64_t state = 0x2545f4914f6cdd1dULL;
+    while (text.size() < size) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        text += "{\"ts\":" + std::to_string(state >> 40) + ",\"level\":\"info\",\"path\":\"/api/v1/items/" +
+                std::to_string((state >> 20) % 1000) + "\",\"status\":200}\n";
+    }
+    return std::vector<uint8_t>(text.begin(), text.begin() + size);
+}
+
+// 压缩与解压：可压缩的 JSON 以及不可压缩的随机数据（后者主要看放弃得有多快）
+void benchCompression(const Options& options, std::vector<Result>& results) {
+    for (const char* kind : {"json", "random"}) {
+        size_t size = 65536;
+        std::vector<uint8_t> data = std::string(kind) == "json" ? jsonBytes(size) : randomBytes(size);
+        std::vector<uint8_t> compressed(Lz4Codec::compressBound(size));
+        std::vector<uint8_t> restored(size);
+        std::string suffix = std::string("/") + kind + "/size=" + std::to_string(size);
+
+        std::string name = "compression/compress" + suffix;
+        if (selected(options, name)) {
+            Result result = micro(options, name, size, [&](unsigned) {
+                keep(Lz4Codec::compress(data.data(), size, compressed.data(), compressed.size()));
+            });
+            size_t length = Lz4Codec::compress(data.data(), size, compressed.data(), compressed.size());
+            result.values.push_back({"ratio", static_cast<double>(size) / length});
+            report(results, std::move(result));
+        }
+        name = "compression/decompress" + suffix;
+        size_t length = Lz4Codec::compress(data.data(), size, compressed.data(), compressed.size());
+        if (selected(options, name)) {
+            report(results, micro(options, name, size, [&](unsigned) {
+                keep(Lz4Codec::decompress(compressed.data(), length, restored.data(), size));
+            }));
+        }
+    }
+}
+
+struct StrategyInfo {
+    const char* name;
+    LoadBalancer::Strategy strategy;
+    bool keyed;
+};
+
+const StrategyInfo STRATEGIES[] = {
+    {"round_robin", LoadBalancer::Strategy::ROUND_ROBIN, false},
+    {"weighted_round_robin", LoadBalancer::Strategy::WEIGHTED_ROUND_ROBIN, false},
+    {"least_connections", LoadBalancer::Strategy::LEAST_CONNECTIONS, false},
+    {"random", LoadBalancer::Strategy::RANDOM, false},
+    {"weighted_random", LoadBalancer::Strategy::WEIGHTED_RANDOM, false},
+    {"consistent_hash", LoadBalancer::Strategy::CONSISTENT_HASH, true},
+    {"maglev", LoadBalancer::Strategy::MAGLEV, true},
+    {"power_of_two_choices", LoadBalancer::Strategy::POWER_OF_TWO_CHOICES, false},
+    {"peak_ewma", LoadBalancer::Strategy::PEAK_EWMA, false},
+};
+
+void benchLoadBalancer(const Options& options, std::vector<Result>& results) {
+    std::vector<unsigned> threadCounts;
+    for (unsigned threads = 1; threads < options.maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(options.maxThreads);
+
+    // 按 key 选择的策略轮流使用预先生成的 key，计时中不构造字符串
+    std::vector<std::string> keys;
+    for (int i = 0; i < 4096; i++) {
+        keys.push_back("session-" + std::to_string(i * 7919));
+    }
+
+    for (size_t nodeCount = 10; nodeCount <= options.maxNodes; nodeCount *= 10) {
+        std::vector<LoadBalancer::NodeSpec> specs;
+        specs.reserve(nodeCount);
+        for (size_t i = 0; i < nodeCount; i++) {
+            std::string address = "10." + std::to_string((i >> 16) & 0xff) + "." + std::to_string((i >> 8) & 0xff) +
+                                  "." + std::to_string(i & 0xff);
+            specs.push_back({address, 8080, static_cast<uint32_t>(1 + i % 4)});
+        }
+
+        for (const StrategyInfo& info : STRATEGIES) {
+            std::string prefix = std::string("load_balancer/") + info.name + "/nodes=" + std::to_string(nodeCount);
+            std::vector<unsigned> wanted;
+            for (unsigned threads : threadCounts) {
+                if (selected(options, prefix + "/threads=" + std::to_string(threads))) {
+                    wanted.push_back(threads);
+                }
+            }
+            if (wanted.empty()) {
+                continue;
+            }
+            LoadBalancer balancer;
+            balancer.addNodes(specs);
+
+            // 切换策略时发布带有加权结构的快照，构建耗时记在这里
+            double setupStart = now();
+            balancer.setStrategy(info.strategy);
+            double setupSeconds = now() - setupStart;
+
+            std::vector<size_t> cursors(options.maxThreads, 0);
+            for (unsigned threads : wanted) {
+                std::string name = prefix + "/threads=" + std::to_string(threads);
+                auto measured = runTimed(threads, options.minSeconds, [&](unsigned t) {
+                    if (info.keyed) {
+                        size_t& cursor = cursors[t];
+                        keep(balancer.getNextNode(keys[cursor++ % keys.size()]));
+                    } else {
+                        keep(balancer.getNextNode());
+                    }
+                });
+                Result result;
+                result.name = name;
+                result.params = {{"strategy", info.name}};
+                double ops = static_cast<double>(measured.first);
+                result.values.push_back({"nodes", static_cast<double>(nodeCount)});
+                result.values.push_back({"threads", static_cast<double>(threads)});
+                result.values.push_back({"iterations", ops});
+                // 每个线程看到的单次耗时
+                result.values.push_back({"ns_per_op", measured.second * threads * 1e9 / ops});
+                result.values.push_back({"ops_per_sec", ops / measured.second});
+                result.values.push_back({"build_ms", setupSeconds * 1e3});
+                report(results, std::move(result));
+            }
+        }
+    }
+}
+
+#if defined(__linux__)
+
+// 等待计数归零/达到目标的简单信号量
+class Counter {
+public:
+    void add(int64_t delta) {
+        std::lock_guard<std::mutex> lock(mutex);
+        value += delta;
+        cond.notify_all();
+    }
+
+    void waitBelow(int64_t limit) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&] { return value < limit; });
+    }
+
+    void waitFor(int64_t target) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&] { return value >= target; });
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable cond;
+    int64_t value = 0;
+};
+
+void addLatency(Result& result, const LatencyHistogram& latency) {
+    result.values.push_back({"latency_p50_us", static_cast<double>(latency.percentile(50))});
+    result.values.push_back({"latency_p99_us", static_cast<double>(latency.percentile(99))});
+    result.values.push_back({"latency_p999_us", static_cast<double>(latency.percentile(99.9))});
+    result.values.push_back({"latency_max_us", static_cast<double>(latency.max())});
+}
+
+// 回环用例的传输方式：默认后端、io_uring（不支持时退回 epoll）和可靠 UDP
+enum class Transport { DEFAULT, IO_URING, UDP };
+
+// 客户端连接使用的后端：io_uring 与可靠 UDP 每次新建，否则为默认后端
+std::shared_ptr<SocketBackend> clientBackend(Transport transport) {
+    switch (transport) {
+    case Transport::IO_URING:
+        return SocketBackend::createPreferred();
+    case Transport::UDP:
+        return std::make_shared<UdpBackend>();
+    default:
+        return SocketBackend::getDefault();
+    }
+}
+
+// 进程内服务端的配置，与客户端使用同一种传输
+ProtocolServer::Config serverConfig(Transport transport) {
+    ProtocolServer::Config config;
+    config.threads = 1;
+    config.reliableUdp = transport == Transport::UDP;
+    if (transport == Transport::IO_URING) {
+        config.backendFactory = [](const std::shared_ptr<EventLoop>& loop) {
+            return SocketBackend::createPreferred(loop);
+        };
+    }
+    return config;
+}
+
+// 单向流：客户端异步发送，进程内的服务端只接收；每条消息的前 8 字节是发送时刻，服务端据此记录单向延迟
+Result loopbackThroughput(size_t size, uint64_t messages, Transport transport) {
+    LatencyHistogram latency;
+    Counter received;
+    std::function<void(const std::shared_ptr<Protocol>&)> sink;
+    sink = [&](const std::shared_ptr<Protocol>& connection) {
+        std::weak_ptr<Protocol> weak = connection;
+        connection->receiveBufferAsync([&, weak](bool ok, Buffer message) {
+            auto connection = weak.lock();
+            if (!ok || !connection) {
+                return;
+            }
+            int64_t sent;
+            std::memcpy(&sent, message.data(), sizeof(sent));
+            latency.record(static_cast<uint64_t>(nowMicros() - sent));
+            message.reset();
+            sink(connection);
+            received.add(1);
+        });
+    };
+
+    ProtocolServer::Config config = serverConfig(transport);
+    ProtocolServer server(config, sink);
+    Result result;
+    if (!server.start("127.0.0.1", 0)) {
+        return result;
+    }
+    // 回调引用的局部变量声明在客户端之前，客户端析构（关闭连接、失败剩余操作）时它们仍然有效
+    Counter inFlight;
+    auto backend = clientBackend(transport);
+    // 记录实际使用的后端，io_uring 不可用时为 epoll
+    result.params = {{"backend", backend->name()}};
+    Protocol client(backend);
+    if (!client.initializeConnection("127.0.0.1", server.port())) {
+        return result;
+    }
+
+    // 在途的消息不超过约 32MB，发送方不会无限制地排队
+    int64_t window = static_cast<int64_t>(std::max<size_t>(2, std::min<size_t>(1024, (32u << 20) / size)));
+    auto pool = client.bufferPool();
+    double begin = now();
+    for (uint64_t i = 0; i < messages; i++) {
+        inFlight.waitBelow(window);
+        inFlight.add(1);
+        Buffer buffer = pool->acquire(size);
+        buffer.resize(size);
+        int64_t sent = nowMicros();
+        std::memcpy(buffer.data(), &sent, sizeof(sent));
+        client.sendAsync(std::move(buffer), [&](bool) { inFlight.add(-1); });
+    }
+    received.waitFor(static_cast<int64_t>(messages));
+    double elapsed = now() - begin;
+    inFlight.waitBelow(1);
+    client.closeConnection();
+    server.stop();
+
+    result.values.push_back({"messages", static_cast<double>(messages)});
+    result.values.push_back({"msgs_per_sec", messages / elapsed});
+    result.values.push_back({"gb_per_sec", messages * static_cast<double>(size) / elapsed / 1e9});
+    addLatency(result, latency);
+    return result;
+}
+
+// 请求/响应：服务端原样回显，客户端保持 depth 个请求在途，记录往返延迟
+Result loopbackRequestResponse(size_t size, unsigned depth, uint64_t messages, Transport transport) {
+    std::function<void(const std::shared_ptr<Protocol>&)> echo;
+    echo = [&](const std::shared_ptr<Protocol>& connection) {
+        std::weak_ptr<Protocol> weak = connection;
+        connection->receiveBufferAsync([&, weak](bool ok, Buffer message) {
+            auto connection = weak.lock();
+            if (!ok || !connection) {
+                return;
+            }
+            connection->sendAsync(std::move(message), [](bool) {});
+            echo(connection);
+        });
+    };
+
+    ProtocolServer::Config config = serverConfig(transport);
+    ProtocolServer server(config, echo);
+    Result result;
+    if (!server.start("127.0.0.1", 0)) {
+        return result;
+    }
+    // 回调引用的局部变量声明在客户端之前，客户端析构（关闭连接、失败剩余请求）时它们仍然有效
+    std::mutex latencyMutex;
+    LatencyHistogram latency;
+    Counter completed;
+    std::atomic<uint64_t> issued{0};
+    std::string request(size, 'r');
+    std::function<void()> issue;
+    auto backend = clientBackend(transport);
+    // 记录实际使用的后端，io_uring 不可用时为 epoll
+    result.params = {{"backend", backend->name()}};
+    Protocol client(backend);
+    if (!client.initializeConnection("127.0.0.1", server.port())) {
+        return result;
+    }
+
+    issue = [&] {
+        if (issued.fetch_add(1) >= messages) {
+            return;
+        }
+        int64_t start = nowMicros();
+        client.requestAsync(request, [&, start](bool ok, std::string) {
+            {
+                std::lock_guard<std::mutex> lock(latencyMutex);
+                latency.record(static_cast<uint64_t>(nowMicros() - start));
+            }
+            // 先发出下一个请求再计数：计数达到总数后主线程随即返回，回调不能再使用这些局部变量
+            if (ok) {
+                issue();
+            }
+            completed.add(1);
+        });
+    };
+
+    double begin = now();
+    for (unsigned i = 0; i < depth; i++) {
+        issue();
+    }
+    completed.waitFor(static_cast<int64_t>(messages));
+    double elapsed = now() - begin;
+    client.closeConnection();
+    server.stop();
+
+    result.values.push_back({"messages", static_cast<double>(messages)});
+    result.values.push_back({"msgs_per_sec", messages / elapsed});
+    result.values.push_back({"gb_per_sec", messages * 2.0 * size / elapsed / 1e9});
+    addLatency(result, latency);
+    return result;
+}
+
+// 同一组用例分别跑在默认的 TCP 后端、io_uring 和可靠 UDP 上，后两者的名字带 loopback/uring、loopback/udp 前缀
+void benchLoopback(const Options& options, std::vector<Result>& results) {
+    for (Transport transport : {Transport::DEFAULT, Transport::IO_URING, Transport::UDP}) {
+        std::string prefix = transport == Transport::IO_URING ? "loopback/uring/"
+                             : transport == Transport::UDP    ? "loopback/udp/"
+                                                              : "loopback/";
+        for (size_t size : {64u, 1024u, 65536u, 1048576u}) {
+            std::string name = prefix + "throughput/size=" + std::to_string(size);
+            if (!selected(options, name)) {
+                continue;
+            }
+            // 大消息按总量约 1GB 截断
+            uint64_t messages = std::max<uint64_t>(1000, std::min<uint64_t>(options.messages, (1ull << 30) / size));
+            Result result = loopbackThroughput(size, messages, transport);
+            result.name = name;
+            report(results, std::move(result));
+        }
+        for (size_t size : {64u, 4096u}) {
+            for (unsigned depth : {1u, 32u}) {
+                std::string name = prefix + "request_response/size=" + std::to_string(size) +
+                                   "/depth=" + std::to_string(depth);
+                if (!selected(options, name)) {
+                    continue;
+                }
+                uint64_t messages = depth == 1 ? std::max<uint64_t>(1000, options.messages / 10) : options.messages;
+                Result result = loopbackRequestResponse(size, depth, messages, transport);
+                result.name = name;
+                report(results, std::move(result));
+            }
+        }
+    }
+}
+
+#endif
+
+std::string jsonString(const std::string& value) {
+    std::string out = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+std::string jsonNumber(double value) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.6g", value);
+    return text;
+}
+
+std::string toJson(const Options& options, const std::vector<Result>& results) {
+    char timestamp[32];
+    std::time_t t = std::time(nullptr);
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&t));
+
+#if defined(__clang__)
+    std::string compiler = std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+    std::string compiler = std::string("gcc ") + __VERSION__;
+#elif defined(_MSC_VER)
+    std::string compiler = "msvc " + std::to_string(_MSC_VER);
+#else
+    std::string compiler = "unknown";
+#endif
+#if defined(BENCH_BUILD_TYPE)
+    std::string buildType = BENCH_BUILD_TYPE;
+#else
+    std::string buildType = "unknown";
+#endif
+
+    std::string out = "{\n";
+    out += "  \"schema\": 1,\n";
+    out += "  \"timestamp\": " + jsonString(timestamp) + ",\n";
+    out += "  \"build\": {\"compiler\": " + jsonString(compiler) + ", \"build_type\": " + jsonString(buildType) + "},\n";
+    out += "  \"system\": {\"hardware_threads\": " + std::to_string(std::thread::hardware_concurrency()) +
+           ", \"crc32c_hardware\": " + (NetworkUtils::isCrc32cHardwareAccelerated() ? "true" : "false") +
+           ", \"lz4_library\": " + (Lz4Codec::isLibraryAvailable() ? "true" : "false") +
+           ", \"socket_backend\": " + jsonString(SocketBackend::getDefault()->name()) + "},\n";
+    out += "  \"config\": {\"min_time_ms\": " + jsonNumber(options.minSeconds * 1e3) +
+           ", \"max_threads\": " + std::to_string(options.maxThreads) +
+           ", \"max_nodes\": " + std::to_string(options.maxNodes) +
+           ", \"messages\": " + std::to_string(options.messages) + "},\n";
+    out += "  \"results\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& result = results[i];
+        out += i == 0 ? "\n" : ",\n";
+        out += "    {\"name\": " + jsonString(result.name);
+        for (const auto& param : result.params) {
+            out += ", " + jsonString(param.first) + ": " + jsonString(param.second);
+        }
+        for (const auto& value : result.values) {
+            out += ", " + jsonString(value.first) + ": " + jsonNumber(value.second);
+        }
+        out += "}";
+    }
+    out += "\n  ]\n}\n";
+    return out;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--help" || option == "-h") {
+            usage(argv[0]);
+            return 0;
+        }
+        if (option == "--quick") {
+            options.minSeconds = 0.02;
+            options.maxNodes = 10000;
+            options.messages = 20000;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::fprintf(stderr, "missing value for %s\n", option.c_str());
+            return 1;
+        }
+        const char* value = argv[++i];
+        if (option == "--filter") {
+            options.filter = value;
+        } else if (option == "--min-time") {
+            options.minSeconds = std::atof(value) / 1000;
+        } else if (option == "--max-threads") {
+            options.maxThreads = std::max(1u, static_cast<unsigned>(std::strtoul(value, nullptr, 10)));
+        } else if (option == "--max-nodes") {
+            options.maxNodes = std::strtoull(value, nullptr, 10);
+        } else if (option == "--messages") {
+            options.messages = std::max<uint64_t>(1, std::strtoull(value, nullptr, 10));
+        } else if (option == "--output") {
+            options.output = value;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<Result> results;
+    benchChunking(options, results);
+    benchChecksum(options, results);
+    benchCompression(options, results);
+    benchLoadBalancer(options, results);
+#if defined(__linux__)
+    benchLoopback(options, results);
+#endif
+
+    std::string json = toJson(options, results);
+    if (options.output.empty()) {
+        std::fwrite(json.data(), 1, json.size(), stdout);
+        return 0;
+    }
+    FILE* file = std::fopen(options.output.c_str(), "w");
+    if (!file) {
+        std::fprintf(stderr, "cannot open %s\n", options.output.c_str());
+        return 1;
+    }
+    std::fwrite(json.data(), 1, json.size(), file);
+    std::fclose(file);
+    return 0;
+}